@@ -102,25 +102,27 @@ end
 io.write("!* AUTO-GENERATED FROM SCITE PROPERTY SET *!\n\n")
 
 -- print [lexer.test...] macro
-local shbang = expand(props["shbang."..language])
-local file_patterns = expand(props["filter."..language]):match("^[^|]*|(.*)|$")
+-- NOTE: It tests the file type registrations below,
+-- so the patterns are not repeated.
 io.write([=[
 @[lexer.test.]=], language:lower(), [=[]{
+  @ET{lexer.set.]=], language:lower(), [=[}{}
+}
+
 ]=])
-if shbang then io.write([=[  _#!M]=], shbang, [=[:M[lexer.checkheader]"S -1 '
-]=]) end
-local patterns = {}
-for pattern in file_patterns:gmatch("[^;]+") do
-	table.insert(patterns, pattern)
-end
-for i, pattern in ipairs(patterns) do
-	io.write([=[  :EN]=], pattern, [=[Q*]=])
-	if i ~= #patterns then io.write([=["S -1 ']=]) end
-	io.write("\n")
-end
-io.write([=[}
 
+-- register file types for [lexer.auto]
+local shbang = expand(props["shbang."..language])
+local file_patterns = expand(props["filter."..language]):match("^[^|]*|(.*)|$")
+if shbang then
+	io.write([=[:@ET{lexer.set.]=], language:lower(), [=[}{#!M]=], shbang, [=[}
+]=])
+end
+for pattern in file_patterns:gmatch("[^;]+") do
+	io.write([=[@ET{lexer.set.]=], language:lower(), [=[}{]=], pattern, [=[}
 ]=])
+end
+io.write("\n")
 
 -- print [lexer.set...] macro
 -- NOTE: The lexer encoded in the property file is not
@@ -47,6 +47,7 @@
 #include "goto.h"
 #include "help.h"
 #include "undo.h"
+#include "memory.h"
 #include "symbols.h"
 #include "spawn.h"
 #include "eol.h"
@@ -67,23 +68,89 @@ teco_cmdline_t teco_cmdline = {};
 static teco_string_t teco_last_cmdline = {NULL, 0};
 
 /**
- * Insert string into command line and execute
- * it immediately.
- * It already handles command line replacement (TECO_ERROR_CMDLINE).
+ * Stretch of the command line inserted by teco_cmdline_insert_plain().
+ */
+typedef struct {
+	gsize start, end;
+} teco_cmdline_run_t;
+
+/**
+ * Plain runs on the effective command line, ordered by position.
+ * They are required to rub out single characters of a run.
+ */
+static GArray *teco_cmdline_runs;
+
+static void __attribute__((constructor))
+teco_cmdline_runs_init(void)
+{
+	teco_cmdline_runs = g_array_new(FALSE, FALSE, sizeof(teco_cmdline_run_t));
+}
+
+/**
+ * Pop all undo tokens of command line characters starting at `pc`.
  *
- * @param data String to insert.
- * @param len Length of string to insert.
- * @param error A GError.
- * @return FALSE to throw a GError
+ * Plain runs have undo tokens only at their first character.
+ * If a run is rubbed out partially, the string argument is
+ * truncated directly instead.
+ * This works since every character of a run appends exactly as many
+ * bytes to the string argument as it occupies on the command line.
+ * Interactive feedback is always refreshed at the end of the command
+ * line, so its undo tokens have already been popped.
+ * If the run has already been processed by the current state
+ * (see teco_cmdline_insert_plain()), the processing is reverted
+ * in place as well, so rubouts do not depend on the size of the run.
+ *
+ * @param pc Command line position to rub out from.
  */
-static gboolean
-teco_cmdline_insert(const gchar *data, gsize len, GError **error)
+static void
+teco_cmdline_undo_pop(gsize pc)
 {
-	const teco_string_t src = {(gchar *)data, len};
-	g_auto(teco_string_t) old_cmdline = {NULL, 0};
-	gsize repl_pc = 0;
+	teco_undo_pop(pc);
 
-	teco_cmdline.machine.macro_pc = teco_cmdline.pc = teco_cmdline.effective_len;
+	while (teco_cmdline_runs->len > 0) {
+		teco_cmdline_run_t *run = &g_array_index(teco_cmdline_runs, teco_cmdline_run_t,
+		                                         teco_cmdline_runs->len-1);
+		if (run->end <= pc)
+			break;
+		if (run->start >= pc) {
+			/* already reverted by its undo tokens */
+			g_array_set_size(teco_cmdline_runs, teco_cmdline_runs->len-1);
+			continue;
+		}
+
+		teco_machine_main_t *machine = &teco_cmdline.machine;
+		gsize removed = run->end - pc;
+		g_assert(machine->expectstring.string.len >= removed);
+		teco_string_truncate(&machine->expectstring.string,
+		                     machine->expectstring.string.len - removed);
+
+		if (removed > machine->expectstring.insert_len) {
+			g_assert(machine->parent.current->expectstring.truncate_cb != NULL);
+			/* undo tokens must still be attributed to the run */
+			gsize pc_saved = teco_cmdline.pc;
+			teco_cmdline.pc = run->start;
+			machine->parent.current->expectstring.truncate_cb(machine,
+			                                                  removed - machine->expectstring.insert_len);
+			teco_cmdline.pc = pc_saved;
+			removed = machine->expectstring.insert_len;
+		}
+		machine->expectstring.insert_len -= removed;
+
+		run->end = pc;
+		break;
+	}
+}
+
+/**
+ * Append string to the effective command line.
+ *
+ * If it equals the rubbed out command line, the rubbed out
+ * part is reused.
+ */
+static void
+teco_cmdline_append(const gchar *data, gsize len)
+{
+	const teco_string_t src = {(gchar *)data, len};
 
 	if (len <= teco_cmdline.str.len - teco_cmdline.effective_len &&
 	    !teco_string_cmp(&src, teco_cmdline.str.data + teco_cmdline.effective_len, len)) {
@@ -100,6 +167,26 @@ teco_cmdline_insert(const gchar *data, gsize len, GError **error)
 		teco_string_append(&teco_cmdline.str, data, len);
 		teco_cmdline.effective_len = teco_cmdline.str.len;
 	}
+}
+
+/**
+ * Insert string into command line and execute
+ * it immediately.
+ * It already handles command line replacement (TECO_ERROR_CMDLINE).
+ *
+ * @param data String to insert.
+ * @param len Length of string to insert.
+ * @param error A GError.
+ * @return FALSE to throw a GError
+ */
+static gboolean
+teco_cmdline_insert(const gchar *data, gsize len, GError **error)
+{
+	g_auto(teco_string_t) old_cmdline = {NULL, 0};
+	gsize repl_pc = 0;
+
+	teco_cmdline.machine.macro_pc = teco_cmdline.pc = teco_cmdline.effective_len;
+	teco_cmdline_append(data, len);
 
 	/*
 	 * Parse/execute characters, one at a time so
@@ -129,7 +216,7 @@ teco_cmdline_insert(const gchar *data, gsize len, GError **error)
 				 */
 				teco_cmdline.pc = teco_string_diff(&teco_cmdline.str, new_cmdline.data, new_cmdline.len);
 
-				teco_undo_pop(teco_cmdline.pc);
+				teco_cmdline_undo_pop(teco_cmdline.pc);
 
 				g_assert(old_cmdline.len == 0);
 				old_cmdline = teco_cmdline.str;
@@ -150,7 +237,7 @@ teco_cmdline_insert(const gchar *data, gsize len, GError **error)
 					 * Replay previous command-line.
 					 * This avoids deep copying.
 					 */
-					teco_undo_pop(repl_pc);
+					teco_cmdline_undo_pop(repl_pc);
 
 					teco_string_clear(&teco_cmdline.str);
 					teco_cmdline.str = old_cmdline;
@@ -174,6 +261,153 @@ teco_cmdline_insert(const gchar *data, gsize len, GError **error)
 	return TRUE;
 }
 
+/**
+ * Get the length of the run of plain characters at the beginning of `data`.
+ *
+ * Plain characters can be inserted into the current string argument
+ * by teco_cmdline_insert_plain().
+ * They have no special meaning as immediate editing commands,
+ * string building characters or string terminators and
+ * append exactly their own number of bytes to the string argument.
+ *
+ * @param data Characters to insert (validated UTF-8).
+ * @param len Length of data in bytes.
+ * @return Length of the run in bytes or 0.
+ */
+static gsize
+teco_cmdline_plain_run(const gchar *data, gsize len)
+{
+	teco_machine_main_t *machine = &teco_cmdline.machine;
+	teco_machine_stringbuilding_t *stringbuilding = &machine->expectstring.machine;
+	teco_state_t *current = machine->parent.current;
+
+	if (current->refresh_cb != (teco_state_refresh_cb_t)teco_state_expectstring_refresh ||
+	    machine->flags.mode != TECO_MODE_NORMAL || machine->flags.modifier_at ||
+	    !stringbuilding->parent.current->is_start)
+		return 0;
+
+	/* case folding non-ANSI characters might change their length */
+	gboolean ansi_only = current->expectstring.string_building &&
+	                     (stringbuilding->mode == TECO_STRINGBUILDING_MODE_UPPER ||
+	                      stringbuilding->mode == TECO_STRINGBUILDING_MODE_LOWER);
+
+	gsize i = 0;
+	while (i < len) {
+		gunichar chr = g_utf8_get_char(data+i);
+
+		if (TECO_IS_CTL(chr) || chr == 0x7F || chr == '^' ||
+		    chr == '{' || chr == '}' ||
+		    g_unichar_toupper(chr) == stringbuilding->escape_char ||
+		    (ansi_only && chr >= 0x80))
+			break;
+
+		i = g_utf8_next_char(data+i) - data;
+	}
+
+	return i;
+}
+
+/**
+ * Insert a run of plain characters into the command line
+ * and the current string argument.
+ *
+ * This is equivalent to inserting the characters one by one,
+ * but undo tokens are emitted only for the first character,
+ * so large amounts of pasted text can be inserted efficiently.
+ * Interactive feedback is refreshed only once by the caller.
+ * If the current state can revert its processing in place
+ * (e.g. insertions), the run is processed right away,
+ * so that rubbing out single characters of the run does not
+ * require processing the remaining run again.
+ *
+ * @param data Characters to insert, as accepted by teco_cmdline_plain_run().
+ * @param len Length of data in bytes.
+ * @param error A GError.
+ * @return FALSE to throw a GError
+ */
+static gboolean
+teco_cmdline_insert_plain(const gchar *data, gsize len, GError **error)
+{
+	teco_machine_main_t *machine = &teco_cmdline.machine;
+	teco_machine_stringbuilding_t *stringbuilding = &machine->expectstring.machine;
+	teco_cmdline_run_t run = {.start = teco_cmdline.effective_len};
+	g_autoptr(GError) tmp_error = NULL;
+
+	teco_cmdline.pc = run.start;
+	teco_cmdline_append(data, len);
+	run.end = teco_cmdline.effective_len;
+
+	undo__teco_string_truncate(&machine->expectstring.string, machine->expectstring.string.len);
+	teco_undo_gsize(machine->expectstring.insert_len);
+
+	if (!machine->parent.current->expectstring.string_building ||
+	    (stringbuilding->mode != TECO_STRINGBUILDING_MODE_UPPER &&
+	     stringbuilding->mode != TECO_STRINGBUILDING_MODE_LOWER)) {
+		/* the characters are taken verbatim */
+		stringbuilding->result = &machine->expectstring.string;
+		teco_string_append(&machine->expectstring.string, data, len);
+		machine->expectstring.insert_len += len;
+		machine->macro_pc = run.end;
+	} else {
+		/*
+		 * Let the parser do the case folding.
+		 * Plain characters do not change any other state,
+		 * so there is nothing to undo.
+		 */
+		gboolean must_undo = machine->parent.must_undo;
+		machine->macro_pc = run.start;
+		machine->parent.must_undo = stringbuilding->parent.must_undo = FALSE;
+		gboolean rc = teco_machine_main_step(machine, teco_cmdline.str.data, run.end, &tmp_error);
+		machine->parent.must_undo = stringbuilding->parent.must_undo = must_undo;
+		if (!rc)
+			goto error;
+	}
+
+	if (machine->parent.current->expectstring.truncate_cb &&
+	    !machine->parent.current->refresh_cb(&machine->parent, &tmp_error))
+		goto error;
+
+	g_array_append_val(teco_cmdline_runs, run);
+	teco_cmdline.pc = run.end;
+
+	if (!teco_memory_check(0, &tmp_error))
+		goto error;
+	return TRUE;
+
+error:
+	/* see teco_cmdline_insert() */
+	teco_error_add_frame_toplevel();
+	teco_error_display_short(tmp_error);
+	g_propagate_error(error, g_steal_pointer(&tmp_error));
+	return FALSE;
+}
+
+/**
+ * Provide interactive feedback (e.g. incremental searches)
+ * at the end of the command line.
+ *
+ * This is done only once after processing key presses, so
+ * re-inserted or replaced parts of the command line are replayed
+ * without being processed character by character.
+ * Commands must cope with this anyway, since string arguments
+ * are processed all at once when executing macros.
+ *
+ * Undo tokens are attributed to the end of the command line,
+ * behind the last character.
+ * They are therefore popped by any rubout or insertion, so
+ * the feedback has to be refreshed after every key press,
+ * but they can also be popped on their own.
+ */
+static gboolean
+teco_cmdline_refresh(GError **error)
+{
+	if (!teco_cmdline.effective_len)
+		return TRUE;
+
+	teco_cmdline.machine.macro_pc = teco_cmdline.pc = teco_cmdline.effective_len;
+	return teco_machine_main_refresh(&teco_cmdline.machine, teco_cmdline.str.data, error);
+}
+
 static gboolean
 teco_cmdline_rubin(GError **error)
 {
@@ -187,23 +421,8 @@ teco_cmdline_rubin(GError **error)
 	return teco_cmdline_insert(start, next-start, error);
 }
 
-/**
- * Process key press or expansion of key macro.
- *
- * Should be called only with the results of a single keypress.
- * They are considered an unity and in case of errors, we
- * rubout the entire sequence (unless there was a $$ return in the
- * middle).
- *
- * @param data Key presses in UTF-8.
- * @param len Length of data.
- * @param error A GError.
- * @return FALSE if error was set.
- *   If TRUE was returned, there could still have been an error,
- *   but it has already been handled.
- */
-gboolean
-teco_cmdline_keypress(const gchar *data, gsize len, GError **error)
+static gboolean
+teco_cmdline_process(const gchar *data, gsize len, gboolean paste, GError **error)
 {
 	const teco_string_t str = {(gchar *)data, len};
 	teco_machine_t *machine = &teco_cmdline.machine.parent;
@@ -221,16 +440,29 @@ teco_cmdline_keypress(const gchar *data, gsize len, GError **error)
 
 	gsize start_pc = teco_cmdline.effective_len;
 
-	for (guint i = 0; i < len; i = g_utf8_next_char(data+i) - data) {
+	for (gsize i = 0, next; i < len; i = next) {
 		gunichar chr = g_utf8_get_char(data+i);
+		gsize run_len = paste ? teco_cmdline_plain_run(data+i, len-i) : 0;
 		g_autoptr(GError) tmp_error = NULL;
 
-		/*
-		 * Process immediate editing commands, inserting
-		 * characters as necessary into the command line.
-		 */
-		if (machine->current->process_edit_cmd_cb(machine, NULL, chr, &tmp_error))
-			continue;
+		if (run_len > 0) {
+			/*
+			 * Insert pasted plain characters at once.
+			 */
+			next = i+run_len;
+			teco_interface_popup_clear();
+			if (teco_cmdline_insert_plain(data+i, run_len, &tmp_error))
+				continue;
+		} else {
+			next = g_utf8_next_char(data+i) - data;
+
+			/*
+			 * Process immediate editing commands, inserting
+			 * characters as necessary into the command line.
+			 */
+			if (machine->current->process_edit_cmd_cb(machine, NULL, chr, &tmp_error))
+				continue;
+		}
 
 		if (!g_error_matches(tmp_error, TECO_ERROR, TECO_ERROR_RETURN)) {
 			/*
@@ -245,7 +477,7 @@ teco_cmdline_keypress(const gchar *data, gsize len, GError **error)
 			 * Actually we rub out the entire command line
 			 * up until the insertion point.
 			 */
-			teco_undo_pop(start_pc);
+			teco_cmdline_undo_pop(start_pc);
 			teco_cmdline.effective_len = start_pc;
 			/* program counter could be messed up */
 			teco_cmdline.machine.macro_pc = teco_cmdline.effective_len;
@@ -286,6 +518,7 @@ teco_cmdline_keypress(const gchar *data, gsize len, GError **error)
 		}
 
 		teco_undo_clear();
+		g_array_set_size(teco_cmdline_runs, 0);
 		/* also empties all Scintilla undo buffers */
 		teco_ring_set_scintilla_undo(TRUE);
 		teco_view_set_scintilla_undo(teco_qreg_view, TRUE);
@@ -317,6 +550,27 @@ teco_cmdline_keypress(const gchar *data, gsize len, GError **error)
 		start_pc = 0;
 	}
 
+	g_autoptr(GError) tmp_error = NULL;
+	if (!teco_cmdline_refresh(&tmp_error)) {
+		teco_error_add_frame_toplevel();
+		teco_error_display_short(tmp_error);
+
+		/*
+		 * See above: rub out the entire key sequence along with
+		 * the undo tokens of the refresh.
+		 * If the key sequence did not insert anything
+		 * (e.g. rubouts), only the refresh is undone.
+		 */
+		gboolean inserted = start_pc < teco_cmdline.effective_len;
+		teco_cmdline.effective_len = MIN(start_pc, teco_cmdline.effective_len);
+		teco_cmdline_undo_pop(teco_cmdline.effective_len);
+		teco_cmdline.machine.macro_pc = teco_cmdline.pc = teco_cmdline.effective_len;
+
+		/* the feedback before the key sequence has been popped as well */
+		if (inserted && !teco_cmdline_refresh(NULL))
+			teco_cmdline_undo_pop(teco_cmdline.effective_len);
+	}
+
 	/*
 	 * Echo command line
 	 */
@@ -324,6 +578,50 @@ teco_cmdline_keypress(const gchar *data, gsize len, GError **error)
 	return TRUE;
 }
 
+/**
+ * Process key press or expansion of key macro.
+ *
+ * Should be called only with the results of a single keypress.
+ * They are considered an unity and in case of errors, we
+ * rubout the entire sequence (unless there was a $$ return in the
+ * middle).
+ *
+ * @param data Key presses in UTF-8.
+ * @param len Length of data.
+ * @param error A GError.
+ * @return FALSE if error was set.
+ *   If TRUE was returned, there could still have been an error,
+ *   but it has already been handled.
+ */
+gboolean
+teco_cmdline_keypress(const gchar *data, gsize len, GError **error)
+{
+	return teco_cmdline_process(data, len, FALSE, error);
+}
+
+/**
+ * Process pasted text.
+ *
+ * This behaves like teco_cmdline_keypress(), but runs of plain
+ * characters in string arguments are inserted at once with a single
+ * set of undo tokens.
+ * They can still be rubbed out character by character.
+ * All other characters, including control characters, are processed
+ * like key presses, so they may still act as immediate editing commands.
+ *
+ * @param data Pasted text in UTF-8.
+ * @param len Length of data.
+ * @param error A GError.
+ * @return FALSE if error was set.
+ *   If TRUE was returned, there could still have been an error,
+ *   but it has already been handled.
+ */
+gboolean
+teco_cmdline_paste(const gchar *data, gsize len, GError **error)
+{
+	return teco_cmdline_process(data, len, TRUE, error);
+}
+
 teco_keymacro_status_t
 teco_cmdline_keymacro(const gchar *name, gssize name_len, GError **error)
 {
@@ -382,7 +680,7 @@ teco_cmdline_rubout(void)
 	                          teco_cmdline.str.data+teco_cmdline.effective_len);
 	if (p) {
 		teco_cmdline.effective_len = p - teco_cmdline.str.data;
-		teco_undo_pop(teco_cmdline.effective_len);
+		teco_cmdline_undo_pop(teco_cmdline.effective_len);
 	}
 }
 
@@ -392,6 +690,39 @@ teco_cmdline_cleanup(void)
 	teco_machine_main_clear(&teco_cmdline.machine);
 	teco_string_clear(&teco_cmdline.str);
 	teco_string_clear(&teco_last_cmdline);
+	g_array_free(teco_cmdline_runs, TRUE);
+}
+
+/**
+ * Whether the popup has been narrowed down by typing
+ * since it was last shown by a completion.
+ */
+static gboolean teco_cmdline_popup_filtered = FALSE;
+
+/**
+ * Handle a completion key while the popup may be shown.
+ *
+ * A popup that has been narrowed down by typing is replaced,
+ * so that the completion can extend the command line again.
+ *
+ * @return TRUE if the key was consumed by cycling through popup pages.
+ */
+static gboolean
+teco_cmdline_popup_scroll(void)
+{
+	if (!teco_interface_popup_is_shown()) {
+		teco_cmdline_popup_filtered = FALSE;
+		return FALSE;
+	}
+
+	if (teco_cmdline_popup_filtered) {
+		teco_interface_popup_clear();
+		teco_cmdline_popup_filtered = FALSE;
+		return FALSE;
+	}
+
+	teco_interface_popup_scroll();
+	return TRUE;
 }
 
 /*
@@ -479,11 +810,32 @@ teco_state_process_edit_cmd(teco_machine_t *ctx, teco_machine_t *parent_ctx, gun
 		return TRUE;
 	}
 
-	teco_interface_popup_clear();
+	/*
+	 * Characters that are inserted literally into the completed
+	 * word narrow down the popup instead of clearing it.
+	 */
+	teco_state_t *current = teco_cmdline.machine.parent.current;
+	gboolean filter = !TECO_IS_CTL(key) && key != '^' && teco_interface_popup_is_shown();
+	if (!filter)
+		teco_interface_popup_clear();
 
 	gchar buf[6];
 	gsize len = g_unichar_to_utf8(key, buf);
-	return teco_cmdline_insert(buf, len, error);
+	if (!teco_cmdline_insert(buf, len, error)) {
+		teco_interface_popup_clear();
+		return FALSE;
+	}
+
+	if (filter) {
+		/* the character might also have terminated the argument */
+		if (teco_cmdline.machine.parent.current == current &&
+		    teco_interface_popup_filter(buf, len))
+			teco_cmdline_popup_filtered = TRUE;
+		else
+			teco_interface_popup_clear();
+	}
+
+	return TRUE;
 }
 
 gboolean
@@ -681,11 +1033,9 @@ teco_state_stringbuilding_start_process_edit_cmd(teco_machine_stringbuilding_t *
 		 * TODO: In insertion commands, we can autocomplete
 		 * the string at the buffer cursor.
 		 */
-		if (teco_interface_popup_is_shown()) {
-			/* cycle through popup pages */
-			teco_interface_popup_scroll();
+		if (teco_cmdline_popup_scroll())
+			/* cycled through popup pages */
 			return TRUE;
-		}
 
 		const gchar *filename = teco_string_last_occurrence(ctx->result,
 		                                                    TECO_DEFAULT_BREAK_CHARS);
@@ -867,11 +1217,9 @@ teco_state_expectfile_process_edit_cmd(teco_machine_main_t *ctx, teco_machine_t
 		if (teco_cmdline.modifier_enabled)
 			break;
 
-		if (teco_interface_popup_is_shown()) {
-			/* cycle through popup pages */
-			teco_interface_popup_scroll();
+		if (teco_cmdline_popup_scroll())
+			/* cycled through popup pages */
 			return TRUE;
-		}
 
 		if (teco_string_contains(&ctx->expectstring.string, '\0'))
 			/* null-byte not allowed in file names */
@@ -923,11 +1271,9 @@ teco_state_expectglob_process_edit_cmd(teco_machine_main_t *ctx, teco_machine_t
 		if (teco_cmdline.modifier_enabled)
 			break;
 
-		if (teco_interface_popup_is_shown()) {
-			/* cycle through popup pages */
-			teco_interface_popup_scroll();
+		if (teco_cmdline_popup_scroll())
+			/* cycled through popup pages */
 			return TRUE;
-		}
 
 		if (teco_string_contains(&ctx->expectstring.string, '\0'))
 			/* null-byte not allowed in file names */
@@ -992,11 +1338,9 @@ teco_state_expectdir_process_edit_cmd(teco_machine_main_t *ctx, teco_machine_t *
 		if (teco_cmdline.modifier_enabled)
 			break;
 
-		if (teco_interface_popup_is_shown()) {
-			/* cycle through popup pages */
-			teco_interface_popup_scroll();
+		if (teco_cmdline_popup_scroll())
+			/* cycled through popup pages */
 			return TRUE;
-		}
 
 		if (teco_string_contains(&ctx->expectstring.string, '\0'))
 			/* null-byte not allowed in file names */
@@ -1062,11 +1406,9 @@ teco_state_qregspec_process_edit_cmd(teco_machine_qregspec_t *ctx, teco_machine_
 		if (teco_cmdline.modifier_enabled)
 			break;
 
-		if (teco_interface_popup_is_shown()) {
-			/* cycle through popup pages */
-			teco_interface_popup_scroll();
+		if (teco_cmdline_popup_scroll())
+			/* cycled through popup pages */
 			return TRUE;
-		}
 
 		/*
 		 * NOTE: This is only for short Q-Register specifications,
@@ -1120,11 +1462,9 @@ teco_state_qregspec_string_process_edit_cmd(teco_machine_qregspec_t *ctx, teco_m
 		if (teco_cmdline.modifier_enabled)
 			break;
 
-		if (teco_interface_popup_is_shown()) {
-			/* cycle through popup pages */
-			teco_interface_popup_scroll();
+		if (teco_cmdline_popup_scroll())
+			/* cycled through popup pages */
 			return TRUE;
-		}
 
 		g_auto(teco_string_t) new_chars, new_chars_escaped;
 		gboolean unambiguous = teco_machine_qregspec_auto_complete(ctx, &new_chars);
@@ -1174,11 +1514,9 @@ teco_state_execute_process_edit_cmd(teco_machine_main_t *ctx, teco_machine_t *pa
 		 * TODO: Implement shell-command completion by iterating
 		 * executables in $PATH
 		 */
-		if (teco_interface_popup_is_shown()) {
-			/* cycle through popup pages */
-			teco_interface_popup_scroll();
+		if (teco_cmdline_popup_scroll())
+			/* cycled through popup pages */
 			return TRUE;
-		}
 
 		const gchar *filename = teco_string_last_occurrence(&ctx->expectstring.string,
 		                                                    TECO_DEFAULT_BREAK_CHARS);
@@ -1213,11 +1551,9 @@ teco_state_scintilla_symbols_process_edit_cmd(teco_machine_main_t *ctx, teco_mac
 		if (teco_cmdline.modifier_enabled)
 			break;
 
-		if (teco_interface_popup_is_shown()) {
-			/* cycle through popup pages */
-			teco_interface_popup_scroll();
+		if (teco_cmdline_popup_scroll())
+			/* cycled through popup pages */
 			return TRUE;
-		}
 
 		const gchar *symbol = teco_string_last_occurrence(&ctx->expectstring.string, ",");
 		teco_symbol_list_t *list = symbol == ctx->expectstring.string.data
@@ -1269,11 +1605,9 @@ teco_state_goto_process_edit_cmd(teco_machine_main_t *ctx, teco_machine_t *paren
 		if (teco_cmdline.modifier_enabled)
 			break;
 
-		if (teco_interface_popup_is_shown()) {
-			/* cycle through popup pages */
-			teco_interface_popup_scroll();
+		if (teco_cmdline_popup_scroll())
+			/* cycled through popup pages */
 			return TRUE;
-		}
 
 		teco_string_t label = ctx->expectstring.string;
 		gint i = teco_string_rindex(&label, ',');
@@ -1330,11 +1664,9 @@ teco_state_help_process_edit_cmd(teco_machine_main_t *ctx, teco_machine_t *paren
 		if (teco_cmdline.modifier_enabled)
 			break;
 
-		if (teco_interface_popup_is_shown()) {
-			/* cycle through popup pages */
-			teco_interface_popup_scroll();
+		if (teco_cmdline_popup_scroll())
+			/* cycled through popup pages */
 			return TRUE;
-		}
 
 		if (teco_string_contains(&ctx->expectstring.string, '\0'))
 			/* help term must not contain null-byte */
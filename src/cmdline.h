@@ -61,6 +61,7 @@ typedef struct {
 extern teco_cmdline_t teco_cmdline;
 
 gboolean teco_cmdline_keypress(const gchar *data, gsize len, GError **error);
+gboolean teco_cmdline_paste(const gchar *data, gsize len, GError **error);
 
 typedef enum {
 	TECO_KEYMACRO_ERROR = 0,	/**< GError occurred */
@@ -38,10 +38,13 @@
 #include "search.h"
 #include "spawn.h"
 #include "glob.h"
+#include "filetype.h"
 #include "help.h"
 #include "cmdline.h"
 #include "error.h"
 #include "memory.h"
+#include "image.h"
+#include "stats.h"
 #include "eol.h"
 #include "qreg.h"
 #include "stdio-commands.h"
@@ -1608,8 +1611,11 @@ teco_state_control_time(teco_machine_main_t *ctx, GError **error)
  * First sleep <n> milliseconds before refreshing the view,
  * i.e. drawing it.
  * By default it sleeps for 10ms.
- * This can be added to loops to make progress visible
- * in interactive mode.
+ * In interactive mode, the screen is updated regularly
+ * while executing macros anyway, so progress is visible
+ * even without this command.
+ * It can however be added to loops to slow them down
+ * and to draw every single step.
  * In batch mode this command is useful as a sleep command.
  * Sleeps can of course be interrupted with CTRL+C.
  *
@@ -2017,6 +2023,14 @@ TECO_DEFINE_STATE_COMMAND(teco_state_ctlc_control);
  * The features controlled thus are discribed in other sections
  * of this manual.
  *
+ * .IP 2048:
+ * Enable/Disable lazy loading of buffers.
+ * If enabled, files opened with glob patterns by the
+ * \fBEB\fP command are not loaded into memory before
+ * they are edited for the first time.
+ * The \fBED\fP hook for added files is executed only once
+ * the buffer is first edited.
+ *
  * The default value of the \fBED\fP flags is 16
  * (only automatic EOL translation enabled).
  */
@@ -2137,6 +2151,47 @@ teco_state_ecommand_flags(teco_machine_main_t *ctx, GError **error)
  * setting \fBSCI_CHOOSECARETX\fP.
  * Unless most other settings, this is on purpose not restored on rubout,
  * so it "survives" command line replacements.
+ * .IP 5:
+ * The number of characters executed so far.
+ * This and the following counters are maintained at all times
+ * and can be used to find out where the runtime of macros is spent.
+ * Setting a counter sets it to the given value, so
+ * \(lq0,5EJ\(rq resets it.
+ * Negative values are treated like 0.
+ * Counters are not restored on rubout.
+ * All counters are printed on exit when using the \fB--stats\fP
+ * command line option.
+ * .IP 6:
+ * The number of parser state transitions.
+ * .IP 7:
+ * The number of undo tokens pushed.
+ * .IP 8:
+ * The number of undo tokens popped, i.e. executed on rubout.
+ * .IP 9:
+ * The number of regular expressions compiled for searches.
+ * .IP 10:
+ * The number of regular expression matches attempted by searches.
+ * .IP 11:
+ * The number of Scintilla messages sent, including those sent
+ * internally.
+ * Setting this counter also resets the counters of individual messages
+ * (see property 16).
+ * .IP 12:
+ * The number of document switches, e.g. when editing
+ * Q-Registers or accessing their contents.
+ * .IP 13:
+ * The number of bytes read with EOL normalization, e.g. when
+ * loading files or reading the output of external processes.
+ * .IP 14:
+ * The number of bytes written with EOL normalization, e.g. when
+ * saving files.
+ * .IP 15:
+ * The number of external processes spawned.
+ * .IP 16:
+ * The number of times the Scintilla message selected by
+ * \(lqid,16EJ\(rq has been sent, e.g.
+ * \(lq2183,16EJ 16EJ\(rq for \fBSCI_GETTEXTLENGTH\fP.
+ * (\fBread-only\fP except for selecting the message)
  * .
  * .IP -1:
  * Type of the last mouse event (\fBread-only\fP).
@@ -2189,10 +2244,15 @@ teco_state_ecommand_properties(teco_machine_main_t *ctx, GError **error)
 		EJ_BUFFERS,
 		EJ_MEMORY_LIMIT,
 		EJ_INIT_COLOR,
-		EJ_CARETX
+		EJ_CARETX,
+		/* one property per teco_stats_counter_t */
+		EJ_STATS_FIRST,
+		EJ_STATS_LAST = EJ_STATS_FIRST + TECO_STATS_COUNTERS - 1,
+		EJ_STATS_MESSAGE
 	};
 
 	static teco_int_t caret_x = 0;
+	static guint stats_message = 0;
 
 	teco_int_t property;
 	if (!teco_expressions_pop_num_calc(&property, teco_num_sign, error))
@@ -2221,14 +2281,31 @@ teco_state_ecommand_properties(teco_machine_main_t *ctx, GError **error)
 				teco_error_argexpected_set(error, "EJ");
 				return;
 			}
-			teco_interface_init_color((guint)value,
-			                          (guint32)teco_expressions_pop_num(0));
+			guint32 rgb = (guint32)teco_expressions_pop_num(0);
+			teco_image_init_color((guint)value, rgb);
+			teco_interface_init_color((guint)value, rgb);
 			break;
 
 		case EJ_CARETX:
 			caret_x = value;
 			break;
 
+		case EJ_STATS_FIRST ... EJ_STATS_LAST:
+			teco_stats_set(property - EJ_STATS_FIRST, MAX(value, 0));
+			if (property - EJ_STATS_FIRST == TECO_STATS_MESSAGES)
+				memset(teco_stats_messages, 0, sizeof(teco_stats_messages));
+			break;
+
+		case EJ_STATS_MESSAGE:
+			if (value < 0 || value >= TECO_STATS_MESSAGES_MAX) {
+				g_set_error(error, TECO_ERROR, TECO_ERROR_FAILED,
+				            "Invalid Scintilla message %" TECO_INT_FORMAT " "
+				            "specified for <EJ>", value);
+				return;
+			}
+			stats_message = value;
+			break;
+
 		default:
 			g_set_error(error, TECO_ERROR, TECO_ERROR_FAILED,
 			            "Cannot set property %" TECO_INT_FORMAT " "
@@ -2284,6 +2361,14 @@ teco_state_ecommand_properties(teco_machine_main_t *ctx, GError **error)
 		teco_expressions_push(caret_x);
 		break;
 
+	case EJ_STATS_FIRST ... EJ_STATS_LAST:
+		teco_expressions_push(teco_stats_get(property - EJ_STATS_FIRST));
+		break;
+
+	case EJ_STATS_MESSAGE:
+		teco_expressions_push(teco_stats_messages[stats_message]);
+		break;
+
 	default:
 		g_set_error(error, TECO_ERROR, TECO_ERROR_FAILED,
 		            "Invalid property %" TECO_INT_FORMAT " "
@@ -2751,8 +2836,12 @@ teco_state_ecommand_input(teco_machine_main_t *ctx, gunichar chr, GError **error
 		          .modifier_at = TRUE, .modifier_colon = 1},
 		['N']  = {&teco_state_glob_pattern,
 		          .modifier_at = TRUE, .modifier_colon = 1},
+		['P']  = {&teco_state_pipe_buffers,
+		          .modifier_at = TRUE, .modifier_colon = 1},
 		['S']  = {&teco_state_scintilla_symbols,
 		          .modifier_at = TRUE},
+		['T']  = {&teco_state_filetype_setter,
+		          .modifier_at = TRUE, .modifier_colon = 1},
 		['Q']  = {&teco_state_eqcommand,
 		          .modifier_at = TRUE},
 		['U']  = {&teco_state_eucommand,
@@ -2872,6 +2961,19 @@ teco_state_insert_process(teco_machine_main_t *ctx, const teco_string_t *str,
 	return TRUE;
 }
 
+void
+teco_state_insert_truncate(teco_machine_main_t *ctx, gsize chars)
+{
+	sptr_t pos = teco_interface_ssm(SCI_GETCURRENTPOS, 0, 0);
+
+	teco_interface_ssm(SCI_BEGINUNDOACTION, 0, 0);
+	teco_interface_ssm(SCI_DELETERANGE, pos - chars, chars);
+	teco_interface_ssm(SCI_ENDUNDOACTION, 0, 0);
+
+	if (teco_current_doc_must_undo())
+		undo__teco_interface_ssm(SCI_UNDO, 0, 0);
+}
+
 teco_state_t *
 teco_state_insert_done(teco_machine_main_t *ctx, const teco_string_t *str, GError **error)
 {
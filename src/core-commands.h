@@ -76,6 +76,7 @@ extern teco_range_t *teco_ranges;
 gboolean teco_state_insert_initial(teco_machine_main_t *ctx, GError **error);
 gboolean teco_state_insert_process(teco_machine_main_t *ctx, const teco_string_t *str,
                                    gsize new_chars, GError **error);
+void teco_state_insert_truncate(teco_machine_main_t *ctx, gsize chars);
 teco_state_t *teco_state_insert_done(teco_machine_main_t *ctx, const teco_string_t *str, GError **error);
 
 /* in cmdline.c */
@@ -100,6 +101,7 @@ gboolean teco_state_insert_process_edit_cmd(teco_machine_main_t *ctx, teco_machi
 		.initial_cb = (teco_state_initial_cb_t)teco_state_insert_initial, \
 		.process_edit_cmd_cb = (teco_state_process_edit_cmd_cb_t)teco_state_insert_process_edit_cmd, \
 		.expectstring.process_cb = teco_state_insert_process, \
+		.expectstring.truncate_cb = teco_state_insert_truncate, \
 		##__VA_ARGS__ \
 	)
 
@@ -27,6 +27,7 @@
 #include "view.h"
 #include "undo.h"
 #include "qreg.h"
+#include "stats.h"
 #include "doc.h"
 
 static inline teco_doc_scintilla_t *
@@ -73,6 +74,8 @@ teco_doc_edit(teco_doc_t *ctx, guint default_cp)
 {
 	gboolean new_doc = ctx->doc == NULL;
 
+	teco_stats_inc(TECO_STATS_DOC_EDITS);
+
 	teco_view_ssm(teco_qreg_view, SCI_SETDOCPOINTER, 0,
 	              (sptr_t)teco_doc_get_scintilla(ctx));
 	teco_view_ssm(teco_qreg_view, SCI_SETFIRSTVISIBLELINE, ctx->first_line, 0);
@@ -26,6 +26,7 @@
 #include <Scintilla.h>
 
 #include "sciteco.h"
+#include "stats.h"
 #include "eol.h"
 
 const gchar *
@@ -43,25 +44,28 @@ teco_eol_get_seq(gint eol_mode)
 }
 
 static inline void
-teco_eol_reader_init(teco_eol_reader_t *ctx)
+teco_eol_reader_init(teco_eol_reader_t *ctx, gboolean autoeol)
 {
 	memset(ctx, 0, sizeof(*ctx));
 	ctx->eol_style = -1;
+	ctx->autoeol = autoeol;
 }
 
 static GIOStatus
 teco_eol_reader_read_gio(teco_eol_reader_t *ctx, gsize *read_len, GError **error)
 {
-	return g_io_channel_read_chars(ctx->gio.channel, ctx->gio.buffer,
-	                               sizeof(ctx->gio.buffer),
-	                               read_len, error);
+	GIOStatus rc = g_io_channel_read_chars(ctx->gio.channel, ctx->gio.buffer,
+	                                       sizeof(ctx->gio.buffer),
+	                                       read_len, error);
+	teco_stats_add_atomic(TECO_STATS_EOL_READ, *read_len);
+	return rc;
 }
 
 /** @memberof teco_eol_reader_t */
 void
-teco_eol_reader_init_gio(teco_eol_reader_t *ctx, GIOChannel *channel)
+teco_eol_reader_init_gio(teco_eol_reader_t *ctx, gboolean autoeol, GIOChannel *channel)
 {
-	teco_eol_reader_init(ctx);
+	teco_eol_reader_init(ctx, autoeol);
 	ctx->read_cb = teco_eol_reader_read_gio;
 
 	teco_eol_reader_set_channel(ctx, channel);
@@ -72,6 +76,7 @@ teco_eol_reader_read_mem(teco_eol_reader_t *ctx, gsize *read_len, GError **error
 {
 	*read_len = ctx->mem.len;
 	ctx->mem.len = 0;
+	teco_stats_add_atomic(TECO_STATS_EOL_READ, *read_len);
 	/*
 	 * On the first call, returns G_IO_STATUS_NORMAL,
 	 * later G_IO_STATUS_EOF.
@@ -81,9 +86,9 @@ teco_eol_reader_read_mem(teco_eol_reader_t *ctx, gsize *read_len, GError **error
 
 /** @memberof teco_eol_reader_t */
 void
-teco_eol_reader_init_mem(teco_eol_reader_t *ctx, gchar *buffer, gsize len)
+teco_eol_reader_init_mem(teco_eol_reader_t *ctx, gboolean autoeol, gchar *buffer, gsize len)
 {
-	teco_eol_reader_init(ctx);
+	teco_eol_reader_init(ctx, autoeol);
 	ctx->read_cb = teco_eol_reader_read_mem;
 
 	ctx->mem.buffer = buffer;
@@ -155,7 +160,7 @@ teco_eol_reader_convert(teco_eol_reader_t *ctx, gchar **ret, gsize *data_len, GE
 			break;
 		}
 
-		if (!(teco_ed & TECO_ED_AUTOEOL)) {
+		if (!ctx->autoeol) {
 			/*
 			 * No EOL translation - always return entire
 			 * buffer
@@ -297,11 +302,12 @@ teco_eol_reader_clear(teco_eol_reader_t *ctx)
 }
 
 static inline void
-teco_eol_writer_init(teco_eol_writer_t *ctx, gint eol_mode)
+teco_eol_writer_init(teco_eol_writer_t *ctx, gint eol_mode, gboolean autoeol)
 {
 	memset(ctx, 0, sizeof(*ctx));
 	ctx->eol_seq = teco_eol_get_seq(eol_mode);
 	ctx->eol_seq_len = strlen(ctx->eol_seq);
+	ctx->autoeol = autoeol;
 }
 
 static gssize
@@ -319,14 +325,15 @@ teco_eol_writer_write_gio(teco_eol_writer_t *ctx, const gchar *buffer, gsize buf
 		break;
 	}
 
+	teco_stats_add_atomic(TECO_STATS_EOL_WRITTEN, bytes_written);
 	return bytes_written;
 }
 
 /** @memberof teco_eol_writer_t */
 void
-teco_eol_writer_init_gio(teco_eol_writer_t *ctx, gint eol_mode, GIOChannel *channel)
+teco_eol_writer_init_gio(teco_eol_writer_t *ctx, gint eol_mode, gboolean autoeol, GIOChannel *channel)
 {
-	teco_eol_writer_init(ctx, eol_mode);
+	teco_eol_writer_init(ctx, eol_mode, autoeol);
 	ctx->write_cb = teco_eol_writer_write_gio;
 	teco_eol_writer_set_channel(ctx, channel);
 }
@@ -335,6 +342,7 @@ static gssize
 teco_eol_writer_write_mem(teco_eol_writer_t *ctx, const gchar *buffer, gsize buffer_len, GError **error)
 {
 	g_string_append_len(ctx->mem.str, buffer, buffer_len);
+	teco_stats_add_atomic(TECO_STATS_EOL_WRITTEN, buffer_len);
 	return buffer_len;
 }
 
@@ -346,9 +354,9 @@ teco_eol_writer_write_mem(teco_eol_writer_t *ctx, const gchar *buffer, gsize buf
  * @memberof teco_eol_writer_t
  */
 void
-teco_eol_writer_init_mem(teco_eol_writer_t *ctx, gint eol_mode, GString *str)
+teco_eol_writer_init_mem(teco_eol_writer_t *ctx, gint eol_mode, gboolean autoeol, GString *str)
 {
-	teco_eol_writer_init(ctx, eol_mode);
+	teco_eol_writer_init(ctx, eol_mode, autoeol);
 	ctx->write_cb = teco_eol_writer_write_mem;
 	ctx->mem.str = str;
 }
@@ -373,7 +381,7 @@ teco_eol_writer_init_mem(teco_eol_writer_t *ctx, gint eol_mode, GString *str)
 gssize
 teco_eol_writer_convert(teco_eol_writer_t *ctx, const gchar *buffer, gsize buffer_len, GError **error)
 {
-	if (!(teco_ed & TECO_ED_AUTOEOL))
+	if (!ctx->autoeol)
 		/*
 		 * Write without EOL-translation:
 		 * `state` is not required
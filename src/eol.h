@@ -33,6 +33,9 @@ struct teco_eol_reader_t {
 	gint eol_style;
 	gboolean eol_style_inconsistent;
 
+	/** whether EOLs are normalized (usually the ED flag) */
+	gboolean autoeol;
+
 	GIOStatus (*read_cb)(teco_eol_reader_t *ctx, gsize *read_len, GError **error);
 
 	/*
@@ -52,8 +55,8 @@ struct teco_eol_reader_t {
 	};
 };
 
-void teco_eol_reader_init_gio(teco_eol_reader_t *ctx, GIOChannel *channel);
-void teco_eol_reader_init_mem(teco_eol_reader_t *ctx, gchar *buffer, gsize len);
+void teco_eol_reader_init_gio(teco_eol_reader_t *ctx, gboolean autoeol, GIOChannel *channel);
+void teco_eol_reader_init_mem(teco_eol_reader_t *ctx, gboolean autoeol, gchar *buffer, gsize len);
 
 /** @memberof teco_eol_reader_t */
 static inline void
@@ -84,6 +87,9 @@ struct teco_eol_writer_t {
 	const gchar *eol_seq;
 	gsize eol_seq_len;
 
+	/** whether EOLs are translated (usually the ED flag) */
+	gboolean autoeol;
+
 	gssize (*write_cb)(teco_eol_writer_t *ctx, const gchar *buffer, gsize buffer_len, GError **error);
 
 	union {
@@ -97,8 +103,8 @@ struct teco_eol_writer_t {
 	};
 };
 
-void teco_eol_writer_init_gio(teco_eol_writer_t *ctx, gint eol_mode, GIOChannel *channel);
-void teco_eol_writer_init_mem(teco_eol_writer_t *ctx, gint eol_mode, GString *str);
+void teco_eol_writer_init_gio(teco_eol_writer_t *ctx, gint eol_mode, gboolean autoeol, GIOChannel *channel);
+void teco_eol_writer_init_mem(teco_eol_writer_t *ctx, gint eol_mode, gboolean autoeol, GString *str);
 
 /** @memberof teco_eol_writer_t */
 static inline void
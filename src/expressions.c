@@ -18,38 +18,176 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include <glib.h>
 
 #include "sciteco.h"
 #include "error.h"
+#include "cmdline.h"
 #include "undo.h"
 #include "qreg.h"
 #include "expressions.h"
 
+/** Number of stack entries that can be pushed without allocating */
+#define TECO_EXPRESSIONS_INLINE_SIZE 1024
+
+static guint8 teco_expressions_inline_ops[TECO_EXPRESSIONS_INLINE_SIZE];
+static teco_int_t teco_expressions_inline_numbers[TECO_EXPRESSIONS_INLINE_SIZE];
+
 /*
- * Number and operator stacks are static, so
- * they can be passed to the undo token constructors.
+ * The expression stack is static, so it does not have to be
+ * referenced from undo tokens.
  * This is OK since we're currently singleton.
+ *
+ * Every stack entry consists of an operator and a number, which
+ * is only valid for TECO_OP_NUMBER entries.
+ * Both are stored in separate arrays, sharing the same stack height.
+ * The arrays point to static storage until the stack grows
+ * beyond TECO_EXPRESSIONS_INLINE_SIZE entries.
  */
-static GArray *teco_numbers;
+static struct {
+	guint len;
+	guint size;
+	/** operators (teco_operator_t) */
+	guint8 *ops;
+	teco_int_t *numbers;
+} teco_stack = {
+	0, TECO_EXPRESSIONS_INLINE_SIZE,
+	teco_expressions_inline_ops, teco_expressions_inline_numbers
+};
+
+static void
+teco_expressions_grow(void)
+{
+	guint size = teco_stack.size*2;
+
+	if (teco_stack.ops == teco_expressions_inline_ops) {
+		teco_stack.ops = g_new(guint8, size);
+		memcpy(teco_stack.ops, teco_expressions_inline_ops, teco_stack.len);
+		teco_stack.numbers = g_new(teco_int_t, size);
+		memcpy(teco_stack.numbers, teco_expressions_inline_numbers,
+		       teco_stack.len*sizeof(teco_int_t));
+	} else {
+		teco_stack.ops = g_renew(guint8, teco_stack.ops, size);
+		teco_stack.numbers = g_renew(teco_int_t, teco_stack.numbers, size);
+	}
+	teco_stack.size = size;
+}
 
-TECO_DEFINE_ARRAY_UNDO_INSERT_VAL(teco_numbers, teco_int_t);
-TECO_DEFINE_ARRAY_UNDO_REMOVE_INDEX(teco_numbers);
+/** Saved stack entry */
+typedef struct {
+	teco_operator_t op;
+	teco_int_t number;
+} teco_expressions_entry_t;
 
-static GArray *teco_operators;
+/**
+ * Undo token restoring the expression stack.
+ *
+ * Only one token is pushed per command line position,
+ * no matter how many times the stack is modified.
+ * Entries above `low` did not change since the token was pushed.
+ * The entries between `low` and `height` are saved
+ * as soon as they are modified or popped.
+ */
+typedef struct {
+	/** stack height when the token was pushed */
+	guint height;
+	/** lowest stack index modified since the token was pushed */
+	guint low;
+	/** original entries from `height`-1 down to `low` */
+	GArray *saved;
+} teco_expressions_undo_t;
+
+/** Undo token of the current command line position or NULL */
+static teco_expressions_undo_t *teco_expressions_undo_current = NULL;
+static gsize teco_expressions_undo_pc;
+
+static void
+teco_expressions_undo_action(teco_expressions_undo_t *ctx, gboolean run)
+{
+	if (ctx == teco_expressions_undo_current)
+		teco_expressions_undo_current = NULL;
+
+	if (run) {
+		/* the stack has been this high before, so there is no need to grow it */
+		teco_stack.len = ctx->low;
+		for (guint i = ctx->saved ? ctx->saved->len : 0; i > 0; i--) {
+			teco_expressions_entry_t *entry = &g_array_index(ctx->saved, teco_expressions_entry_t, i-1);
+			teco_stack.ops[teco_stack.len] = entry->op;
+			teco_stack.numbers[teco_stack.len] = entry->number;
+			teco_stack.len++;
+		}
+		g_assert(teco_stack.len == ctx->height);
+	}
 
-TECO_DEFINE_ARRAY_UNDO_INSERT_VAL(teco_operators, teco_operator_t);
-TECO_DEFINE_ARRAY_UNDO_REMOVE_INDEX(teco_operators);
+	if (ctx->saved)
+		g_array_free(ctx->saved, TRUE);
+}
 
-static gboolean teco_expressions_calc(GError **error);
+/**
+ * Prepare modifying the stack at the given index or above.
+ *
+ * This must be called before pushing, popping or modifying stack entries.
+ */
+static void
+teco_expressions_undo_save(guint index)
+{
+	if (!teco_undo_enabled)
+		return;
+
+	teco_expressions_undo_t *ctx = teco_expressions_undo_current;
+	if (!ctx || teco_expressions_undo_pc != teco_cmdline.pc) {
+		ctx = teco_undo_push(teco_expressions_undo);
+		ctx->height = ctx->low = teco_stack.len;
+		ctx->saved = NULL;
+		teco_expressions_undo_current = ctx;
+		teco_expressions_undo_pc = teco_cmdline.pc;
+	}
+
+	if (index >= ctx->low)
+		return;
+	if (!ctx->saved)
+		ctx->saved = g_array_sized_new(FALSE, FALSE, sizeof(teco_expressions_entry_t),
+		                               ctx->low - index);
+	while (ctx->low > index) {
+		ctx->low--;
+		teco_expressions_entry_t entry = {
+			teco_stack.ops[ctx->low], teco_stack.numbers[ctx->low]
+		};
+		g_array_append_val(ctx->saved, entry);
+	}
+}
+
+static inline void
+teco_expressions_push_entry(teco_operator_t op, teco_int_t number)
+{
+	teco_expressions_undo_save(teco_stack.len);
+
+	if (G_UNLIKELY(teco_stack.len == teco_stack.size))
+		teco_expressions_grow();
+	teco_stack.ops[teco_stack.len] = op;
+	teco_stack.numbers[teco_stack.len] = number;
+	teco_stack.len++;
+}
 
-static void __attribute__((constructor))
-teco_expressions_init(void)
+/** Remove the stack entry at the given index (counted from the bottom) */
+static inline void
+teco_expressions_remove(guint index)
 {
-	teco_numbers = g_array_sized_new(FALSE, FALSE, sizeof(teco_int_t), 1024);
-	teco_operators = g_array_sized_new(FALSE, FALSE, sizeof(teco_operator_t), 1024);
+	teco_expressions_undo_save(index);
+
+	teco_stack.len--;
+	if (G_UNLIKELY(index < teco_stack.len)) {
+		memmove(teco_stack.ops + index, teco_stack.ops + index + 1,
+		        teco_stack.len - index);
+		memmove(teco_stack.numbers + index, teco_stack.numbers + index + 1,
+		        (teco_stack.len - index)*sizeof(teco_int_t));
+	}
 }
 
+static gboolean teco_expressions_calc(GError **error);
+
 /** Get operator precedence */
 static inline gint
 teco_expressions_precedence(teco_operator_t op)
@@ -62,25 +200,22 @@ gint teco_num_sign = 1;
 void
 teco_expressions_push_int(teco_int_t number)
 {
-	while (teco_operators->len > 0 && teco_expressions_peek_op(0) == TECO_OP_NEW)
-		teco_expressions_pop_op(0);
-
-	teco_expressions_push_op(TECO_OP_NUMBER);
+	while (teco_stack.len > 0 && teco_stack.ops[teco_stack.len-1] == TECO_OP_NEW)
+		teco_expressions_remove(teco_stack.len-1);
 
 	if (teco_num_sign < 0) {
 		teco_set_num_sign(1);
 		number *= -1;
 	}
 
-	g_array_append_val(teco_numbers, number);
-	undo__remove_index__teco_numbers(teco_numbers->len-1);
+	teco_expressions_push_entry(TECO_OP_NUMBER, number);
 }
 
 /** Peek into the numbers stack */
 teco_int_t
 teco_expressions_peek_num(guint index)
 {
-	return g_array_index(teco_numbers, teco_int_t, teco_numbers->len - 1 - index);
+	return teco_stack.numbers[teco_stack.len - 1 - index];
 }
 
 /**
@@ -95,17 +230,11 @@ teco_expressions_peek_num(guint index)
 teco_int_t
 teco_expressions_pop_num(guint index)
 {
-	teco_int_t n = 0;
-	G_GNUC_UNUSED teco_operator_t op = teco_expressions_pop_op(0);
-
-	g_assert(op == TECO_OP_NUMBER);
-
-	if (teco_numbers->len > 0) {
-		n = teco_expressions_peek_num(index);
-		undo__insert_val__teco_numbers(teco_numbers->len - 1 - index, n);
-		g_array_remove_index(teco_numbers, teco_numbers->len - 1 - index);
-	}
+	g_assert(index < teco_stack.len &&
+	         teco_expressions_peek_op(index) == TECO_OP_NUMBER);
 
+	teco_int_t n = teco_expressions_peek_num(index);
+	teco_expressions_remove(teco_stack.len - 1 - index);
 	return n;
 }
 
@@ -154,8 +283,7 @@ teco_expressions_add_digit(gunichar digit, teco_qreg_t *qreg)
 void
 teco_expressions_push_op(teco_operator_t op)
 {
-	g_array_append_val(teco_operators, op);
-	undo__remove_index__teco_operators(teco_operators->len-1);
+	teco_expressions_push_entry(op, 0);
 }
 
 gboolean
@@ -180,7 +308,7 @@ teco_expressions_push_calc(teco_operator_t op, GError **error)
 teco_operator_t
 teco_expressions_peek_op(guint index)
 {
-	return g_array_index(teco_operators, teco_operator_t, teco_operators->len - 1 - index);
+	return teco_stack.ops[teco_stack.len - 1 - index];
 }
 
 teco_operator_t
@@ -188,10 +316,9 @@ teco_expressions_pop_op(guint index)
 {
 	teco_operator_t op = TECO_OP_NIL;
 
-	if (teco_operators->len > 0) {
+	if (teco_stack.len > 0) {
 		op = teco_expressions_peek_op(index);
-		undo__insert_val__teco_operators(teco_operators->len - 1 - index, op);
-		g_array_remove_index(teco_operators, teco_operators->len - 1 - index);
+		teco_expressions_remove(teco_stack.len - 1 - index);
 	}
 
 	return op;
@@ -202,19 +329,23 @@ teco_expressions_calc(GError **error)
 {
 	teco_int_t result;
 
-	if (!teco_operators->len || teco_expressions_peek_op(0) != TECO_OP_NUMBER) {
+	/*
+	 * The operation is performed in place,
+	 * replacing the left operand with the result.
+	 */
+	if (!teco_stack.len || teco_expressions_peek_op(0) != TECO_OP_NUMBER) {
 		g_set_error_literal(error, TECO_ERROR, TECO_ERROR_FAILED,
 		                    "Missing right operand");
 		return FALSE;
 	}
-	teco_int_t vright = teco_expressions_pop_num(0);
-	teco_operator_t op = teco_expressions_pop_op(0);
-	if (!teco_operators->len || teco_expressions_peek_op(0) != TECO_OP_NUMBER) {
+	if (teco_stack.len < 3 || teco_expressions_peek_op(2) != TECO_OP_NUMBER) {
 		g_set_error_literal(error, TECO_ERROR, TECO_ERROR_FAILED,
 		                    "Missing left operand");
 		return FALSE;
 	}
-	teco_int_t vleft = teco_expressions_pop_num(0);
+	teco_int_t vright = teco_expressions_peek_num(0);
+	teco_operator_t op = teco_expressions_peek_op(1);
+	teco_int_t vleft = teco_expressions_peek_num(2);
 
 	switch (op) {
 	case TECO_OP_POW:
@@ -280,7 +411,9 @@ teco_expressions_calc(GError **error)
 		g_assert_not_reached();
 	}
 
-	teco_expressions_push(result);
+	teco_expressions_undo_save(teco_stack.len-3);
+	teco_stack.numbers[teco_stack.len-3] = result;
+	teco_stack.len -= 2;
 	return TRUE;
 }
 
@@ -328,7 +461,7 @@ teco_expressions_args(void)
 {
 	guint n = 0;
 
-	while (n < teco_operators->len && teco_expressions_peek_op(n) == TECO_OP_NUMBER)
+	while (n < teco_stack.len && teco_expressions_peek_op(n) == TECO_OP_NUMBER)
 		n++;
 
 	return n;
@@ -337,7 +470,7 @@ teco_expressions_args(void)
 gint
 teco_expressions_first_op(void)
 {
-	for (guint i = 0; i < teco_operators->len; i++) {
+	for (guint i = 0; i < teco_stack.len; i++) {
 		switch (teco_expressions_peek_op(i)) {
 		case TECO_OP_NUMBER:
 		case TECO_OP_NEW:
@@ -367,7 +500,7 @@ guint teco_brace_level = 0;
 void
 teco_expressions_brace_open(void)
 {
-	while (teco_operators->len > 0 && teco_expressions_peek_op(0) == TECO_OP_NEW)
+	while (teco_stack.len > 0 && teco_expressions_peek_op(0) == TECO_OP_NEW)
 		teco_expressions_pop_op(0);
 
 	teco_expressions_push_op(TECO_OP_BRACE);
@@ -412,8 +545,9 @@ teco_expressions_brace_close(GError **error)
 void
 teco_expressions_clear(void)
 {
-	g_array_set_size(teco_numbers, 0);
-	g_array_set_size(teco_operators, 0);
+	teco_stack.len = 0;
+	/* no longer consistent with the stack */
+	teco_expressions_undo_current = NULL;
 	teco_brace_level = 0;
 }
 
@@ -452,6 +586,8 @@ teco_expressions_format(gchar *buffer, teco_int_t number, teco_qreg_t *qreg)
 static void TECO_DEBUG_CLEANUP
 teco_expressions_cleanup(void)
 {
-	g_array_free(teco_numbers, TRUE);
-	g_array_free(teco_operators, TRUE);
+	if (teco_stack.ops != teco_expressions_inline_ops) {
+		g_free(teco_stack.ops);
+		g_free(teco_stack.numbers);
+	}
 }
@@ -25,6 +25,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <time.h>
 #include <sys/stat.h>
 
 #ifdef HAVE_WINDOWS_H
@@ -38,6 +39,11 @@
 
 #ifdef G_OS_UNIX
 #include <dlfcn.h>
+#include <dirent.h>
+#endif
+
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
 #endif
 
 #include "sciteco.h"
@@ -360,6 +366,346 @@ teco_file_expand_path(const gchar *path)
 	return g_build_filename(home.data, path+1, NULL);
 }
 
+/*
+ * Directory listing cache.
+ *
+ * Filename completions and globbing would otherwise read
+ * the same directories again and again, which can be slow
+ * on large directories and network file systems.
+ */
+
+/** Maximum number of cached directory listings */
+#define TECO_FILE_LISTING_CACHE_SIZE	16
+/** Time in microseconds after which unwatched listings are read again */
+#define TECO_FILE_LISTING_TTL		(5*G_USEC_PER_SEC)
+
+#if defined(HAVE_SYS_INOTIFY_H) && defined(HAVE_INOTIFY_INIT1)
+#define TECO_FILE_INOTIFY
+#endif
+
+/** Table of cached teco_file_listing_t by absolute path */
+static GHashTable *teco_file_listings;
+
+#ifdef TECO_FILE_INOTIFY
+
+/** inotify instance watching all cached listings or -1 */
+static gint teco_file_inotify_fd = -1;
+
+/** inotify instance is only created on first use */
+static gint
+teco_file_inotify_get_fd(void)
+{
+	static gboolean initialized = FALSE;
+
+	if (G_UNLIKELY(!initialized)) {
+		teco_file_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		initialized = TRUE;
+	}
+
+	return teco_file_inotify_fd;
+}
+
+/**
+ * Invalidate cached listings according to pending inotify events.
+ *
+ * Events are queued synchronously with the file system operations,
+ * so changes performed by ourselves are seen immediately.
+ */
+static void
+teco_file_listings_poll(void)
+{
+	if (teco_file_inotify_fd < 0)
+		return;
+
+	/* alignment as recommended by inotify(7) */
+	gchar buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	gssize len;
+
+	while ((len = read(teco_file_inotify_fd, buf, sizeof(buf))) > 0) {
+		for (const gchar *p = buf; p < buf+len; ) {
+			const struct inotify_event *event = (const struct inotify_event *)p;
+			p += sizeof(struct inotify_event) + event->len;
+
+			GHashTableIter iter;
+			teco_file_listing_t *listing;
+			g_hash_table_iter_init(&iter, teco_file_listings);
+			while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&listing))
+				if (event->mask & IN_Q_OVERFLOW || listing->wd == event->wd)
+					listing->valid = FALSE;
+		}
+	}
+}
+
+#endif /* TECO_FILE_INOTIFY */
+
+/**
+ * Remove a listing from the cache.
+ *
+ * This stops watching the directory.
+ * The listing itself will stay alive as long as there are other references.
+ */
+static void
+teco_file_listing_evict(teco_file_listing_t *ctx)
+{
+#ifdef TECO_FILE_INOTIFY
+	if (ctx->wd >= 0)
+		inotify_rm_watch(teco_file_inotify_fd, ctx->wd);
+	ctx->wd = -1;
+#endif
+
+	teco_file_listing_unref(ctx);
+}
+
+static void __attribute__((constructor))
+teco_file_listings_init(void)
+{
+	teco_file_listings = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+	                                           (GDestroyNotify)teco_file_listing_evict);
+}
+
+#if defined(G_OS_UNIX) && defined(HAVE_STRUCT_DIRENT_D_TYPE)
+
+static gboolean
+teco_file_listing_read_entries(teco_file_listing_t *ctx)
+{
+	DIR *dir = opendir(ctx->path);
+	if (!dir)
+		return FALSE;
+
+	struct dirent *dirent;
+	while ((dirent = readdir(dir))) {
+		if (!strcmp(dirent->d_name, ".") || !strcmp(dirent->d_name, ".."))
+			continue;
+
+		teco_file_listing_entry_t entry;
+		teco_string_init_chunk(&entry.name, dirent->d_name, strlen(dirent->d_name),
+		                       ctx->chunk);
+
+		/*
+		 * The entry type usually saves us from calling stat() later on.
+		 * Symlinks however must be resolved.
+		 */
+		switch (dirent->d_type) {
+		case DT_REG:
+			entry.type = G_FILE_TEST_IS_REGULAR;
+			break;
+		case DT_DIR:
+			entry.type = G_FILE_TEST_IS_DIR;
+			break;
+		case DT_LNK:
+		case DT_UNKNOWN:
+			entry.type = 0;
+			break;
+		default:
+			entry.type = G_FILE_TEST_EXISTS;
+			break;
+		}
+
+		g_array_append_val(ctx->entries, entry);
+	}
+
+	closedir(dir);
+	return TRUE;
+}
+
+#else /* !G_OS_UNIX || !HAVE_STRUCT_DIRENT_D_TYPE */
+
+static gboolean
+teco_file_listing_read_entries(teco_file_listing_t *ctx)
+{
+	g_autoptr(GDir) dir = g_dir_open(ctx->path, 0, NULL);
+	if (!dir)
+		return FALSE;
+
+	const gchar *name;
+	while ((name = g_dir_read_name(dir))) {
+		/* types are resolved on demand */
+		teco_file_listing_entry_t entry = {.type = 0};
+		teco_string_init_chunk(&entry.name, name, strlen(name), ctx->chunk);
+		g_array_append_val(ctx->entries, entry);
+	}
+
+	return TRUE;
+}
+
+#endif
+
+/**
+ * Read a directory listing.
+ *
+ * @param path Absolute path of the directory. It is owned by the listing.
+ * @return New listing or NULL if the directory cannot be read.
+ */
+static teco_file_listing_t *
+teco_file_listing_read(gchar *path)
+{
+	teco_file_listing_t *ctx = g_new0(teco_file_listing_t, 1);
+	ctx->ref_count = 1;
+	ctx->path = path;
+	ctx->entries = g_array_new(FALSE, FALSE, sizeof(teco_file_listing_entry_t));
+	ctx->chunk = g_string_chunk_new(32);
+	ctx->read_time = g_get_monotonic_time();
+	ctx->wd = -1;
+	ctx->valid = TRUE;
+
+#ifdef TECO_FILE_INOTIFY
+	/*
+	 * The watch is added before reading the directory,
+	 * so no modification can get lost.
+	 * If this fails (e.g. because of the watch limit),
+	 * the listing is validated like on other platforms.
+	 */
+	if (teco_file_inotify_get_fd() >= 0)
+		ctx->wd = inotify_add_watch(teco_file_inotify_fd, path,
+		                            IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+		                            IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+#endif
+
+	/*
+	 * Modification times may have a granularity of only one second.
+	 * If the directory has been modified in the current second,
+	 * later modifications could go unnoticed.
+	 */
+	GStatBuf buf;
+	if (!g_stat(path, &buf)) {
+		ctx->mtime = buf.st_mtime;
+		ctx->mtime_settled = buf.st_mtime < time(NULL);
+	}
+
+	if (!teco_file_listing_read_entries(ctx)) {
+		teco_file_listing_evict(ctx);
+		return NULL;
+	}
+
+	return ctx;
+}
+
+static gboolean
+teco_file_listing_is_valid(teco_file_listing_t *ctx)
+{
+#ifdef TECO_FILE_INOTIFY
+	/*
+	 * inotify does not report changes on remote file systems
+	 * (e.g. NFS or FUSE), so the listing is still validated
+	 * like on other platforms.
+	 */
+	if (ctx->wd >= 0 && !ctx->valid)
+		return FALSE;
+#endif
+
+	if (g_get_monotonic_time() - ctx->read_time > TECO_FILE_LISTING_TTL)
+		return FALSE;
+
+	GStatBuf buf;
+	return ctx->mtime_settled && !g_stat(ctx->path, &buf) && buf.st_mtime == ctx->mtime;
+}
+
+/**
+ * Get the listing of a directory.
+ *
+ * Listings are cached, so this will usually not read the directory again.
+ * They are read again when the directory's modification
+ * time changes or after a few seconds.
+ * On Linux, cached listings are additionally invalidated via inotify.
+ *
+ * @param dirname Directory name. It may be relative or empty
+ *                for the current working directory.
+ * @return New reference to the listing or NULL if the directory
+ *         cannot be read.
+ *         It must be released with teco_file_listing_unref().
+ *
+ * @memberof teco_file_listing_t
+ */
+teco_file_listing_t *
+teco_file_listing_get(const gchar *dirname)
+{
+	/* relative paths would break when changing the working directory */
+	gchar *path = teco_file_get_absolute_path(*dirname ? dirname : ".");
+
+#ifdef TECO_FILE_INOTIFY
+	teco_file_listings_poll();
+#endif
+
+	teco_file_listing_t *ctx = g_hash_table_lookup(teco_file_listings, path);
+	if (ctx) {
+		if (teco_file_listing_is_valid(ctx)) {
+			g_free(path);
+			return teco_file_listing_ref(ctx);
+		}
+
+		g_hash_table_remove(teco_file_listings, path);
+	} else if (g_hash_table_size(teco_file_listings) >= TECO_FILE_LISTING_CACHE_SIZE) {
+		g_hash_table_remove_all(teco_file_listings);
+	}
+
+	ctx = teco_file_listing_read(path);
+	if (!ctx)
+		return NULL;
+
+	g_hash_table_insert(teco_file_listings, ctx->path, ctx);
+	return teco_file_listing_ref(ctx);
+}
+
+/** @memberof teco_file_listing_t */
+void
+teco_file_listing_unref(teco_file_listing_t *ctx)
+{
+	if (--ctx->ref_count > 0)
+		return;
+
+	g_array_free(ctx->entries, TRUE);
+	g_string_chunk_free(ctx->chunk);
+	g_free(ctx->path);
+	g_free(ctx);
+}
+
+/**
+ * Test a directory entry's file type.
+ *
+ * This is equivalent to g_file_test(), but the entry types
+ * of listings usually avoid any system calls.
+ *
+ * @param entry Entry of a directory listing.
+ * @param filename Name of the entry including its directory component.
+ * @param test File tests to perform.
+ * @return TRUE if any of the tests is true.
+ */
+gboolean
+teco_file_listing_entry_test(teco_file_listing_entry_t *entry,
+                             const gchar *filename, GFileTest test)
+{
+	if (test & G_FILE_TEST_EXISTS)
+		/* listed entries always exist */
+		return TRUE;
+	if (test & ~(G_FILE_TEST_IS_REGULAR | G_FILE_TEST_IS_DIR))
+		return g_file_test(filename, test);
+
+	if (!entry->type) {
+		/* this follows symlinks just like g_file_test() */
+		GStatBuf buf;
+		if (g_stat(filename, &buf))
+			entry->type = G_FILE_TEST_EXISTS;
+		else if (S_ISDIR(buf.st_mode))
+			entry->type = G_FILE_TEST_IS_DIR;
+		else if (S_ISREG(buf.st_mode))
+			entry->type = G_FILE_TEST_IS_REGULAR;
+		else
+			entry->type = G_FILE_TEST_EXISTS;
+	}
+
+	return (entry->type & test) != 0;
+}
+
+static void TECO_DEBUG_CLEANUP
+teco_file_listings_cleanup(void)
+{
+	g_hash_table_destroy(teco_file_listings);
+#ifdef TECO_FILE_INOTIFY
+	if (teco_file_inotify_fd >= 0)
+		close(teco_file_inotify_fd);
+#endif
+}
+
 /**
  * Auto-complete a filename/directory.
  *
@@ -390,8 +736,8 @@ teco_file_auto_complete(const gchar *filename, GFileTest file_test, teco_string_
 	gchar *basename = filename_expanded + dirname_len;
 	gsize basename_len = strlen(basename);
 
-	g_autoptr(GDir) dir = g_dir_open(dirname_len ? dirname : ".", 0, NULL);
-	if (!dir)
+	g_autoptr(teco_file_listing_t) listing = teco_file_listing_get(dirname);
+	if (!listing)
 		return FALSE;
 
 	/* Whether the directory has case-sensitive entries */
@@ -415,11 +761,12 @@ teco_file_auto_complete(const gchar *filename, GFileTest file_test, teco_string_
 	guint files_len = 0;
 	gsize prefix_len = 0;
 
-	teco_string_t cur_basename;
-	while ((cur_basename.data = (gchar *)g_dir_read_name(dir))) {
-		cur_basename.len = strlen(cur_basename.data);
+	for (guint i = 0; i < listing->entries->len; i++) {
+		teco_file_listing_entry_t *entry = &g_array_index(listing->entries,
+		                                                  teco_file_listing_entry_t, i);
+		const teco_string_t *cur_basename = &entry->name;
 
-		if (string_diff(&cur_basename, basename, basename_len) != basename_len)
+		if (string_diff(cur_basename, basename, basename_len) != basename_len)
 			/* basename is not a prefix of cur_basename */
 			continue;
 
@@ -428,22 +775,17 @@ teco_file_auto_complete(const gchar *filename, GFileTest file_test, teco_string_
 		 * Reserving one byte at the end of the filename ensures we can easily
 		 * append the directory separator without reallocations.
 		 */
-		gchar *cur_filename = g_malloc(strlen(dirname)+cur_basename.len+2);
-		strcat(strcpy(cur_filename, dirname), cur_basename.data);
+		gchar *cur_filename = g_malloc(strlen(dirname)+cur_basename->len+2);
+		strcat(strcpy(cur_filename, dirname), cur_basename->data);
 
-		/*
-		 * NOTE: This avoids g_file_test() for G_FILE_TEST_EXISTS
-		 * since the file we process here should always exist.
-		 */
 		if ((!*basename && !teco_file_is_visible(cur_filename)) ||
-		    (file_test != G_FILE_TEST_EXISTS &&
-		     !g_file_test(cur_filename, file_test))) {
+		    !teco_file_listing_entry_test(entry, cur_filename, file_test)) {
 			g_free(cur_filename);
 			continue;
 		}
 
 		if (file_test == G_FILE_TEST_IS_DIR ||
-		    g_file_test(cur_filename, G_FILE_TEST_IS_DIR))
+		    teco_file_listing_entry_test(entry, cur_filename, G_FILE_TEST_IS_DIR))
 			strcat(cur_filename, dir_sep);
 
 		files = g_slist_prepend(files, cur_filename);
@@ -483,7 +825,7 @@ teco_file_auto_complete(const gchar *filename, GFileTest file_test, teco_string_
 			                         strlen((gchar *)file->data), is_buffer);
 		}
 
-		teco_interface_popup_show(filename_len);
+		teco_interface_popup_show(filename_len, case_sensitive);
 	}
 
 	/*
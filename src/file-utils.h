@@ -115,4 +115,61 @@ teco_file_is_dir(const gchar *filename)
 	return G_IS_DIR_SEPARATOR(c);
 }
 
+typedef struct {
+	/** Name of the entry without directory component */
+	teco_string_t name;
+	/**
+	 * File type as G_FILE_TEST_IS_REGULAR or G_FILE_TEST_IS_DIR,
+	 * G_FILE_TEST_EXISTS for other types or 0 if not yet known.
+	 */
+	GFileTest type;
+} teco_file_listing_entry_t;
+
+/**
+ * Cached listing of a directory.
+ *
+ * Listings are shared by all users and must not be modified,
+ * except for resolving entry types.
+ * Since they are reference counted, a listing stays valid
+ * even when the cache drops it.
+ */
+typedef struct {
+	gint ref_count;
+	/** Absolute path of the directory, also the cache key */
+	gchar *path;
+
+	/** Array of teco_file_listing_entry_t */
+	GArray *entries;
+	/** String chunk for all entry names */
+	GStringChunk *chunk;
+
+	/** Monotonic time of reading the directory for the TTL */
+	gint64 read_time;
+	/** Modification time of the directory when it was read */
+	gint64 mtime;
+	/** Whether mtime was already in the past when reading */
+	gboolean mtime_settled;
+
+	/** inotify watch descriptor or -1 */
+	gint wd;
+	/** Cleared when the watch reports a change */
+	gboolean valid;
+} teco_file_listing_t;
+
+teco_file_listing_t *teco_file_listing_get(const gchar *dirname);
+gboolean teco_file_listing_entry_test(teco_file_listing_entry_t *entry,
+                                      const gchar *filename, GFileTest test);
+
+/** @memberof teco_file_listing_t */
+static inline teco_file_listing_t *
+teco_file_listing_ref(teco_file_listing_t *ctx)
+{
+	ctx->ref_count++;
+	return ctx;
+}
+
+void teco_file_listing_unref(teco_file_listing_t *ctx);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(teco_file_listing_t, teco_file_listing_unref);
+
 gboolean teco_file_auto_complete(const gchar *filename, GFileTest file_test, teco_string_t *insert);
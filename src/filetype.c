@@ -0,0 +1,745 @@
+/*
+ * Copyright (C) 2012-2025 Robin Haberkorn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gprintf.h>
+
+#include "sciteco.h"
+#include "string-utils.h"
+#include "file-utils.h"
+#include "interface.h"
+#include "parser.h"
+#include "core-commands.h"
+#include "expressions.h"
+#include "qreg.h"
+#include "ring.h"
+#include "search.h"
+#include "glob.h"
+#include "error.h"
+#include "undo.h"
+#include "filetype.h"
+
+/*
+ * FIXME: This state could be static.
+ */
+TECO_DECLARE_STATE(teco_state_filetype_pattern);
+
+/**
+ * A single file type registration.
+ *
+ * Registrations are only ever appended (and removed from the end
+ * on rubout), so the lookup index can always be rebuilt
+ * from this list.
+ */
+typedef struct {
+	/** Whether `pattern` is a regular expression matched against the first line */
+	gboolean header;
+	/** Name of the global Q-Register to execute on a match */
+	gchar *setter;
+	/** Glob pattern or regular expression (if `header` is set) */
+	gchar *pattern;
+} teco_filetype_entry_t;
+
+static void
+teco_filetype_entry_clear(teco_filetype_entry_t *entry)
+{
+	g_free(entry->setter);
+	g_free(entry->pattern);
+}
+
+static GArray *teco_filetype_entries;
+
+static guint
+teco_filetype_entry_hash(gconstpointer key)
+{
+	const teco_filetype_entry_t *entry = key;
+	guint hash = g_str_hash(entry->setter)*31 + g_str_hash(entry->pattern);
+	return hash*2 + (entry->header ? 1 : 0);
+}
+
+static gboolean
+teco_filetype_entry_equal(gconstpointer a, gconstpointer b)
+{
+	const teco_filetype_entry_t *ea = a, *eb = b;
+	return ea->header == eb->header &&
+	       !strcmp(ea->setter, eb->setter) && !strcmp(ea->pattern, eb->pattern);
+}
+
+/**
+ * Set of all registrations in teco_filetype_entries
+ * for detecting repeated registrations.
+ *
+ * The keys are copies of the entries, sharing their strings.
+ */
+static GHashTable *teco_filetype_registered;
+
+typedef struct {
+	GRegex *regex;
+	guint ordinal;
+} teco_filetype_glob_t;
+
+/**
+ * Lookup index derived from teco_filetype_entries.
+ *
+ * Every setter is assigned an ordinal at its first registration.
+ * If several setters match, the one with the smallest ordinal wins,
+ * which is the order the old `lexer.auto` macro probed in.
+ * Most registrations are plain file extensions or base names,
+ * so they can be looked up in hash tables instead of
+ * matching every glob pattern in turn.
+ */
+static struct {
+	gboolean valid;
+
+	/** Setter names (owned by teco_filetype_entries) indexed by ordinal */
+	GPtrArray *setters;
+
+	/** Maps extensions (`*.EXT`) to ordinal+1 */
+	GHashTable *extensions;
+	/** Maps base names (`*\/NAME`) to ordinal+1 */
+	GHashTable *basenames;
+	/** All other globs as teco_filetype_glob_t */
+	GArray *globs;
+
+	/** All header patterns combined into a single regular expression */
+	gchar *headers_pattern;
+	/** Maps header alternatives to their ordinals */
+	GArray *headers_ordinals;
+	/** Smallest ordinal of any header pattern */
+	guint headers_min;
+
+	/** Compiled headers_pattern, cached until the flags change */
+	GRegex *headers;
+	GRegexCompileFlags headers_flags;
+} teco_filetype_index;
+
+static void __attribute__((constructor))
+teco_filetype_init(void)
+{
+	teco_filetype_entries = g_array_new(FALSE, FALSE, sizeof(teco_filetype_entry_t));
+	g_array_set_clear_func(teco_filetype_entries,
+	                       (GDestroyNotify)teco_filetype_entry_clear);
+	teco_filetype_registered = g_hash_table_new_full(teco_filetype_entry_hash,
+	                                                 teco_filetype_entry_equal,
+	                                                 g_free, NULL);
+}
+
+static void
+teco_filetype_index_clear(void)
+{
+	if (teco_filetype_index.setters)
+		g_ptr_array_free(teco_filetype_index.setters, TRUE);
+	if (teco_filetype_index.extensions)
+		g_hash_table_destroy(teco_filetype_index.extensions);
+	if (teco_filetype_index.basenames)
+		g_hash_table_destroy(teco_filetype_index.basenames);
+	if (teco_filetype_index.globs) {
+		for (guint i = 0; i < teco_filetype_index.globs->len; i++)
+			g_regex_unref(g_array_index(teco_filetype_index.globs,
+			                            teco_filetype_glob_t, i).regex);
+		g_array_free(teco_filetype_index.globs, TRUE);
+	}
+	g_free(teco_filetype_index.headers_pattern);
+	if (teco_filetype_index.headers_ordinals)
+		g_array_free(teco_filetype_index.headers_ordinals, TRUE);
+	if (teco_filetype_index.headers)
+		g_regex_unref(teco_filetype_index.headers);
+
+	memset(&teco_filetype_index, 0, sizeof(teco_filetype_index));
+}
+
+static void
+teco_filetype_index_insert(GHashTable *table, const gchar *key, guint ordinal)
+{
+	/*
+	 * The entries are iterated in registration order, so the first
+	 * ordinal inserted is not necessarily the smallest one.
+	 */
+	guint cur = GPOINTER_TO_UINT(g_hash_table_lookup(table, key));
+	if (!cur || ordinal+1 < cur)
+		g_hash_table_insert(table, (gpointer)key, GUINT_TO_POINTER(ordinal+1));
+}
+
+typedef struct {
+	guint ordinal;
+	guint entry;
+} teco_filetype_header_t;
+
+static gint
+teco_filetype_header_cmp(gconstpointer a, gconstpointer b)
+{
+	const teco_filetype_header_t *ha = a, *hb = b;
+
+	if (ha->ordinal != hb->ordinal)
+		return ha->ordinal < hb->ordinal ? -1 : 1;
+	return ha->entry < hb->entry ? -1 : ha->entry > hb->entry;
+}
+
+static void
+teco_filetype_index_build(void)
+{
+	if (teco_filetype_index.valid)
+		return;
+	teco_filetype_index_clear();
+
+	teco_filetype_index.setters = g_ptr_array_new();
+	teco_filetype_index.extensions = g_hash_table_new(g_str_hash, g_str_equal);
+	teco_filetype_index.basenames = g_hash_table_new(g_str_hash, g_str_equal);
+	teco_filetype_index.globs = g_array_new(FALSE, FALSE, sizeof(teco_filetype_glob_t));
+	teco_filetype_index.headers_ordinals = g_array_new(FALSE, FALSE, sizeof(guint));
+	teco_filetype_index.headers_min = G_MAXUINT;
+
+	g_autoptr(GHashTable) ordinals = g_hash_table_new(g_str_hash, g_str_equal);
+	g_autoptr(GArray) headers = g_array_new(FALSE, FALSE, sizeof(teco_filetype_header_t));
+
+	for (guint i = 0; i < teco_filetype_entries->len; i++) {
+		teco_filetype_entry_t *entry = &g_array_index(teco_filetype_entries,
+		                                              teco_filetype_entry_t, i);
+
+		gpointer value;
+		guint ordinal;
+		if (g_hash_table_lookup_extended(ordinals, entry->setter, NULL, &value)) {
+			ordinal = GPOINTER_TO_UINT(value);
+		} else {
+			ordinal = teco_filetype_index.setters->len;
+			g_ptr_array_add(teco_filetype_index.setters, entry->setter);
+			g_hash_table_insert(ordinals, entry->setter, GUINT_TO_POINTER(ordinal));
+		}
+
+		if (entry->header) {
+			teco_filetype_header_t header = {ordinal, i};
+			g_array_append_val(headers, header);
+			teco_filetype_index.headers_min = MIN(teco_filetype_index.headers_min, ordinal);
+			continue;
+		}
+
+		const gchar *p = entry->pattern;
+		if (p[0] == '*' && p[1] == '.' && p[2] && !strpbrk(p+2, "*?[./\\")) {
+			teco_filetype_index_insert(teco_filetype_index.extensions, p+2, ordinal);
+		} else if (p[0] == '*' && p[1] == '/' && p[2] && !strpbrk(p+2, "*?[/\\")) {
+			teco_filetype_index_insert(teco_filetype_index.basenames, p+2, ordinal);
+		} else {
+			teco_filetype_glob_t glob = {teco_globber_compile_pattern(p), ordinal};
+			g_array_append_val(teco_filetype_index.globs, glob);
+		}
+	}
+
+	/*
+	 * Header alternatives are sorted by ordinal, so the first
+	 * alternative that matches is also the one that would have been
+	 * tried first.
+	 */
+	g_array_sort(headers, teco_filetype_header_cmp);
+	if (headers->len > 0) {
+		GString *pattern = g_string_new(NULL);
+
+		for (guint i = 0; i < headers->len; i++) {
+			teco_filetype_header_t *header = &g_array_index(headers, teco_filetype_header_t, i);
+			teco_filetype_entry_t *entry = &g_array_index(teco_filetype_entries,
+			                                              teco_filetype_entry_t, header->entry);
+
+			g_string_append_printf(pattern, "%s(?<h%u>%s)", i ? "|" : "", i, entry->pattern);
+			g_array_append_val(teco_filetype_index.headers_ordinals, header->ordinal);
+		}
+
+		teco_filetype_index.headers_pattern = g_string_free(pattern, FALSE);
+	}
+
+	teco_filetype_index.valid = TRUE;
+}
+
+static inline void
+teco_filetype_remove_last(void)
+{
+	g_hash_table_remove(teco_filetype_registered,
+	                    &g_array_index(teco_filetype_entries, teco_filetype_entry_t,
+	                                   teco_filetype_entries->len-1));
+	g_array_remove_index(teco_filetype_entries, teco_filetype_entries->len-1);
+	teco_filetype_index.valid = FALSE;
+}
+TECO_DEFINE_UNDO_CALL(teco_filetype_remove_last);
+
+static void
+teco_filetype_add(gboolean header, const gchar *setter, gchar *pattern)
+{
+	/*
+	 * Lexers may be munged again when their setters are
+	 * loaded lazily, so repeated registrations are ignored.
+	 */
+	teco_filetype_entry_t key = {header, (gchar *)setter, pattern};
+	if (g_hash_table_contains(teco_filetype_registered, &key)) {
+		g_free(pattern);
+		return;
+	}
+
+	teco_filetype_entry_t entry = {header, g_strdup(setter), pattern};
+	g_array_append_val(teco_filetype_entries, entry);
+	teco_filetype_entry_t *copy = g_new(teco_filetype_entry_t, 1);
+	*copy = entry;
+	g_hash_table_add(teco_filetype_registered, copy);
+	teco_filetype_index.valid = FALSE;
+	undo__teco_filetype_remove_last();
+}
+
+/**
+ * Get the number of file type registrations.
+ *
+ * Since registrations are only ever appended, this can be used
+ * to find the registrations added in the meantime
+ * (see teco_filetype_get()).
+ */
+guint
+teco_filetype_count(void)
+{
+	return teco_filetype_entries->len;
+}
+
+/**
+ * Get a file type registration, e.g. for recording it into
+ * a state image.
+ *
+ * @param i Index of the registration, smaller than teco_filetype_count().
+ * @param header Where to store whether the pattern is a header pattern.
+ * @param setter Where to store the setter's Q-Register name.
+ * @param pattern Where to store the glob pattern or regular expression.
+ */
+void
+teco_filetype_get(guint i, gboolean *header, const gchar **setter, const gchar **pattern)
+{
+	const teco_filetype_entry_t *entry = &g_array_index(teco_filetype_entries,
+	                                                    teco_filetype_entry_t, i);
+
+	*header = entry->header;
+	*setter = entry->setter;
+	*pattern = entry->pattern;
+}
+
+/**
+ * Register a file type just like `ET`,
+ * e.g. when restoring it from a state image.
+ */
+void
+teco_filetype_register(gboolean header, const gchar *setter, const gchar *pattern)
+{
+	teco_filetype_add(header, setter, g_strdup(pattern));
+}
+
+/**
+ * Get the file name of the current buffer for matching it
+ * against glob patterns.
+ *
+ * @return The file name with "/" as the directory separator
+ *   or NULL if the current document is not a buffer with a file name.
+ *   It must be freed with g_free().
+ */
+static gchar *
+teco_filetype_get_filename(void)
+{
+	if (teco_qreg_current || !teco_ring_current || !teco_ring_current->filename)
+		return NULL;
+
+	gchar *filename = g_strdup(teco_ring_current->filename);
+#ifdef G_OS_WIN32
+	/* patterns always use "/" as the directory separator */
+	g_strdelimit(filename, "\\", '/');
+#endif
+	return filename;
+}
+
+/**
+ * Get the first line of the current document
+ * for matching it against header patterns.
+ */
+static const gchar *
+teco_filetype_get_first_line(sptr_t *len)
+{
+	*len = teco_interface_ssm(SCI_POSITIONFROMLINE, 1, 0);
+	if (*len < 0)
+		*len = teco_interface_ssm(SCI_GETLENGTH, 0, 0);
+	return (const gchar *)teco_interface_ssm(SCI_GETRANGEPOINTER, 0, *len);
+}
+
+/**
+ * Get the regular expression flags for matching header patterns,
+ * which depend on the search mode (^X) of the given machine
+ * and the current document's codepage.
+ */
+static gboolean
+teco_filetype_get_header_flags(teco_machine_main_t *ctx, GRegexCompileFlags *flags, GError **error)
+{
+	*flags = G_REGEX_MULTILINE | G_REGEX_DOTALL | G_REGEX_ANCHORED;
+
+	teco_qreg_t *reg = teco_qreg_table_find(ctx->qreg_table_locals, "\x18", 1); /* ^X */
+	g_assert(reg != NULL);
+	teco_bool_t search_mode;
+	if (!reg->vtable->get_integer(reg, &search_mode, error))
+		return FALSE;
+	if (teco_is_failure(search_mode))
+		*flags |= G_REGEX_CASELESS;
+	if (teco_interface_get_codepage() != SC_CP_UTF8)
+		*flags |= G_REGEX_RAW;
+
+	return TRUE;
+}
+
+/**
+ * Match the first line of the current document against all header patterns.
+ *
+ * @return The ordinal of the first matching header alternative
+ *   or G_MAXUINT.
+ */
+static gboolean
+teco_filetype_match_header(GRegexCompileFlags flags, guint *ordinal, GError **error)
+{
+	*ordinal = G_MAXUINT;
+
+	if (!teco_filetype_index.headers_pattern)
+		return TRUE;
+
+	if (!teco_filetype_index.headers || teco_filetype_index.headers_flags != flags) {
+		if (teco_filetype_index.headers)
+			g_regex_unref(teco_filetype_index.headers);
+		teco_filetype_index.headers = g_regex_new(teco_filetype_index.headers_pattern,
+		                                          flags, 0, error);
+		if (!teco_filetype_index.headers)
+			return FALSE;
+		teco_filetype_index.headers_flags = flags;
+	}
+
+	sptr_t len;
+	const gchar *line = teco_filetype_get_first_line(&len);
+
+	g_autoptr(GMatchInfo) info = NULL;
+	if (!g_regex_match_full(teco_filetype_index.headers, line, len, 0, 0, &info, NULL))
+		return TRUE;
+
+	for (guint i = 0; i < teco_filetype_index.headers_ordinals->len; i++) {
+		gchar name[16];
+		gint start = -1;
+
+		g_snprintf(name, sizeof(name), "h%u", i);
+		if (g_match_info_fetch_named_pos(info, name, &start, NULL) && start >= 0) {
+			*ordinal = g_array_index(teco_filetype_index.headers_ordinals, guint, i);
+			break;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Find the file type setter for the current document.
+ *
+ * @param ctx The machine whose search mode (^X) applies to header patterns.
+ * @param setter Where to store the name of the setter's Q-Register
+ *   or NULL if no registration matches.
+ *   The string is owned by the file type registry.
+ * @param error A GError.
+ * @return FALSE if an error occurred.
+ */
+static gboolean
+teco_filetype_detect(teco_machine_main_t *ctx, const gchar **setter, GError **error)
+{
+	*setter = NULL;
+
+	teco_filetype_index_build();
+
+	guint best = G_MAXUINT;
+
+	g_autofree gchar *filename = teco_filetype_get_filename();
+	if (filename) {
+		const gchar *basename = strrchr(filename, '/');
+		if (basename) {
+			guint ordinal = GPOINTER_TO_UINT(g_hash_table_lookup(teco_filetype_index.basenames,
+			                                                     basename+1));
+			if (ordinal)
+				best = MIN(best, ordinal-1);
+			basename++;
+		} else {
+			basename = filename;
+		}
+
+		const gchar *ext = strrchr(basename, '.');
+		if (ext) {
+			guint ordinal = GPOINTER_TO_UINT(g_hash_table_lookup(teco_filetype_index.extensions,
+			                                                     ext+1));
+			if (ordinal)
+				best = MIN(best, ordinal-1);
+		}
+
+		for (guint i = 0; i < teco_filetype_index.globs->len; i++) {
+			teco_filetype_glob_t *glob = &g_array_index(teco_filetype_index.globs,
+			                                            teco_filetype_glob_t, i);
+			if (glob->ordinal < best && g_regex_match(glob->regex, filename, 0, NULL))
+				best = glob->ordinal;
+		}
+	}
+
+	if (teco_filetype_index.headers_min < best) {
+		GRegexCompileFlags flags;
+		if (!teco_filetype_get_header_flags(ctx, &flags, error))
+			return FALSE;
+
+		guint ordinal;
+		if (!teco_filetype_match_header(flags, &ordinal, error))
+			return FALSE;
+		best = MIN(best, ordinal);
+	}
+
+	if (best < teco_filetype_index.setters->len)
+		*setter = g_ptr_array_index(teco_filetype_index.setters, best);
+	return TRUE;
+}
+
+/**
+ * Test whether the current document matches any registration
+ * of the given setter.
+ *
+ * Unlike teco_filetype_detect(), this ignores all other setters,
+ * so it is not affected by the order of registrations.
+ * It is not used for detection, so the registrations
+ * are matched one by one without building the index.
+ *
+ * @param ctx The machine whose search mode (^X) applies to header patterns.
+ * @param setter The setter's Q-Register name.
+ * @param matched Where to store whether any registration matches.
+ * @param error A GError.
+ * @return FALSE if an error occurred.
+ */
+static gboolean
+teco_filetype_test(teco_machine_main_t *ctx, const gchar *setter,
+                   gboolean *matched, GError **error)
+{
+	*matched = FALSE;
+
+	g_autofree gchar *filename = teco_filetype_get_filename();
+	GRegexCompileFlags flags = 0;
+
+	for (guint i = 0; i < teco_filetype_entries->len && !*matched; i++) {
+		teco_filetype_entry_t *entry = &g_array_index(teco_filetype_entries,
+		                                              teco_filetype_entry_t, i);
+		if (strcmp(entry->setter, setter))
+			continue;
+
+		if (!entry->header) {
+			if (!filename)
+				continue;
+			g_autoptr(GRegex) re = teco_globber_compile_pattern(entry->pattern);
+			*matched = g_regex_match(re, filename, 0, NULL);
+			continue;
+		}
+
+		if (!flags && !teco_filetype_get_header_flags(ctx, &flags, error))
+			return FALSE;
+		g_autoptr(GRegex) re = g_regex_new(entry->pattern, flags, 0, error);
+		if (!re)
+			return FALSE;
+		sptr_t len;
+		const gchar *line = teco_filetype_get_first_line(&len);
+		*matched = g_regex_match_full(re, line, len, 0, 0, NULL, NULL);
+	}
+
+	return TRUE;
+}
+
+/*
+ * Command States
+ */
+
+static teco_string_t teco_filetype_setter = {NULL, 0};
+
+static void TECO_DEBUG_CLEANUP
+teco_filetype_cleanup(void)
+{
+	teco_filetype_index_clear();
+	g_hash_table_destroy(teco_filetype_registered);
+	g_array_free(teco_filetype_entries, TRUE);
+	teco_string_clear(&teco_filetype_setter);
+}
+
+static teco_state_t *
+teco_state_filetype_setter_done(teco_machine_main_t *ctx, const teco_string_t *str, GError **error)
+{
+	if (ctx->flags.mode > TECO_MODE_NORMAL)
+		return &teco_state_filetype_pattern;
+
+	if (teco_string_contains(str, '\0')) {
+		teco_error_qregcontainsnull_set(error, str->data, str->len, FALSE);
+		return NULL;
+	}
+
+	teco_undo_string_own(teco_filetype_setter);
+	teco_string_init(&teco_filetype_setter, str->data, str->len);
+
+	return &teco_state_filetype_pattern;
+}
+
+/*$ "ET" ":ET" filetype lexer
+ * ET[setter]$[glob]$ -- Register or detect file types
+ * :ET[setter]$[pattern]$
+ * ET[setter]$$ -> Success|Failure
+ * ET$$
+ * :ET$$ -> Success|Failure
+ *
+ * Maintains an index of file types, which is used by the
+ * standard library to choose lexers for newly edited documents.
+ * Every file type is identified by the name of a global
+ * <setter> Q-Register, e.g. \(lqlexer.set.cpp\(rq, which is
+ * executed when the file type is detected.
+ *
+ * In the first form, the file name \fIglob\fP pattern
+ * is registered for <setter>.
+ * The glob pattern is matched against the entire
+ * file name, just like \fBEN\fP does.
+ * Patterns of the form \(lq*.\fIext\fP\(rq and
+ * \(lq*/\fIname\fP\(rq are resolved using hash tables,
+ * so registering many of them does not slow down detection.
+ * Glob patterns are case-sensitive on all platforms, again
+ * like with \fBEN\fP, and always use \(lq/\(rq as the
+ * directory separator, even on Windows.
+ * In the second, colon-modified form, the search <pattern>
+ * is registered for <setter>.
+ * It is matched against the beginning of the document's
+ * first line, just like an anchored search (\fB::S\fP).
+ * Pattern matching characters are supported, but string
+ * building is performed when the pattern is registered.
+ * Registering the same <setter> multiple times is allowed
+ * and is the common case when a file type has several
+ * extensions.
+ * Registering the same <pattern> for the same <setter> again
+ * has no effect.
+ * Registrations are undone on rubout.
+ *
+ * If only <setter> is given, this command tests whether
+ * the current buffer matches any file name or header pattern
+ * registered for <setter> and returns a condition boolean.
+ * Other file types are ignored, so unlike detection this
+ * does not depend on the order of registrations.
+ * The colon modifier has no effect in this form.
+ * This can be used to define lexer test macros
+ * without repeating the patterns.
+ *
+ * When both string arguments are empty,
+ * the file type of the current buffer is detected
+ * and the corresponding <setter> Q-Register is executed
+ * as a macro with the caller's local Q-Register table
+ * (like \fB:M\fP).
+ * Both the buffer's file name and the first line of the
+ * document are considered.
+ * If several file types match, the <setter> that was
+ * registered first wins.
+ * If colon-modified, this form returns a condition boolean
+ * signalling whether a file type has been detected.
+ * Otherwise, nothing happens if no file type matches.
+ *
+ * String building characters are enabled for both string
+ * arguments.
+ */
+TECO_DEFINE_STATE_EXPECTSTRING(teco_state_filetype_setter,
+	.expectstring.last = FALSE
+);
+
+static teco_state_t *
+teco_state_filetype_pattern_done(teco_machine_main_t *ctx, const teco_string_t *str, GError **error)
+{
+	if (ctx->flags.mode > TECO_MODE_NORMAL)
+		return &teco_state_start;
+
+	gboolean colon_modified = teco_machine_main_eval_colon(ctx) > 0;
+
+	if (!teco_filetype_setter.len && !str->len) {
+		/*
+		 * Detect the file type
+		 */
+		const gchar *setter;
+		if (!teco_filetype_detect(ctx, &setter, error))
+			return NULL;
+
+		if (setter) {
+			teco_qreg_t *qreg = teco_qreg_table_find(&teco_qreg_table_globals,
+			                                         setter, strlen(setter));
+			if (!qreg) {
+				teco_error_invalidqreg_set(error, setter, strlen(setter), FALSE);
+				return NULL;
+			}
+			if (!teco_qreg_execute(qreg, ctx->qreg_table_locals, error))
+				return NULL;
+		}
+
+		if (colon_modified)
+			teco_expressions_push(teco_bool(setter != NULL));
+		return &teco_state_start;
+	}
+
+	if (!teco_filetype_setter.len) {
+		g_set_error_literal(error, TECO_ERROR, TECO_ERROR_FAILED,
+		                    "Missing file type setter for <ET>");
+		return NULL;
+	}
+
+	if (!str->len) {
+		/*
+		 * Test for the given file type
+		 */
+		gboolean matched;
+		if (!teco_filetype_test(ctx, teco_filetype_setter.data, &matched, error))
+			return NULL;
+		teco_expressions_push(teco_bool(matched));
+		return &teco_state_start;
+	}
+
+	if (teco_string_contains(str, '\0')) {
+		g_set_error_literal(error, TECO_ERROR, TECO_ERROR_FAILED,
+		                    "Invalid file type pattern for <ET>");
+		return NULL;
+	}
+
+	if (!colon_modified) {
+		teco_filetype_add(FALSE, teco_filetype_setter.data,
+		                  teco_file_expand_path(str->data));
+		return &teco_state_start;
+	}
+
+	g_autoptr(teco_machine_qregspec_t) qreg_machine;
+	qreg_machine = teco_machine_qregspec_new(TECO_QREG_REQUIRED, ctx->qreg_table_locals, FALSE);
+
+	teco_string_t pattern = *str;
+	/* NOTE: teco_pattern2regexp() modifies str pointer */
+	g_autofree gchar *re_pattern = teco_pattern2regexp(&pattern, qreg_machine,
+	                                                   ctx->expectstring.machine.codepage,
+	                                                   FALSE, error);
+	if (!re_pattern)
+		return NULL;
+
+	/*
+	 * Make sure that the combined header pattern will always compile.
+	 */
+	g_autoptr(GRegex) re = g_regex_new(re_pattern, G_REGEX_MULTILINE | G_REGEX_DOTALL,
+	                                   0, error);
+	if (!re)
+		return NULL;
+
+	teco_filetype_add(TRUE, teco_filetype_setter.data, g_steal_pointer(&re_pattern));
+	return &teco_state_start;
+}
+
+TECO_DEFINE_STATE_EXPECTSTRING(teco_state_filetype_pattern);
@@ -36,6 +36,7 @@
 #include "ring.h"
 #include "error.h"
 #include "undo.h"
+#include "image.h"
 #include "glob.h"
 
 /*
@@ -65,8 +66,9 @@ teco_globber_init(teco_globber_t *ctx, const gchar *pattern, GFileTest test)
 	gsize dirname_len = teco_file_get_dirname_len(pattern);
 	ctx->dirname = g_strndup(pattern, dirname_len);
 
-	ctx->dir = g_dir_open(*ctx->dirname ? ctx->dirname : ".", 0, NULL);
+	ctx->listing = teco_file_listing_get(ctx->dirname);
 	/* if dirname does not exist, the result may be NULL */
+	teco_image_depend(ctx->dirname);
 
 	ctx->pattern = teco_globber_compile_pattern(pattern + dirname_len);
 }
@@ -75,26 +77,23 @@ teco_globber_init(teco_globber_t *ctx, const gchar *pattern, GFileTest test)
 gchar *
 teco_globber_next(teco_globber_t *ctx)
 {
-	const gchar *basename;
-
-	if (!ctx->dir)
+	if (!ctx->listing)
 		return NULL;
 
-	while ((basename = g_dir_read_name(ctx->dir))) {
-		if (!g_regex_match(ctx->pattern, basename, 0, NULL))
+	while (ctx->next_entry < ctx->listing->entries->len) {
+		teco_file_listing_entry_t *entry = &g_array_index(ctx->listing->entries,
+		                                                  teco_file_listing_entry_t,
+		                                                  ctx->next_entry++);
+		if (!g_regex_match(ctx->pattern, entry->name.data, 0, NULL))
 			continue;
 
 		/*
 		 * As dirname includes the directory separator,
 		 * we can simply concatenate dirname with basename.
 		 */
-		gchar *filename = g_strconcat(ctx->dirname, basename, NULL);
+		gchar *filename = g_strconcat(ctx->dirname, entry->name.data, NULL);
 
-		/*
-		 * No need to perform file test for EXISTS since
-		 * g_dir_read_name() will only return existing entries
-		 */
-		if (ctx->test == G_FILE_TEST_EXISTS || g_file_test(filename, ctx->test))
+		if (teco_file_listing_entry_test(entry, filename, ctx->test))
 			return filename;
 
 		g_free(filename);
@@ -109,8 +108,8 @@ teco_globber_clear(teco_globber_t *ctx)
 {
 	if (ctx->pattern)
 		g_regex_unref(ctx->pattern);
-	if (ctx->dir)
-		g_dir_close(ctx->dir);
+	if (ctx->listing)
+		teco_file_listing_unref(ctx->listing);
 	g_free(ctx->dirname);
 }
 
@@ -21,12 +21,14 @@
 #include <glib.h>
 
 #include "sciteco.h"
+#include "file-utils.h"
 #include "parser.h"
 
 typedef struct {
 	GFileTest test;
 	gchar *dirname;
-	GDir *dir;
+	teco_file_listing_t *listing;
+	guint next_entry;
 	GRegex *pattern;
 } teco_globber_t;
 
@@ -81,34 +81,72 @@ teco_help_topic_free(teco_help_topic_t *ctx)
 
 static teco_rb3str_tree_t teco_help_tree;
 
-static gboolean
-teco_help_init(GError **error)
-{
-	if (G_LIKELY(teco_help_chunk != NULL))
-		/* already loaded */
-		return TRUE;
+/**
+ * File name of the prebuilt topic index in the womanpage directory.
+ * It is generated by `sciteco --make-help-index` when installing
+ * the womanpages, so they don't have to be scanned on every startup.
+ */
+#define TECO_HELP_INDEX "topics.index"
+#define TECO_HELP_INDEX_MAGIC "TECOHLP2"
 
+/**
+ * Summary of all womanpages and their scripts in a directory.
+ *
+ * The index is stale if it differs from the summary stored
+ * in the index.
+ * The directory's modification time cannot be relied on, since
+ * package managers usually update files in place and preserve
+ * their modification times.
+ */
+typedef struct {
+	guint32 files;
+	guint32 reserved;
+	gint64 mtime;
+	guint64 size;
+} teco_help_stamp_t;
+
+/**
+ * Header of the topic index.
+ *
+ * It is followed by the topic entries, ordered the same way as
+ * in teco_help_tree, and the string data.
+ * All integers are stored in little-endian byte order and all
+ * offsets are relative to the beginning of the file,
+ * so the index can be used directly after mapping it into memory.
+ */
+typedef struct {
+	gchar magic[8];
+	guint32 count;
+	guint32 reserved;
+	teco_help_stamp_t stamp;
+} teco_help_index_header_t;
+
+typedef struct {
+	guint32 name_offset;
+	guint32 name_len;
+	/** null-terminated file name, relative to the womanpage directory */
+	guint32 filename_offset;
+	guint32 pos;
+} teco_help_index_entry_t;
+
+static gchar *teco_help_women_path = NULL;
+static GMappedFile *teco_help_index = NULL;
+static const teco_help_index_entry_t *teco_help_index_entries;
+static guint teco_help_index_count;
+
+static void
+teco_help_scan(const gchar *women_path)
+{
 	teco_help_chunk = g_string_chunk_new(32);
 	rb3_reset_tree(&teco_help_tree);
 
-	teco_qreg_t *lib_reg = teco_qreg_table_find(&teco_qreg_table_globals, "$SCITECOPATH", 12);
-	g_assert(lib_reg != NULL);
-	g_auto(teco_string_t) lib_path = {NULL, 0};
-	if (!lib_reg->vtable->get_string(lib_reg, &lib_path.data, &lib_path.len, NULL, error))
-		return FALSE;
-	/*
-	 * FIXME: lib_path may contain null-bytes.
-	 * It's not clear how to deal with this.
-	 */
-	g_autofree gchar *women_path = g_build_filename(lib_path.data, "women", NULL);
-
 	/*
 	 * FIXME: We might want to gracefully handle only the G_FILE_ERROR_NOENT
 	 * error and propagate all other errors?
 	 */
 	g_autoptr(GDir) women_dir = g_dir_open(women_path, 0, NULL);
 	if (!women_dir)
-		return TRUE;
+		return;
 
 	const gchar *basename;
 	while ((basename = g_dir_read_name(women_dir))) {
@@ -176,7 +214,161 @@ teco_help_init(GError **error)
 			teco_help_set(endptr+1, filename, pos);
 		} while ((topic = fgets(buffer, sizeof(buffer), file)));
 	}
+}
+
+static inline teco_string_t
+teco_help_index_get_name(guint i)
+{
+	const gchar *data = g_mapped_file_get_contents(teco_help_index);
+	teco_string_t name = {
+		(gchar *)data + GUINT32_FROM_LE(teco_help_index_entries[i].name_offset),
+		GUINT32_FROM_LE(teco_help_index_entries[i].name_len)
+	};
+	return name;
+}
 
+/**
+ * Summarize all womanpages and scripts in a directory
+ * (see teco_help_stamp_t).
+ *
+ * This only has to stat the files, which is much cheaper
+ * than scanning them.
+ * All integers are stored in little-endian byte order.
+ */
+static void
+teco_help_stamp(const gchar *women_path, teco_help_stamp_t *stamp)
+{
+	guint32 files = 0;
+	gint64 mtime = 0;
+	guint64 size = 0;
+
+	g_autoptr(GDir) women_dir = g_dir_open(women_path, 0, NULL);
+	const gchar *basename;
+	while (women_dir && (basename = g_dir_read_name(women_dir))) {
+		if (!g_str_has_suffix(basename, ".woman") &&
+		    !g_str_has_suffix(basename, ".woman.tec"))
+			continue;
+
+		g_autofree gchar *filename = g_build_filename(women_path, basename, NULL);
+		GStatBuf stat_buf;
+		if (g_stat(filename, &stat_buf))
+			continue;
+
+		files++;
+		mtime = MAX(mtime, stat_buf.st_mtime);
+		size += stat_buf.st_size;
+	}
+
+	memset(stamp, 0, sizeof(*stamp));
+	stamp->files = GUINT32_TO_LE(files);
+	stamp->mtime = GINT64_TO_LE(mtime);
+	stamp->size = GUINT64_TO_LE(size);
+}
+
+/**
+ * Map the topic index into memory.
+ *
+ * @return FALSE if there is no usable index,
+ *   so the womanpages have to be scanned instead.
+ */
+static gboolean
+teco_help_index_open(const gchar *women_path)
+{
+	g_autofree gchar *filename = g_build_filename(women_path, TECO_HELP_INDEX, NULL);
+
+	g_autoptr(GMappedFile) index = g_mapped_file_new(filename, FALSE, NULL);
+	if (!index)
+		return FALSE;
+	const gchar *data = g_mapped_file_get_contents(index);
+	gsize size = g_mapped_file_get_length(index);
+
+	const teco_help_index_header_t *header = (const teco_help_index_header_t *)data;
+	if (size < sizeof(*header) ||
+	    memcmp(header->magic, TECO_HELP_INDEX_MAGIC, sizeof(header->magic)))
+		goto invalid;
+
+	/* womanpages have been installed, removed or modified since generating the index */
+	teco_help_stamp_t stamp;
+	teco_help_stamp(women_path, &stamp);
+	if (memcmp(&header->stamp, &stamp, sizeof(stamp)))
+		return FALSE;
+
+	guint count = GUINT32_FROM_LE(header->count);
+	if ((size - sizeof(*header)) / sizeof(teco_help_index_entry_t) < count)
+		goto invalid;
+
+	/*
+	 * Make sure that all strings lie within the file,
+	 * so they don't have to be checked on every access.
+	 */
+	const teco_help_index_entry_t *entries = (const teco_help_index_entry_t *)(header+1);
+	for (guint i = 0; i < count; i++) {
+		gsize name_offset = GUINT32_FROM_LE(entries[i].name_offset);
+		gsize name_len = GUINT32_FROM_LE(entries[i].name_len);
+		gsize filename_offset = GUINT32_FROM_LE(entries[i].filename_offset);
+
+		if (name_offset >= size || name_len >= size - name_offset ||
+		    data[name_offset + name_len] != '\0' ||
+		    filename_offset >= size ||
+		    !memchr(data + filename_offset, '\0', size - filename_offset))
+			goto invalid;
+	}
+
+	teco_help_index = g_steal_pointer(&index);
+	teco_help_index_entries = entries;
+	teco_help_index_count = count;
+	return TRUE;
+
+invalid:
+	teco_interface_msg(TECO_MSG_WARNING,
+	                   "Invalid help topic index \"%s\"", filename);
+	return FALSE;
+}
+
+/**
+ * Find the first index entry that is not less than `str`.
+ */
+static guint
+teco_help_index_lower_bound(const gchar *str, gsize len)
+{
+	guint low = 0, high = teco_help_index_count;
+
+	while (low < high) {
+		guint mid = low + (high - low)/2;
+		teco_string_t name = teco_help_index_get_name(mid);
+		if (teco_string_casecmp(&name, str, len) < 0)
+			low = mid+1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+static gboolean
+teco_help_init(GError **error)
+{
+	if (G_LIKELY(teco_help_women_path != NULL))
+		/* already loaded */
+		return TRUE;
+
+	teco_qreg_t *lib_reg = teco_qreg_table_find(&teco_qreg_table_globals, "$SCITECOPATH", 12);
+	g_assert(lib_reg != NULL);
+	g_auto(teco_string_t) lib_path = {NULL, 0};
+	if (!lib_reg->vtable->get_string(lib_reg, &lib_path.data, &lib_path.len, NULL, error))
+		return FALSE;
+	/*
+	 * FIXME: lib_path may contain null-bytes.
+	 * It's not clear how to deal with this.
+	 */
+	teco_help_women_path = g_build_filename(lib_path.data, "women", NULL);
+
+	/*
+	 * Scanning requires opening every womanpage script,
+	 * so the prebuilt index is preferred.
+	 */
+	if (!teco_help_index_open(teco_help_women_path))
+		teco_help_scan(teco_help_women_path);
 	return TRUE;
 }
 
@@ -228,16 +420,162 @@ teco_help_set(const gchar *topic_name, const gchar *filename, teco_int_t pos)
 	teco_rb3str_insert(&teco_help_tree, FALSE, &topic->head);
 }
 
+/**
+ * Look up a help topic.
+ *
+ * @param topic_name The topic to look up.
+ * @param pos Set to the topic's position in the womanpage.
+ * @return The womanpage's file name, which must be freed,
+ *   or NULL if the topic does not exist.
+ */
+static gchar *
+teco_help_lookup(const gchar *topic_name, teco_int_t *pos)
+{
+	if (!teco_help_index) {
+		teco_help_topic_t *topic = teco_help_find(topic_name);
+		if (!topic)
+			return NULL;
+		*pos = topic->pos;
+		return g_strdup(topic->filename);
+	}
+
+	/* see teco_help_find() */
+	g_autofree gchar *term = teco_string_echo(topic_name, strlen(topic_name));
+	gsize term_len = strlen(term);
+	guint i = teco_help_index_lower_bound(term, term_len);
+	if (i == teco_help_index_count)
+		return NULL;
+	teco_string_t name = teco_help_index_get_name(i);
+	if (teco_string_casecmp(&name, term, term_len))
+		return NULL;
+
+	const gchar *data = g_mapped_file_get_contents(teco_help_index);
+	*pos = GUINT32_FROM_LE(teco_help_index_entries[i].pos);
+	return g_build_filename(teco_help_women_path,
+	                        data + GUINT32_FROM_LE(teco_help_index_entries[i].filename_offset),
+	                        NULL);
+}
+
+/**
+ * Auto-complete topic against the mapped index.
+ *
+ * This works like teco_rb3str_auto_complete().
+ */
+static gboolean
+teco_help_index_auto_complete(const gchar *str, gsize str_len, teco_string_t *insert)
+{
+	memset(insert, 0, sizeof(*insert));
+
+	guint first = teco_help_index_lower_bound(str, str_len);
+	teco_string_t first_name = {NULL, 0};
+	gsize prefix_len = 0;
+	guint end;
+
+	for (end = first; end < teco_help_index_count; end++) {
+		teco_string_t name = teco_help_index_get_name(end);
+		if (name.len < str_len || teco_string_casediff(&name, str, str_len) != str_len)
+			break;
+
+		if (G_UNLIKELY(end == first)) {
+			first_name = name;
+			prefix_len = name.len - str_len;
+		} else {
+			gsize len = teco_string_casediff(&name, first_name.data, first_name.len) - str_len;
+			if (len < prefix_len)
+				prefix_len = len;
+		}
+	}
+
+	if (prefix_len > 0) {
+		teco_string_init(insert, first_name.data + str_len, prefix_len);
+	} else if (end - first > 1) {
+		for (guint i = first; i < end; i++) {
+			teco_string_t name = teco_help_index_get_name(i);
+			teco_interface_popup_add(TECO_POPUP_PLAIN, name.data, name.len, FALSE);
+		}
+
+		teco_interface_popup_show(str_len, FALSE);
+	}
+
+	return end - first == 1;
+}
+
 gboolean
 teco_help_auto_complete(const gchar *topic_name, teco_string_t *insert)
 {
+	if (teco_help_index)
+		return teco_help_index_auto_complete(topic_name ? : "",
+		                                     topic_name ? strlen(topic_name) : 0, insert);
+
 	return teco_rb3str_auto_complete(&teco_help_tree, FALSE, topic_name,
 	                                 topic_name ? strlen(topic_name) : 0, 0, insert);
 }
 
+/**
+ * Generate the topic index for all womanpages in a directory.
+ *
+ * This is done when installing the womanpages
+ * (see `sciteco --make-help-index`).
+ */
+gboolean
+teco_help_write_index(const gchar *women_path, GError **error)
+{
+	teco_help_scan(women_path);
+
+	guint count = 0;
+	for (struct rb3_head *cur = rb3_get_min(&teco_help_tree); cur; cur = rb3_get_next(cur))
+		count++;
+
+	gsize strings_offset = sizeof(teco_help_index_header_t) +
+	                       count*sizeof(teco_help_index_entry_t);
+	g_autofree teco_help_index_entry_t *entries = g_new(teco_help_index_entry_t, count);
+	g_autoptr(GString) strings = g_string_new(NULL);
+	/* womanpage basename to string offset, since most pages define many topics */
+	g_autoptr(GHashTable) filenames = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+	guint i = 0;
+	for (struct rb3_head *cur = rb3_get_min(&teco_help_tree); cur; cur = rb3_get_next(cur)) {
+		teco_help_topic_t *topic = (teco_help_topic_t *)cur;
+
+		gchar *basename = g_path_get_basename(topic->filename);
+		gpointer filename_offset;
+		if (!g_hash_table_lookup_extended(filenames, basename, NULL, &filename_offset)) {
+			filename_offset = GSIZE_TO_POINTER(strings_offset + strings->len);
+			g_string_append_len(strings, basename, strlen(basename)+1);
+			g_hash_table_insert(filenames, basename, filename_offset);
+		} else {
+			g_free(basename);
+		}
+
+		entries[i].name_offset = GUINT32_TO_LE(strings_offset + strings->len);
+		entries[i].name_len = GUINT32_TO_LE(topic->head.name.len);
+		entries[i].filename_offset = GUINT32_TO_LE(GPOINTER_TO_SIZE(filename_offset));
+		entries[i].pos = GUINT32_TO_LE(topic->pos);
+		g_string_append_len(strings, topic->head.name.data, topic->head.name.len);
+		g_string_append_c(strings, '\0');
+		i++;
+	}
+
+	teco_help_index_header_t header = {.count = GUINT32_TO_LE(count)};
+	memcpy(header.magic, TECO_HELP_INDEX_MAGIC, sizeof(header.magic));
+	teco_help_stamp(women_path, &header.stamp);
+
+	g_autoptr(GString) data = g_string_sized_new(strings_offset + strings->len);
+	g_string_append_len(data, (const gchar *)&header, sizeof(header));
+	g_string_append_len(data, (const gchar *)entries, count*sizeof(teco_help_index_entry_t));
+	g_string_append_len(data, strings->str, strings->len);
+
+	g_autofree gchar *filename = g_build_filename(women_path, TECO_HELP_INDEX, NULL);
+	return g_file_set_contents(filename, data->str, data->len, error);
+}
+
 static void TECO_DEBUG_CLEANUP
 teco_help_cleanup(void)
 {
+	g_free(teco_help_women_path);
+	if (teco_help_index)
+		g_mapped_file_unref(teco_help_index);
+
 	if (!teco_help_chunk)
 		/* not initialized */
 		return;
@@ -282,8 +620,9 @@ teco_state_help_done(teco_machine_main_t *ctx, const teco_string_t *str, GError
 		return NULL;
 	}
 	const gchar *topic_name = str->data ? : "";
-	teco_help_topic_t *topic = teco_help_find(topic_name);
-	if (!topic) {
+	teco_int_t pos;
+	g_autofree gchar *filename = teco_help_lookup(topic_name, &pos);
+	if (!filename) {
 		g_set_error(error, TECO_ERROR, TECO_ERROR_FAILED,
 		            "Topic \"%s\" not found", topic_name);
 		return NULL;
@@ -295,7 +634,7 @@ teco_state_help_done(teco_machine_main_t *ctx, const teco_string_t *str, GError
 	 * when editing the buffer for the first time.
 	 */
 	if (!teco_current_doc_undo_edit(error) ||
-	    !teco_ring_edit(topic->filename, error))
+	    !teco_ring_edit(filename, error))
 		return NULL;
 
 	/*
@@ -308,7 +647,7 @@ teco_state_help_done(teco_machine_main_t *ctx, const teco_string_t *str, GError
 	 */
 	undo__teco_interface_ssm(SCI_GOTOPOS,
 	                         teco_interface_ssm(SCI_GETCURRENTPOS, 0, 0), 0);
-	teco_interface_ssm(SCI_GOTOPOS, topic->pos, 0);
+	teco_interface_ssm(SCI_GOTOPOS, pos, 0);
 
 	return &teco_state_start;
 }
@@ -328,6 +667,9 @@ gboolean teco_state_help_insert_completion(teco_machine_main_t *ctx, const teco_
  * The help index is built when this command is first
  * executed, so the help system does not consume resources
  * when not used (e.g. in a batch-mode script).
+ * If the womanpage directory contains an up-to-date
+ * topic index generated by \fB--make-help-index\fP,
+ * it is used instead of reading every womanpage script.
  *
  * \*(ST's help documents must be installed in the
  * directory \fB$SCITECOPATH/women\fP, i.e. as part of
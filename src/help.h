@@ -23,6 +23,8 @@
 
 gboolean teco_help_auto_complete(const gchar *topic_name, teco_string_t *insert);
 
+gboolean teco_help_write_index(const gchar *women_path, GError **error);
+
 /*
  * Command states
  */
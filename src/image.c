@@ -0,0 +1,706 @@
+/*
+ * Copyright (C) 2012-2025 Robin Haberkorn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "sciteco.h"
+#include "string-utils.h"
+#include "file-utils.h"
+#include "interface.h"
+#include "qreg.h"
+#include "filetype.h"
+#include "image.h"
+
+/*
+ * State images (see --image).
+ *
+ * Library files included by the profile usually only define Q-Registers,
+ * register file types and change the palette.
+ * When munging the profile, the effects of every library file on the
+ * global Q-Register table, the ED flags, the file type registrations
+ * and the palette are therefore recorded into an image file.
+ * On subsequent startups, these effects are restored in bulk instead of
+ * executing the library files again, as long as neither the profile nor
+ * any of the recorded files have been modified.
+ * The profile itself is still executed, so it can process command line
+ * arguments as usual.
+ *
+ * Files with effects that cannot be restored (e.g. Scintilla messages
+ * or opening buffers) are marked as uncached and always executed.
+ */
+
+#define TECO_IMAGE_MAGIC "SciTECO image 2"
+
+typedef struct {
+	gchar *filename;
+	gint64 mtime, size;
+} teco_image_stamp_t;
+
+typedef struct {
+	teco_string_t name;
+	teco_int_t integer;
+	guint codepage;
+	teco_string_t string;
+} teco_image_reg_t;
+
+typedef struct {
+	gboolean header;
+	gchar *setter;
+	gchar *pattern;
+} teco_image_filetype_t;
+
+typedef struct {
+	guint color;
+	guint32 rgb;
+} teco_image_color_t;
+
+typedef struct {
+	/** the included file followed by all files it included in turn */
+	GArray *stamps;
+	/** whether the file's effects can be restored from the image */
+	gboolean cached;
+	teco_int_t ed_before, ed_after;
+	/** global registers modified by the file */
+	GArray *regs;
+	/** file types registered by the file (see teco_filetype_register()) */
+	GArray *filetypes;
+	/** palette changes by the file (see teco_interface_init_color()) */
+	GArray *colors;
+} teco_image_entry_t;
+
+gboolean teco_image_active = FALSE;
+gboolean teco_image_tainted = FALSE;
+
+static struct {
+	/** whether entries are restored from a valid image */
+	gboolean restoring;
+	gchar *filename;
+	gchar *libdir;
+	teco_image_stamp_t profile;
+
+	GPtrArray *entries;
+	/** index of the next entry to restore */
+	guint next;
+
+	/** entry currently being recorded or NULL */
+	teco_image_entry_t *current;
+	/** digests of the global registers before executing the current entry */
+	GHashTable *digests;
+	/** number of file type registrations before executing the current entry */
+	guint filetypes;
+} teco_image;
+
+/**
+ * Get the modification time and size of a file.
+ *
+ * The size of directories is the number of entries, so adding
+ * files is detected even within the resolution of the
+ * modification time.
+ */
+static gboolean
+teco_image_stat(const gchar *filename, gint64 *mtime, gint64 *size)
+{
+	GStatBuf st;
+
+	if (g_stat(filename, &st))
+		return FALSE;
+
+	*mtime = st.st_mtime;
+	*size = st.st_size;
+
+	if (S_ISDIR(st.st_mode)) {
+		g_autoptr(GDir) dir = g_dir_open(filename, 0, NULL);
+		if (!dir)
+			return FALSE;
+		for (*size = 0; g_dir_read_name(dir); (*size)++);
+	}
+
+	return TRUE;
+}
+
+static void
+teco_image_stamp_init(teco_image_stamp_t *stamp, const gchar *filename)
+{
+	stamp->filename = g_strdup(filename);
+	if (!teco_image_stat(filename, &stamp->mtime, &stamp->size))
+		stamp->mtime = stamp->size = -1;
+}
+
+static gboolean
+teco_image_stamp_valid(const teco_image_stamp_t *stamp)
+{
+	gint64 mtime, size;
+
+	return teco_image_stat(stamp->filename, &mtime, &size) &&
+	       mtime == stamp->mtime && size == stamp->size;
+}
+
+static void
+teco_image_stamp_clear(teco_image_stamp_t *stamp)
+{
+	g_free(stamp->filename);
+}
+
+static void
+teco_image_reg_clear(teco_image_reg_t *reg)
+{
+	teco_string_clear(&reg->name);
+	teco_string_clear(&reg->string);
+}
+
+static void
+teco_image_filetype_clear(teco_image_filetype_t *filetype)
+{
+	g_free(filetype->setter);
+	g_free(filetype->pattern);
+}
+
+static teco_image_entry_t *
+teco_image_entry_new(void)
+{
+	teco_image_entry_t *entry = g_new0(teco_image_entry_t, 1);
+
+	entry->stamps = g_array_new(FALSE, FALSE, sizeof(teco_image_stamp_t));
+	g_array_set_clear_func(entry->stamps, (GDestroyNotify)teco_image_stamp_clear);
+	entry->regs = g_array_new(FALSE, FALSE, sizeof(teco_image_reg_t));
+	g_array_set_clear_func(entry->regs, (GDestroyNotify)teco_image_reg_clear);
+	entry->filetypes = g_array_new(FALSE, FALSE, sizeof(teco_image_filetype_t));
+	g_array_set_clear_func(entry->filetypes, (GDestroyNotify)teco_image_filetype_clear);
+	entry->colors = g_array_new(FALSE, FALSE, sizeof(teco_image_color_t));
+
+	return entry;
+}
+
+static void
+teco_image_entry_free(teco_image_entry_t *entry)
+{
+	g_array_free(entry->stamps, TRUE);
+	g_array_free(entry->regs, TRUE);
+	g_array_free(entry->filetypes, TRUE);
+	g_array_free(entry->colors, TRUE);
+	g_free(entry);
+}
+
+/*
+ * Serialization.
+ * Images are only valid on the machine they were written on,
+ * so integers are written in host byte order.
+ */
+
+static void
+teco_image_write_int(GString *out, gint64 value)
+{
+	g_string_append_len(out, (const gchar *)&value, sizeof(value));
+}
+
+static void
+teco_image_write_string(GString *out, const gchar *str, gsize len)
+{
+	teco_image_write_int(out, len);
+	g_string_append_len(out, str, len);
+}
+
+static void
+teco_image_write_stamp(GString *out, const teco_image_stamp_t *stamp)
+{
+	teco_image_write_string(out, stamp->filename, strlen(stamp->filename));
+	teco_image_write_int(out, stamp->mtime);
+	teco_image_write_int(out, stamp->size);
+}
+
+typedef struct {
+	const gchar *p, *end;
+	gboolean ok;
+} teco_image_reader_t;
+
+static gint64
+teco_image_read_int(teco_image_reader_t *ctx)
+{
+	gint64 value = 0;
+
+	if (ctx->end - ctx->p < sizeof(value)) {
+		ctx->ok = FALSE;
+		ctx->p = ctx->end;
+		return 0;
+	}
+	memcpy(&value, ctx->p, sizeof(value));
+	ctx->p += sizeof(value);
+
+	return value;
+}
+
+static void
+teco_image_read_string(teco_image_reader_t *ctx, teco_string_t *str)
+{
+	gint64 len = teco_image_read_int(ctx);
+
+	if (len < 0 || len > ctx->end - ctx->p) {
+		ctx->ok = FALSE;
+		ctx->p = ctx->end;
+		len = 0;
+	}
+	teco_string_init(str, ctx->p, len);
+	ctx->p += len;
+}
+
+static void
+teco_image_read_stamp(teco_image_reader_t *ctx, teco_image_stamp_t *stamp)
+{
+	teco_string_t filename;
+
+	teco_image_read_string(ctx, &filename);
+	stamp->filename = filename.data;
+	stamp->mtime = teco_image_read_int(ctx);
+	stamp->size = teco_image_read_int(ctx);
+}
+
+static GString *
+teco_image_serialize(void)
+{
+	GString *out = g_string_new(NULL);
+
+	teco_image_write_string(out, TECO_IMAGE_MAGIC, strlen(TECO_IMAGE_MAGIC));
+	teco_image_write_string(out, PACKAGE_VERSION, strlen(PACKAGE_VERSION));
+	teco_image_write_stamp(out, &teco_image.profile);
+
+	teco_image_write_int(out, teco_image.entries->len);
+	for (guint i = 0; i < teco_image.entries->len; i++) {
+		teco_image_entry_t *entry = g_ptr_array_index(teco_image.entries, i);
+
+		teco_image_write_int(out, entry->cached);
+		teco_image_write_int(out, entry->stamps->len);
+		for (guint j = 0; j < entry->stamps->len; j++)
+			teco_image_write_stamp(out, &g_array_index(entry->stamps, teco_image_stamp_t, j));
+
+		teco_image_write_int(out, entry->ed_before);
+		teco_image_write_int(out, entry->ed_after);
+		teco_image_write_int(out, entry->regs->len);
+		for (guint j = 0; j < entry->regs->len; j++) {
+			teco_image_reg_t *reg = &g_array_index(entry->regs, teco_image_reg_t, j);
+			teco_image_write_string(out, reg->name.data, reg->name.len);
+			teco_image_write_int(out, reg->integer);
+			teco_image_write_int(out, reg->codepage);
+			teco_image_write_string(out, reg->string.data, reg->string.len);
+		}
+
+		teco_image_write_int(out, entry->filetypes->len);
+		for (guint j = 0; j < entry->filetypes->len; j++) {
+			teco_image_filetype_t *filetype = &g_array_index(entry->filetypes,
+			                                                 teco_image_filetype_t, j);
+			teco_image_write_int(out, filetype->header);
+			teco_image_write_string(out, filetype->setter, strlen(filetype->setter));
+			teco_image_write_string(out, filetype->pattern, strlen(filetype->pattern));
+		}
+
+		teco_image_write_int(out, entry->colors->len);
+		for (guint j = 0; j < entry->colors->len; j++) {
+			teco_image_color_t *color = &g_array_index(entry->colors, teco_image_color_t, j);
+			teco_image_write_int(out, color->color);
+			teco_image_write_int(out, color->rgb);
+		}
+	}
+
+	return out;
+}
+
+static gboolean
+teco_image_parse(const gchar *data, gsize len)
+{
+	teco_image_reader_t reader = {data, data+len, TRUE};
+
+	g_auto(teco_string_t) magic = {NULL, 0};
+	g_auto(teco_string_t) version = {NULL, 0};
+	teco_image_read_string(&reader, &magic);
+	teco_image_read_string(&reader, &version);
+	teco_image_stamp_t profile;
+	teco_image_read_stamp(&reader, &profile);
+
+	gboolean valid = reader.ok &&
+	                 !teco_string_cmp(&magic, TECO_IMAGE_MAGIC, strlen(TECO_IMAGE_MAGIC)) &&
+	                 !teco_string_cmp(&version, PACKAGE_VERSION, strlen(PACKAGE_VERSION)) &&
+	                 !strcmp(profile.filename, teco_image.profile.filename) &&
+	                 profile.mtime == teco_image.profile.mtime &&
+	                 profile.size == teco_image.profile.size;
+	teco_image_stamp_clear(&profile);
+	if (!valid)
+		return FALSE;
+
+	gint64 entries_len = teco_image_read_int(&reader);
+	for (gint64 i = 0; i < entries_len && reader.ok; i++) {
+		teco_image_entry_t *entry = teco_image_entry_new();
+		g_ptr_array_add(teco_image.entries, entry);
+
+		entry->cached = teco_image_read_int(&reader);
+		gint64 stamps_len = teco_image_read_int(&reader);
+		for (gint64 j = 0; j < stamps_len && reader.ok; j++) {
+			teco_image_stamp_t stamp;
+			teco_image_read_stamp(&reader, &stamp);
+			g_array_append_val(entry->stamps, stamp);
+		}
+
+		entry->ed_before = teco_image_read_int(&reader);
+		entry->ed_after = teco_image_read_int(&reader);
+		gint64 regs_len = teco_image_read_int(&reader);
+		for (gint64 j = 0; j < regs_len && reader.ok; j++) {
+			teco_image_reg_t reg;
+			teco_image_read_string(&reader, &reg.name);
+			reg.integer = teco_image_read_int(&reader);
+			reg.codepage = teco_image_read_int(&reader);
+			teco_image_read_string(&reader, &reg.string);
+			g_array_append_val(entry->regs, reg);
+		}
+
+		gint64 filetypes_len = teco_image_read_int(&reader);
+		for (gint64 j = 0; j < filetypes_len && reader.ok; j++) {
+			teco_image_filetype_t filetype;
+			teco_string_t str;
+			filetype.header = teco_image_read_int(&reader);
+			teco_image_read_string(&reader, &str);
+			filetype.setter = str.data;
+			teco_image_read_string(&reader, &str);
+			filetype.pattern = str.data;
+			g_array_append_val(entry->filetypes, filetype);
+		}
+
+		gint64 colors_len = teco_image_read_int(&reader);
+		for (gint64 j = 0; j < colors_len && reader.ok; j++) {
+			teco_image_color_t color;
+			color.color = teco_image_read_int(&reader);
+			color.rgb = teco_image_read_int(&reader);
+			g_array_append_val(entry->colors, color);
+		}
+
+		if (!entry->stamps->len)
+			reader.ok = FALSE;
+	}
+
+	if (!reader.ok) {
+		g_ptr_array_set_size(teco_image.entries, 0);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/*
+ * Recording and restoring of global registers.
+ */
+
+static guint64
+teco_image_digest(teco_qreg_t *qreg)
+{
+	g_auto(teco_string_t) str = {NULL, 0};
+	guint codepage = 0;
+	qreg->vtable->get_string(qreg, &str.data, &str.len, &codepage, NULL);
+
+	/* FNV-1a */
+	guint64 hash = G_GUINT64_CONSTANT(14695981039346656037);
+	for (gsize i = 0; i < str.len; i++) {
+		hash ^= (guchar)str.data[i];
+		hash *= G_GUINT64_CONSTANT(1099511628211);
+	}
+	hash = (hash ^ (guint64)qreg->integer) * G_GUINT64_CONSTANT(1099511628211);
+	hash = (hash ^ codepage) * G_GUINT64_CONSTANT(1099511628211);
+
+	return hash;
+}
+
+static GHashTable *
+teco_image_digest_globals(void)
+{
+	GHashTable *digests = g_hash_table_new_full(g_bytes_hash, g_bytes_equal,
+	                                            (GDestroyNotify)g_bytes_unref, g_free);
+
+	for (teco_qreg_t *cur = (teco_qreg_t *)rb3_get_min(&teco_qreg_table_globals.tree);
+	     cur; cur = (teco_qreg_t *)teco_rb3str_get_next(&cur->head)) {
+		if (!teco_qreg_is_plain(cur))
+			continue;
+
+		guint64 *digest = g_new(guint64, 1);
+		*digest = teco_image_digest(cur);
+		g_hash_table_insert(digests, g_bytes_new(cur->head.name.data, cur->head.name.len),
+		                    digest);
+	}
+
+	return digests;
+}
+
+static void
+teco_image_record(teco_image_entry_t *entry)
+{
+	entry->ed_after = teco_ed;
+
+	for (guint i = teco_image.filetypes; i < teco_filetype_count(); i++) {
+		teco_image_filetype_t filetype;
+		const gchar *setter, *pattern;
+		teco_filetype_get(i, &filetype.header, &setter, &pattern);
+		filetype.setter = g_strdup(setter);
+		filetype.pattern = g_strdup(pattern);
+		g_array_append_val(entry->filetypes, filetype);
+	}
+
+	for (teco_qreg_t *cur = (teco_qreg_t *)rb3_get_min(&teco_qreg_table_globals.tree);
+	     cur; cur = (teco_qreg_t *)teco_rb3str_get_next(&cur->head)) {
+		if (!teco_qreg_is_plain(cur))
+			continue;
+
+		GBytes *name = g_bytes_new_static(cur->head.name.data, cur->head.name.len);
+		const guint64 *digest = g_hash_table_lookup(teco_image.digests, name);
+		g_bytes_unref(name);
+		if (digest && *digest == teco_image_digest(cur))
+			continue;
+
+		teco_image_reg_t reg;
+		teco_string_init(&reg.name, cur->head.name.data, cur->head.name.len);
+		reg.integer = cur->integer;
+		cur->vtable->get_string(cur, &reg.string.data, &reg.string.len, &reg.codepage, NULL);
+		g_array_append_val(entry->regs, reg);
+	}
+}
+
+static gboolean
+teco_image_restore(teco_image_entry_t *entry, GError **error)
+{
+	for (guint i = 0; i < entry->regs->len; i++) {
+		teco_image_reg_t *reg = &g_array_index(entry->regs, teco_image_reg_t, i);
+
+		teco_qreg_t *qreg = teco_qreg_table_find(&teco_qreg_table_globals,
+		                                         reg->name.data, reg->name.len);
+		if (!qreg) {
+			qreg = teco_qreg_plain_new(reg->name.data, reg->name.len);
+			teco_qreg_table_insert_unique(&teco_qreg_table_globals, qreg);
+		}
+
+		if (!qreg->vtable->set_integer(qreg, reg->integer, error) ||
+		    !qreg->vtable->set_string(qreg, reg->string.data, reg->string.len,
+		                              reg->codepage, error))
+			return FALSE;
+	}
+
+	for (guint i = 0; i < entry->filetypes->len; i++) {
+		teco_image_filetype_t *filetype = &g_array_index(entry->filetypes,
+		                                                 teco_image_filetype_t, i);
+		teco_filetype_register(filetype->header, filetype->setter, filetype->pattern);
+	}
+
+	for (guint i = 0; i < entry->colors->len; i++) {
+		teco_image_color_t *color = &g_array_index(entry->colors, teco_image_color_t, i);
+		teco_interface_init_color(color->color, color->rgb);
+	}
+
+	teco_ed = entry->ed_after;
+	return TRUE;
+}
+
+/**
+ * Start munging the profile with a state image.
+ *
+ * @param filename The image file, which does not have to exist.
+ * @param profile The profile to munge.
+ * @param libdir The standard library directory.
+ *   Only files in this directory are recorded.
+ */
+void
+teco_image_begin(const gchar *filename, const gchar *profile, const gchar *libdir)
+{
+	memset(&teco_image, 0, sizeof(teco_image));
+
+	teco_image.filename = g_strdup(filename);
+	teco_image.libdir = teco_file_get_absolute_path(libdir);
+	g_autofree gchar *profile_path = teco_file_get_absolute_path(profile);
+	teco_image_stamp_init(&teco_image.profile, profile_path);
+	teco_image.entries = g_ptr_array_new_with_free_func((GDestroyNotify)teco_image_entry_free);
+
+	g_autofree gchar *data = NULL;
+	gsize len;
+	teco_image.restoring = g_file_get_contents(filename, &data, &len, NULL) &&
+	                       teco_image_parse(data, len);
+
+	teco_image_active = TRUE;
+}
+
+/**
+ * Called before executing a file (see teco_execute_file()).
+ *
+ * @param filename The file to execute.
+ * @param depth The nesting level of the file (0 for the profile).
+ * @param restored Set to TRUE if the file's effects have been
+ *   restored from the image, so it must not be executed.
+ * @param error A GError.
+ * @return FALSE in case of a GError.
+ */
+gboolean
+teco_image_enter(const gchar *filename, guint depth, gboolean *restored, GError **error)
+{
+	*restored = FALSE;
+
+	if (depth == 0)
+		return TRUE;
+
+	if (depth > 1) {
+		teco_image_depend(filename);
+		return TRUE;
+	}
+
+	g_autofree gchar *path = teco_file_get_absolute_path(filename);
+
+	gsize libdir_len = strlen(teco_image.libdir);
+	if (strncmp(path, teco_image.libdir, libdir_len) || !G_IS_DIR_SEPARATOR(path[libdir_len]))
+		/* not a library file */
+		return TRUE;
+
+	if (teco_image.restoring) {
+		teco_image_entry_t *entry = teco_image.next < teco_image.entries->len
+			? g_ptr_array_index(teco_image.entries, teco_image.next) : NULL;
+
+		gboolean valid = entry && !strcmp(path, g_array_index(entry->stamps, teco_image_stamp_t, 0).filename);
+		if (valid && entry->cached) {
+			valid = entry->ed_before == teco_ed;
+			for (guint i = 0; valid && i < entry->stamps->len; i++)
+				valid = teco_image_stamp_valid(&g_array_index(entry->stamps, teco_image_stamp_t, i));
+		}
+
+		if (valid) {
+			teco_image.next++;
+			if (!entry->cached)
+				return TRUE;
+			*restored = TRUE;
+			return teco_image_restore(entry, error);
+		}
+
+		/* this and all following files are recorded again */
+		g_ptr_array_set_size(teco_image.entries, teco_image.next);
+		teco_image.restoring = FALSE;
+	}
+
+	teco_image.current = teco_image_entry_new();
+	teco_image_stamp_t stamp;
+	teco_image_stamp_init(&stamp, path);
+	g_array_append_val(teco_image.current->stamps, stamp);
+	teco_image.current->ed_before = teco_ed;
+	teco_image.digests = teco_image_digest_globals();
+	teco_image.filetypes = teco_filetype_count();
+	teco_image_tainted = FALSE;
+
+	return TRUE;
+}
+
+/**
+ * Make the file being recorded depend on another file or directory.
+ *
+ * This is called for all files included by library files and
+ * for all directories that are globbed (see teco_globber_init()),
+ * so that adding files to them invalidates the image entry.
+ *
+ * @param filename The file or directory, which does not have to exist.
+ */
+void
+teco_image_depend(const gchar *filename)
+{
+	if (!teco_image.current)
+		return;
+
+	g_autofree gchar *path = teco_file_get_absolute_path(*filename ? filename : ".");
+
+	for (guint i = 0; i < teco_image.current->stamps->len; i++)
+		if (!strcmp(g_array_index(teco_image.current->stamps, teco_image_stamp_t, i).filename, path))
+			return;
+
+	teco_image_stamp_t stamp;
+	teco_image_stamp_init(&stamp, path);
+	g_array_append_val(teco_image.current->stamps, stamp);
+}
+
+/**
+ * Record a palette change (see teco_interface_init_color())
+ * by the file being recorded.
+ */
+void
+teco_image_init_color(guint color, guint32 rgb)
+{
+	if (!teco_image.current)
+		return;
+
+	teco_image_color_t entry = {color, rgb};
+	g_array_append_val(teco_image.current->colors, entry);
+}
+
+/**
+ * Called after executing a file (see teco_execute_file()).
+ *
+ * @param depth The nesting level of the file (0 for the profile).
+ * @param success Whether the file was executed successfully.
+ */
+void
+teco_image_leave(guint depth, gboolean success)
+{
+	if (depth != 1 || !teco_image.current)
+		return;
+
+	teco_image_entry_t *entry = teco_image.current;
+	teco_image.current = NULL;
+
+	if (success) {
+		entry->cached = !teco_image_tainted;
+		if (entry->cached)
+			teco_image_record(entry);
+		g_ptr_array_add(teco_image.entries, entry);
+	} else {
+		teco_image_entry_free(entry);
+	}
+
+	g_clear_pointer(&teco_image.digests, g_hash_table_destroy);
+}
+
+/**
+ * Finish munging the profile with a state image.
+ *
+ * The image is written unless it has been restored completely.
+ *
+ * @param success Whether the profile was munged successfully.
+ */
+void
+teco_image_end(gboolean success)
+{
+	if (success && !teco_image.restoring) {
+		g_autoptr(GString) data = teco_image_serialize();
+		g_autoptr(GError) error = NULL;
+
+		if (!g_file_set_contents(teco_image.filename, data->str, data->len, &error))
+			teco_interface_msg(TECO_MSG_WARNING, "Cannot write image \"%s\": %s",
+			                   teco_image.filename, error->message);
+	}
+
+	g_free(teco_image.filename);
+	g_free(teco_image.libdir);
+	teco_image_stamp_clear(&teco_image.profile);
+	g_ptr_array_unref(teco_image.entries);
+	if (teco_image.current)
+		teco_image_entry_free(teco_image.current);
+	if (teco_image.digests)
+		g_hash_table_destroy(teco_image.digests);
+	memset(&teco_image, 0, sizeof(teco_image));
+
+	teco_image_active = FALSE;
+}
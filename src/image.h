@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2012-2025 Robin Haberkorn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <glib.h>
+
+#include "sciteco.h"
+
+/** Whether the profile is being munged with a state image (see --image) */
+extern gboolean teco_image_active;
+extern gboolean teco_image_tainted;
+
+void teco_image_begin(const gchar *filename, const gchar *profile, const gchar *libdir);
+gboolean teco_image_enter(const gchar *filename, guint depth, gboolean *restored, GError **error);
+void teco_image_depend(const gchar *filename);
+void teco_image_init_color(guint color, guint32 rgb);
+void teco_image_leave(guint depth, gboolean success);
+void teco_image_end(gboolean success);
+
+/**
+ * Mark the file being recorded into the image as having effects
+ * that cannot be restored from the image, e.g. Scintilla messages.
+ */
+static inline void
+teco_image_taint(void)
+{
+	teco_image_tainted = TRUE;
+}
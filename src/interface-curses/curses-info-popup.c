@@ -19,11 +19,12 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include <glib.h>
 
 #include <curses.h>
 
-#include "list.h"
 #include "string-utils.h"
 #include "interface.h"
 #include "curses-utils.h"
@@ -34,10 +35,8 @@
  * FIXME: This is redundant with gtk-info-popup.c.
  */
 typedef struct {
-	teco_stailq_entry_t entry;
-
-	teco_popup_entry_type_t type;
 	teco_string_t name;
+	teco_popup_entry_type_t type;
 	gboolean highlight;
 } teco_popup_entry_t;
 
@@ -45,36 +44,87 @@ void
 teco_curses_info_popup_add(teco_curses_info_popup_t *ctx, teco_popup_entry_type_t type,
                            const gchar *name, gsize name_len, gboolean highlight)
 {
-	if (G_UNLIKELY(!ctx->chunk))
+	if (G_UNLIKELY(!ctx->chunk)) {
 		ctx->chunk = g_string_chunk_new(32);
+		ctx->entries = g_array_new(FALSE, FALSE, sizeof(teco_popup_entry_t));
+	}
 
 	/*
-	 * FIXME: Test with g_slice_new()...
-	 * It could however cause problems upon command-line termination
-	 * and may not be measurably faster.
-	 */
-	teco_popup_entry_t *entry = g_new(teco_popup_entry_t, 1);
-	entry->type = type;
-	/*
+	 * Entries are stored by value in a single array,
+	 * so adding hundreds of thousands of them does not
+	 * require as many heap allocations.
 	 * Popup entries aren't removed individually, so we can
-	 * more efficiently store them via GStringChunk.
+	 * more efficiently store their names via GStringChunk.
 	 */
-	teco_string_init_chunk(&entry->name, name, name_len, ctx->chunk);
-	entry->highlight = highlight;
-
-	teco_stailq_insert_tail(&ctx->list, &entry->entry);
+	teco_popup_entry_t entry = {.type = type, .highlight = highlight};
+	teco_string_init_chunk(&entry.name, name, name_len, ctx->chunk);
+	g_array_append_val(ctx->entries, entry);
 
 	ctx->longest = MAX(ctx->longest, (gint)name_len);
-	ctx->length++;
 }
 
-static void
-teco_curses_info_popup_init_pad(teco_curses_info_popup_t *ctx, attr_t attr)
+/**
+ * Narrow down the popup entries.
+ *
+ * Only entries continuing with the given string after their
+ * first `prefix_len` bytes are kept.
+ * This is much cheaper than regenerating the completions
+ * when typing more characters of the completed word.
+ *
+ * @param ctx The popup widget to filter
+ * @param prefix_len Length of the prefix common to all entries
+ * @param case_sensitive Whether to compare entries case-sensitively
+ * @param str The string the remaining entries must continue with
+ * @param len Length of str
+ * @return The number of entries left
+ */
+guint
+teco_curses_info_popup_filter(teco_curses_info_popup_t *ctx, gsize prefix_len,
+                              gboolean case_sensitive, const gchar *str, gsize len)
+{
+	if (!ctx->entries)
+		return 0;
+
+	teco_string_diff_t diff = case_sensitive ? teco_string_diff : teco_string_casediff;
+
+	guint kept = 0;
+	ctx->longest = 0;
+
+	for (guint i = 0; i < ctx->entries->len; i++) {
+		teco_popup_entry_t *entry = &g_array_index(ctx->entries, teco_popup_entry_t, i);
+
+		if (entry->name.len < prefix_len + len)
+			continue;
+		const teco_string_t suffix = {entry->name.data + prefix_len,
+		                              entry->name.len - prefix_len};
+		if (diff(&suffix, str, len) != len)
+			continue;
+
+		g_array_index(ctx->entries, teco_popup_entry_t, kept++) = *entry;
+		ctx->longest = MAX(ctx->longest, (gint)entry->name.len);
+	}
+	g_array_set_size(ctx->entries, kept);
+
+	/* the layout changes, so everything must be rendered again */
+	if (ctx->pad)
+		delwin(ctx->pad);
+	ctx->pad = NULL;
+	ctx->pad_first_line = ctx->pad_start_line = 0;
+
+	return kept;
+}
+
+/**
+ * Calculate the layout of entry columns.
+ *
+ * @param ctx The popup widget
+ * @param pad_colwidth Where to store the width per entry column
+ * @return The number of entry columns
+ */
+static gint
+teco_curses_info_popup_get_cols(teco_curses_info_popup_t *ctx, gint *pad_colwidth)
 {
 	int cols = getmaxx(stdscr);	/**! screen width */
-	int pad_lines;			/**! pad height */
-	gint pad_cols;			/**! entry columns */
-	gint pad_colwidth;		/**! width per entry column */
 
 	/*
 	 * With Unicode icons enabled, we reserve 2 characters at the beginning and one
@@ -82,20 +132,46 @@ teco_curses_info_popup_init_pad(teco_curses_info_popup_t *ctx, attr_t attr)
 	 * Otherwise 2 characters after the entry.
 	 */
 	gint reserve = teco_ed & TECO_ED_ICONS ? 2+1 : 2;
-	pad_colwidth = MIN(ctx->longest + reserve, cols - 2);
+	*pad_colwidth = MIN(ctx->longest + reserve, cols - 2);
 
 	/* pad_cols = floor((cols - 2) / pad_colwidth) */
-	pad_cols = (cols - 2) / pad_colwidth;
+	return (cols - 2) / *pad_colwidth;
+}
+
+/** @return The number of lines required to show all entries */
+static gint
+teco_curses_info_popup_get_lines(teco_curses_info_popup_t *ctx)
+{
+	gint pad_colwidth;
+	gint pad_cols = teco_curses_info_popup_get_cols(ctx, &pad_colwidth);
+
 	/* pad_lines = ceil(length / pad_cols) */
-	pad_lines = (ctx->length+pad_cols-1) / pad_cols;
+	return (ctx->entries->len+pad_cols-1) / pad_cols;
+}
 
-	/*
-	 * Render the entire autocompletion list into a pad
-	 * which can be higher than the physical screen.
-	 * The pad uses two columns less than the screen since
-	 * it will be drawn into the popup window which has left
-	 * and right borders.
-	 */
+/**
+ * Render an excerpt of the autocompletion list into the pad.
+ *
+ * Only the page starting at pad_first_line and the page
+ * following it are rendered, so the cost does not depend
+ * on the total number of entries.
+ * The pad uses two columns less than the screen since
+ * it will be drawn into the popup window which has left
+ * and right borders.
+ */
+static void
+teco_curses_info_popup_init_pad(teco_curses_info_popup_t *ctx, gint page_lines, attr_t attr)
+{
+	int cols = getmaxx(stdscr);	/**! screen width */
+	gint pad_colwidth;		/**! width per entry column */
+	gint pad_cols = teco_curses_info_popup_get_cols(ctx, &pad_colwidth);
+	gint total_lines = teco_curses_info_popup_get_lines(ctx);
+
+	if (ctx->pad)
+		delwin(ctx->pad);
+
+	ctx->pad_start_line = ctx->pad_first_line;
+	gint pad_lines = MIN(2*page_lines, total_lines - ctx->pad_start_line);
 	ctx->pad = newpad(pad_lines, cols - 2);
 
 	/*
@@ -106,18 +182,14 @@ teco_curses_info_popup_init_pad(teco_curses_info_popup_t *ctx, attr_t attr)
 	wattrset(ctx->pad, attr);
 	teco_curses_clrtobot(ctx->pad);
 
-	/*
-	 * cur_col is the row currently written.
-	 * It does not wrap but grows indefinitely.
-	 * Therefore the real current row is (cur_col % popup_cols)
-	 */
-	gint cur_col = 0;
-	for (teco_stailq_entry_t *cur = ctx->list.first; cur != NULL; cur = cur->next) {
-		teco_popup_entry_t *entry = (teco_popup_entry_t *)cur;
-		gint cur_line = cur_col/pad_cols + 1;
+	guint first = ctx->pad_start_line*pad_cols;
+	guint last = MIN(ctx->entries->len, (guint)(ctx->pad_start_line+pad_lines)*pad_cols);
 
-		wmove(ctx->pad, cur_line-1,
-		      (cur_col % pad_cols)*pad_colwidth);
+	for (guint i = first; i < last; i++) {
+		teco_popup_entry_t *entry = &g_array_index(ctx->entries, teco_popup_entry_t, i);
+
+		wmove(ctx->pad, (i-first) / pad_cols,
+		      ((i-first) % pad_cols)*pad_colwidth);
 
 		if (entry->highlight)
 			wattron(ctx->pad, A_BOLD);
@@ -145,15 +217,13 @@ teco_curses_info_popup_init_pad(teco_curses_info_popup_t *ctx, attr_t attr)
 		}
 
 		wattroff(ctx->pad, A_BOLD);
-
-		cur_col++;
 	}
 }
 
 void
 teco_curses_info_popup_show(teco_curses_info_popup_t *ctx, attr_t attr)
 {
-	if (!ctx->length)
+	if (!ctx->entries || !ctx->entries->len)
 		/* nothing to display */
 		return;
 
@@ -163,15 +233,19 @@ teco_curses_info_popup_show(teco_curses_info_popup_t *ctx, attr_t attr)
 	if (ctx->window)
 		delwin(ctx->window);
 
-	if (!ctx->pad)
-		teco_curses_info_popup_init_pad(ctx, attr);
-	gint pad_lines = getmaxy(ctx->pad);
+	gint pad_lines = teco_curses_info_popup_get_lines(ctx);
 
 	/*
 	 * Popup window can cover all but one screen row.
 	 * Another row is reserved for the top border.
 	 */
 	gint popup_lines = MIN(pad_lines + 1, lines - 1);
+	gint page_lines = MAX(popup_lines - 1, 1);
+
+	if (!ctx->pad || ctx->pad_first_line < ctx->pad_start_line ||
+	    ctx->pad_first_line + page_lines > ctx->pad_start_line + getmaxy(ctx->pad))
+		/* scrolled out of the rendered excerpt */
+		teco_curses_info_popup_init_pad(ctx, page_lines, attr);
 
 	/* window covers message, scintilla and info windows */
 	ctx->window = newwin(popup_lines, 0, lines - 1 - popup_lines, 0);
@@ -187,7 +261,7 @@ teco_curses_info_popup_show(teco_curses_info_popup_t *ctx, attr_t attr)
 	        ACS_VLINE, ACS_VLINE);
 
 	copywin(ctx->pad, ctx->window,
-	        ctx->pad_first_line, 0,
+	        ctx->pad_first_line - ctx->pad_start_line, 0,
 	        1, 1, popup_lines - 1, cols - 2, FALSE);
 
 	if (pad_lines <= popup_lines - 1)
@@ -220,53 +294,31 @@ teco_curses_info_popup_show(teco_curses_info_popup_t *ctx, attr_t attr)
  * @return Pointer to the entry's string under the pointer or NULL.
  *   This string is owned by the popup and is only valid until the
  *   popup is cleared.
- *
- * @note This must match the calculations in teco_curses_info_popup_init_pad().
- *   But we could perhaps also cache these values.
  */
 const teco_string_t *
 teco_curses_info_popup_getentry(teco_curses_info_popup_t *ctx, gint y, gint x)
 {
-	int cols = getmaxx(stdscr);	/**! screen width */
-	gint pad_cols;			/**! entry columns */
-	gint pad_colwidth;		/**! width per entry column */
-
-	if (y == 0)
+	if (y == 0 || x == 0 || !ctx->entries)
 		return NULL;
 
-	/*
-	 * With Unicode icons enabled, we reserve 2 characters at the beginning and one
-	 * after the filename/directory.
-	 * Otherwise 2 characters after the entry.
-	 */
-	gint reserve = teco_ed & TECO_ED_ICONS ? 2+1 : 2;
-	pad_colwidth = MIN(ctx->longest + reserve, cols - 2);
+	gint pad_colwidth;
+	gint pad_cols = teco_curses_info_popup_get_cols(ctx, &pad_colwidth);
 
-	/* pad_cols = floor((cols - 2) / pad_colwidth) */
-	pad_cols = (cols - 2) / pad_colwidth;
-
-	gint cur_col = 0;
-	for (teco_stailq_entry_t *cur = ctx->list.first; cur != NULL; cur = cur->next) {
-		teco_popup_entry_t *entry = (teco_popup_entry_t *)cur;
-		gint cur_line = cur_col/pad_cols + 1;
-
-		if (cur_line > ctx->pad_first_line+y)
-			break;
-		if (cur_line == ctx->pad_first_line+y &&
-		    x > (cur_col % pad_cols)*pad_colwidth && x <= ((cur_col % pad_cols)+1)*pad_colwidth)
-			return &entry->name;
-
-		cur_col++;
-	}
+	/* x in ]col*pad_colwidth, (col+1)*pad_colwidth] */
+	gint col = (x-1) / pad_colwidth;
+	if (col >= pad_cols)
+		return NULL;
 
-	return NULL;
+	guint i = (ctx->pad_first_line+y-1)*pad_cols + col;
+	return i < ctx->entries->len
+		? &g_array_index(ctx->entries, teco_popup_entry_t, i).name : NULL;
 }
 
 void
 teco_curses_info_popup_scroll_page(teco_curses_info_popup_t *ctx)
 {
 	gint lines = getmaxy(stdscr);
-	gint pad_lines = getmaxy(ctx->pad);
+	gint pad_lines = teco_curses_info_popup_get_lines(ctx);
 	gint popup_lines = MIN(pad_lines + 1, lines - 1);
 
 	/* progress scroll position */
@@ -282,7 +334,7 @@ void
 teco_curses_info_popup_scroll(teco_curses_info_popup_t *ctx, gint delta)
 {
 	gint lines = getmaxy(stdscr);
-	gint pad_lines = getmaxy(ctx->pad);
+	gint pad_lines = teco_curses_info_popup_get_lines(ctx);
 	gint popup_lines = MIN(pad_lines + 1, lines - 1);
 
 	ctx->pad_first_line = MAX(ctx->pad_first_line+delta, 0);
@@ -300,10 +352,8 @@ teco_curses_info_popup_clear(teco_curses_info_popup_t *ctx)
 		delwin(ctx->pad);
 	if (ctx->chunk)
 		g_string_chunk_free(ctx->chunk);
-
-	teco_stailq_entry_t *entry;
-	while ((entry = teco_stailq_remove_head(&ctx->list)))
-		g_free(entry);
+	if (ctx->entries)
+		g_array_free(ctx->entries, TRUE);
 
 	teco_curses_info_popup_init(ctx);
 }
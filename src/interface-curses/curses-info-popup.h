@@ -22,19 +22,18 @@
 
 #include <curses.h>
 
-#include "list.h"
 #include "string-utils.h"
 #include "interface.h"
 
 typedef struct {
 	WINDOW *window;			/**! window showing part of pad */
-	WINDOW *pad;			/**! full-height entry list */
+	WINDOW *pad;			/**! rendered excerpt of the entry list */
 
-	teco_stailq_head_t list;	/**! list of popup entries */
+	GArray *entries;		/**! array of popup entries */
 	gint longest;			/**! size of longest entry */
-	gint length;			/**! total number of popup entries */
 
-	gint pad_first_line;		/**! first line in pad to show */
+	gint pad_first_line;		/**! first line of the entry list to show */
+	gint pad_start_line;		/**! first line of the entry list rendered into pad */
 
 	GStringChunk *chunk;		/**! string chunk for all popup entry names */
 } teco_curses_info_popup_t;
@@ -43,12 +42,14 @@ static inline void
 teco_curses_info_popup_init(teco_curses_info_popup_t *ctx)
 {
 	memset(ctx, 0, sizeof(*ctx));
-	ctx->list = TECO_STAILQ_HEAD_INITIALIZER(&ctx->list);
 }
 
 void teco_curses_info_popup_add(teco_curses_info_popup_t *ctx, teco_popup_entry_type_t type,
                                 const gchar *name, gsize name_len, gboolean highlight);
 
+guint teco_curses_info_popup_filter(teco_curses_info_popup_t *ctx, gsize prefix_len,
+                                    gboolean case_sensitive, const gchar *str, gsize len);
+
 void teco_curses_info_popup_show(teco_curses_info_popup_t *ctx, attr_t attr);
 const teco_string_t *teco_curses_info_popup_getentry(teco_curses_info_popup_t *ctx, gint y, gint x);
 void teco_curses_info_popup_scroll_page(teco_curses_info_popup_t *ctx);
@@ -70,6 +70,7 @@
 #include "error.h"
 #include "view.h"
 #include "memory.h"
+#include "stats.h"
 #include "interface.h"
 #include "curses-utils.h"
 #include "curses-info-popup.h"
@@ -107,6 +108,19 @@
 #define CURSES_TTY
 #endif
 
+#if defined(CURSES_TTY) && defined(HAVE_DEFINE_KEY)
+/**
+ * Whether we can detect pasted text by enabling the
+ * terminal's bracketed paste mode.
+ */
+#define CURSES_BRACKETED_PASTE
+
+/** Key code reported for the beginning of pasted text ("\e[200~") */
+#define TECO_KEY_PASTE_BEGIN	(KEY_MAX+1)
+/** Key code reported for the end of pasted text ("\e[201~") */
+#define TECO_KEY_PASTE_END	(KEY_MAX+2)
+#endif
+
 #ifdef G_OS_WIN32
 
 /**
@@ -298,9 +312,21 @@ teco_xterm_version(void)
  * This saves one heap object per view.
  */
 
+/**
+ * Number of text modifications in any view.
+ *
+ * This lets teco_interface_pace() detect modifications
+ * that preserve dot and the document length, like FR.
+ */
+static guint teco_view_modifications = 0;
+
 static void
 teco_view_scintilla_notify(void *sci, int iMessage, SCNotification *notify, void *user_data)
 {
+	if (notify->nmhdr.code == SCN_MODIFIED &&
+	    (notify->modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT)))
+		teco_view_modifications++;
+
 	teco_view_process_notify((teco_view_t *)sci, notify);
 }
 
@@ -325,6 +351,7 @@ teco_view_get_window(teco_view_t *ctx)
 sptr_t
 teco_view_ssm(teco_view_t *ctx, unsigned int iMessage, uptr_t wParam, sptr_t lParam)
 {
+	teco_stats_inc_message(iMessage);
 	return scintilla_send_message(ctx, iMessage, wParam, lParam);
 }
 
@@ -334,6 +361,14 @@ teco_view_free(teco_view_t *ctx)
 	scintilla_delete(ctx);
 }
 
+/** Windows changed since the last screen update */
+typedef enum {
+	TECO_DAMAGE_INFO	= (1 << 0),
+	TECO_DAMAGE_MSG		= (1 << 1),
+	TECO_DAMAGE_CMDLINE	= (1 << 2),
+	TECO_DAMAGE_VIEW	= (1 << 3)
+} teco_damage_t;
+
 static struct {
 	/**
 	 * Mapping of the first 16 curses color codes (that may or may not
@@ -372,6 +407,22 @@ static struct {
 	WINDOW *cmdline_window, *cmdline_pad;
 	guint cmdline_len, cmdline_rubout_len;
 
+	/**
+	 * Command line as currently formatted into cmdline_pad.
+	 * This allows formatting only the part of the command line
+	 * that changed since the last update.
+	 */
+	teco_string_t cmdline_str;
+	/** Effective length of cmdline_str */
+	gsize cmdline_effective_len;
+	/**
+	 * Pad column of every byte in cmdline_str,
+	 * followed by the column after the last character.
+	 */
+	GArray *cmdline_cols;
+	/** Colors cmdline_pad has been formatted with */
+	short cmdline_fg, cmdline_bg;
+
 	/**
 	 * Pad used exclusively for wgetch() as it will not
 	 * result in unwanted wrefresh().
@@ -381,6 +432,18 @@ static struct {
 
 	teco_curses_info_popup_t popup;
 	gsize popup_prefix_len;
+	gboolean popup_case_sensitive;
+
+	/** Windows changed since the last screen update (teco_damage_t) */
+	guint damage;
+	/** Calls to teco_interface_pace() since the clock was last checked */
+	guint pace_calls;
+	/** Monotonic time of the last screen update */
+	gint64 frame_ts;
+	/** View, dot, document length and modifications at the last screen update */
+	const teco_view_t *frame_view;
+	sptr_t frame_dot, frame_len;
+	guint frame_modifications;
 
 	/**
 	 * GError "thrown" by teco_interface_event_loop_iter().
@@ -815,6 +878,19 @@ teco_interface_init_interactive(GError **error)
 	teco_interface_init_clipboard();
 #endif
 
+	/*
+	 * Terminal emulators supporting bracketed paste mode will
+	 * enclose pasted text in escape sequences, so it can be
+	 * inserted at once (see teco_interface_paste()).
+	 * Other terminals simply ignore this.
+	 */
+#ifdef CURSES_BRACKETED_PASTE
+	define_key("\e[200~", TECO_KEY_PASTE_BEGIN);
+	define_key("\e[201~", TECO_KEY_PASTE_END);
+	fputs("\e[?2004h", teco_interface.screen_tty);
+	fflush(teco_interface.screen_tty);
+#endif
+
 	return TRUE;
 }
 
@@ -832,6 +908,13 @@ teco_interface_restore_batch(void)
 	teco_interface_set_window_title(g_getenv("TERM") ? : "");
 #endif
 
+#ifdef CURSES_BRACKETED_PASTE
+	if (teco_interface.cmdline_window) {
+		fputs("\e[?2004l", teco_interface.screen_tty);
+		fflush(teco_interface.screen_tty);
+	}
+#endif
+
 	/*
 	 * Restore ordinary terminal behaviour
 	 * (i.e. return to batch mode)
@@ -929,6 +1012,7 @@ teco_interface_msg_literal(teco_msg_t type, const gchar *str, gsize len)
 	wattrset(teco_interface.msg_window, teco_color_attr(fg, bg));
 	teco_curses_format_str(teco_interface.msg_window, str, len, -1);
 	teco_curses_clrtobot(teco_interface.msg_window);
+	teco_interface.damage |= TECO_DAMAGE_MSG;
 }
 
 void
@@ -943,6 +1027,7 @@ teco_interface_msg_clear(void)
 	wmove(teco_interface.msg_window, 0, 0);
 	wattrset(teco_interface.msg_window, teco_color_attr(fg, bg));
 	teco_curses_clrtobot(teco_interface.msg_window);
+	teco_interface.damage |= TECO_DAMAGE_MSG;
 }
 
 teco_int_t
@@ -1177,7 +1262,8 @@ teco_interface_info_update_qreg(const teco_qreg_t *reg)
 	                 reg->head.name.data, reg->head.name.len);
 	teco_interface.info_dirty = FALSE;
 	teco_interface.info_type = TECO_INFO_TYPE_QREG;
-	/* NOTE: drawn in teco_interface_event_loop_iter() */
+	teco_interface.damage |= TECO_DAMAGE_INFO;
+	/* NOTE: drawn in teco_interface_refresh() */
 }
 
 void
@@ -1189,7 +1275,8 @@ teco_interface_info_update_buffer(const teco_buffer_t *buffer)
 	teco_string_init(&teco_interface.info_current, filename, strlen(filename));
 	teco_interface.info_dirty = buffer->dirty;
 	teco_interface.info_type = TECO_INFO_TYPE_BUFFER;
-	/* NOTE: drawn in teco_interface_event_loop_iter() */
+	teco_interface.damage |= TECO_DAMAGE_INFO;
+	/* NOTE: drawn in teco_interface_refresh() */
 }
 
 void
@@ -1202,30 +1289,63 @@ teco_interface_cmdline_update(const teco_cmdline_t *cmdline)
 	if (!teco_interface.cmdline_window) /* batch mode */
 		return;
 
+	short fg = teco_rgb2curses(teco_interface_ssm(SCI_STYLEGETFORE, STYLE_DEFAULT, 0));
+	short bg = teco_rgb2curses(teco_interface_ssm(SCI_STYLEGETBACK, STYLE_DEFAULT, 0));
+
 	/*
-	 * Replace entire pre-formatted command-line.
-	 * We don't know if it is similar to the last one,
-	 * so resizing makes no sense.
-	 * We approximate the size of the new formatted command-line,
-	 * wasting a few bytes for control characters and
-	 * multi-byte Unicode sequences.
-	 */
-	if (teco_interface.cmdline_pad)
-		delwin(teco_interface.cmdline_pad);
+	 * Only the part of the command line that changed since the last
+	 * update is formatted again.
+	 * Since the effective and rubbed out command lines are formatted
+	 * differently, this includes everything after the smaller of the
+	 * old and new effective lengths.
+	 */
+	gsize start = 0;
+	if (teco_interface.cmdline_pad &&
+	    teco_interface.cmdline_fg == fg && teco_interface.cmdline_bg == bg) {
+		start = teco_string_diff(&teco_interface.cmdline_str,
+		                         cmdline->str.data, cmdline->str.len);
+		start = MIN(start, MIN(teco_interface.cmdline_effective_len,
+		                       cmdline->effective_len));
+		/* start at the beginning of a UTF-8 sequence */
+		while (start > 0 && (cmdline->str.data[start] & 0xC0) == 0x80)
+			start--;
+	}
+	if (!teco_interface.cmdline_cols)
+		teco_interface.cmdline_cols = g_array_new(FALSE, FALSE, sizeof(guint));
+	guint start_col = start ? g_array_index(teco_interface.cmdline_cols, guint, start) : 0;
 
-	int max_cols = 1;
-	for (guint i = 0; i < cmdline->str.len; i++)
+	/*
+	 * Make sure the pad is large enough by approximating the size of the
+	 * formatted command-line, wasting a few bytes for control characters
+	 * and multi-byte Unicode sequences.
+	 * The pad grows by doubling, so only the unchanged part has to be
+	 * copied every now and then.
+	 */
+	guint max_cols = start_col + 1;
+	for (gsize i = start; i < cmdline->str.len; i++)
 		max_cols += TECO_IS_CTL(cmdline->str.data[i]) ? 3 : 1;
-	teco_interface.cmdline_pad = newpad(1, max_cols);
+	if (!teco_interface.cmdline_pad || (guint)getmaxx(teco_interface.cmdline_pad) < max_cols) {
+		WINDOW *pad = newpad(1, teco_interface.cmdline_pad
+					? MAX(max_cols, 2*getmaxx(teco_interface.cmdline_pad)) : max_cols);
+		if (teco_interface.cmdline_pad) {
+			if (start_col > 0)
+				copywin(teco_interface.cmdline_pad, pad,
+				        0, 0, 0, 0, 0, start_col-1, FALSE);
+			delwin(teco_interface.cmdline_pad);
+		}
+		teco_interface.cmdline_pad = pad;
+	}
 
-	short fg = teco_rgb2curses(teco_interface_ssm(SCI_STYLEGETFORE, STYLE_DEFAULT, 0));
-	short bg = teco_rgb2curses(teco_interface_ssm(SCI_STYLEGETBACK, STYLE_DEFAULT, 0));
-	wattrset(teco_interface.cmdline_pad, teco_color_attr(fg, bg));
+	teco_interface.cmdline_fg = fg;
+	teco_interface.cmdline_bg = bg;
+	teco_interface.cmdline_effective_len = cmdline->effective_len;
+	teco_string_truncate(&teco_interface.cmdline_str, start);
+	teco_string_append(&teco_interface.cmdline_str, cmdline->str.data + start,
+	                   cmdline->str.len - start);
+	g_array_set_size(teco_interface.cmdline_cols, start);
 
-	/* format effective command line */
-	teco_interface.cmdline_len =
-		teco_curses_format_str(teco_interface.cmdline_pad,
-		                       cmdline->str.data, cmdline->effective_len, -1);
+	wmove(teco_interface.cmdline_pad, 0, start_col);
+	wattrset(teco_interface.cmdline_pad, teco_color_attr(fg, bg));
 
 	/*
 	 * A_BOLD should result in either a bold font or a brighter
@@ -1238,17 +1358,29 @@ teco_interface_cmdline_update(const teco_cmdline_t *cmdline)
 	 * be user-configurable.
 	 * The attributes, supported by the terminal can theoretically
 	 * be queried with term_attrs().
-	 */
-	wattron(teco_interface.cmdline_pad, A_UNDERLINE | A_BOLD);
-
-	/*
-	 * Format rubbed-out command line.
+	 *
 	 * NOTE: This formatting will never be truncated since we're
 	 * writing into the pad which is large enough.
 	 */
-	teco_interface.cmdline_rubout_len =
-		teco_curses_format_str(teco_interface.cmdline_pad, cmdline->str.data + cmdline->effective_len,
-		                       cmdline->str.len - cmdline->effective_len, -1);
+	for (gsize i = start; i < cmdline->str.len; ) {
+		if (i == cmdline->effective_len)
+			/* format rubbed-out command line */
+			wattron(teco_interface.cmdline_pad, A_UNDERLINE | A_BOLD);
+
+		gsize clen = g_utf8_next_char(cmdline->str.data+i) - (cmdline->str.data+i);
+		guint col = getcurx(teco_interface.cmdline_pad);
+		for (gsize j = 0; j < clen; j++)
+			g_array_append_val(teco_interface.cmdline_cols, col);
+
+		teco_curses_format_str(teco_interface.cmdline_pad, cmdline->str.data+i, clen, -1);
+		i += clen;
+	}
+	guint end_col = getcurx(teco_interface.cmdline_pad);
+	g_array_append_val(teco_interface.cmdline_cols, end_col);
+
+	teco_interface.cmdline_len = g_array_index(teco_interface.cmdline_cols, guint,
+	                                           cmdline->effective_len);
+	teco_interface.cmdline_rubout_len = end_col - teco_interface.cmdline_len;
 
 	/*
 	 * Highlight cursor after effective command line
@@ -1298,6 +1430,7 @@ teco_interface_draw_cmdline(void)
 	teco_curses_clrtobot(teco_interface.cmdline_window);
 	copywin(teco_interface.cmdline_pad, teco_interface.cmdline_window,
 	        0, disp_offset, 0, 1, 0, disp_len, FALSE);
+	teco_interface.damage |= TECO_DAMAGE_CMDLINE;
 }
 
 #if PDCURSES
@@ -1775,7 +1908,7 @@ teco_interface_popup_add(teco_popup_entry_type_t type, const gchar *name, gsize
 }
 
 void
-teco_interface_popup_show(gsize prefix_len)
+teco_interface_popup_show(gsize prefix_len, gboolean case_sensitive)
 {
 	if (!teco_interface.cmdline_window)
 		/* batch mode */
@@ -1785,6 +1918,7 @@ teco_interface_popup_show(gsize prefix_len)
 	short bg = teco_rgb2curses(teco_interface_ssm(SCI_STYLEGETBACK, STYLE_CALLTIP, 0));
 
 	teco_interface.popup_prefix_len = prefix_len;
+	teco_interface.popup_case_sensitive = case_sensitive;
 	teco_curses_info_popup_show(&teco_interface.popup, teco_color_attr(fg, bg));
 }
 
@@ -1796,7 +1930,21 @@ teco_interface_popup_scroll(void)
 		return;
 
 	teco_curses_info_popup_scroll_page(&teco_interface.popup);
-	teco_interface_popup_show(teco_interface.popup_prefix_len);
+	teco_interface_popup_show(teco_interface.popup_prefix_len,
+	                          teco_interface.popup_case_sensitive);
+}
+
+gboolean
+teco_interface_popup_filter(const gchar *str, gsize len)
+{
+	if (!teco_curses_info_popup_is_shown(&teco_interface.popup) ||
+	    !teco_curses_info_popup_filter(&teco_interface.popup, teco_interface.popup_prefix_len,
+	                                   teco_interface.popup_case_sensitive, str, len))
+		return FALSE;
+
+	teco_interface_popup_show(teco_interface.popup_prefix_len + len,
+	                          teco_interface.popup_case_sensitive);
+	return TRUE;
 }
 
 gboolean
@@ -1827,6 +1975,67 @@ teco_interface_popup_clear(void)
 	teco_curses_info_popup_init(&teco_interface.popup);
 }
 
+/**
+ * Update the screen while executing macros in interactive mode.
+ *
+ * This is called very often via teco_interface_is_interrupted(),
+ * so it checks the clock only every now and then.
+ * Updates are coalesced to one per TECO_FRAME_INTERVAL and
+ * only windows that changed are copied to the screen.
+ * This makes progress visible without explicit ^W commands.
+ */
+static void
+teco_interface_pace(void)
+{
+	if (G_LIKELY(++teco_interface.pace_calls % 256) || !teco_interface.cmdline_window)
+		return;
+
+#ifdef NETBSD_CURSES
+	/* works around crashes in doupdate() */
+	if (G_UNLIKELY(getmaxx(stdscr) <= 1 || getmaxy(stdscr) <= 1))
+		return;
+#endif
+
+	gint64 now_ts = g_get_monotonic_time();
+	if (now_ts < teco_interface.frame_ts + TECO_FRAME_INTERVAL)
+		return;
+	teco_interface.frame_ts = now_ts;
+
+	sptr_t dot = teco_interface_ssm(SCI_GETCURRENTPOS, 0, 0);
+	sptr_t len = teco_interface_ssm(SCI_GETLENGTH, 0, 0);
+	if (teco_interface.frame_view != teco_interface_current_view ||
+	    teco_interface.frame_dot != dot || teco_interface.frame_len != len ||
+	    teco_interface.frame_modifications != teco_view_modifications) {
+		teco_interface.frame_view = teco_interface_current_view;
+		teco_interface.frame_dot = dot;
+		teco_interface.frame_len = len;
+		teco_interface.frame_modifications = teco_view_modifications;
+		teco_interface.damage |= TECO_DAMAGE_VIEW;
+	}
+
+	if (!teco_interface.damage)
+		return;
+
+	if (teco_interface.damage & TECO_DAMAGE_INFO) {
+		teco_interface_draw_info();
+		wnoutrefresh(teco_interface.info_window);
+	}
+	if (teco_interface.damage & TECO_DAMAGE_VIEW) {
+		/* the vertical scroll position is restored after the keypress */
+		teco_interface_ssm(SCI_SCROLLCARET, 0, 0);
+		teco_view_noutrefresh(teco_interface_current_view);
+	}
+	if (teco_interface.damage & TECO_DAMAGE_MSG)
+		wnoutrefresh(teco_interface.msg_window);
+	if (teco_interface.damage & TECO_DAMAGE_CMDLINE)
+		wnoutrefresh(teco_interface.cmdline_window);
+	/* the popup overlaps all windows but the command line */
+	teco_curses_info_popup_noutrefresh(&teco_interface.popup);
+	doupdate();
+
+	teco_interface.damage = 0;
+}
+
 #if defined(CURSES_TTY) || defined(PDCURSES_WINCON) || defined(NCURSES_WIN32)
 
 /*
@@ -1836,6 +2045,7 @@ teco_interface_popup_clear(void)
 gboolean
 teco_interface_is_interrupted(void)
 {
+	teco_interface_pace();
 	return teco_interrupted != FALSE;
 }
 
@@ -1847,7 +2057,7 @@ teco_interface_is_interrupted(void)
  * It's currently necessary as a fallback e.g. for PDCURSES_GUI or XCurses.
  *
  * NOTE: Theoretically, this can be optimized by doing wgetch() only every
- * TECO_POLL_INTERVAL microseconds like on Gtk+.
+ * TECO_FRAME_INTERVAL microseconds like on Gtk+.
  * But this turned out to slow things down, at least on PDCurses/WinGUI.
  */
 gboolean
@@ -1857,6 +2067,8 @@ teco_interface_is_interrupted(void)
 		/* batch mode */
 		return teco_interrupted != FALSE;
 
+	teco_interface_pace();
+
 	/*
 	 * NOTE: wgetch() is configured to be nonblocking.
 	 * We wgetch() on a dummy pad, so this does not call any
@@ -1906,6 +2118,13 @@ teco_interface_refresh(gboolean force)
 	wnoutrefresh(teco_interface.cmdline_window);
 	teco_curses_info_popup_noutrefresh(&teco_interface.popup);
 	doupdate();
+
+	teco_interface.damage = 0;
+	teco_interface.frame_ts = g_get_monotonic_time();
+	teco_interface.frame_view = teco_interface_current_view;
+	teco_interface.frame_dot = teco_interface_ssm(SCI_GETCURRENTPOS, 0, 0);
+	teco_interface.frame_len = teco_interface_ssm(SCI_GETLENGTH, 0, 0);
+	teco_interface.frame_modifications = teco_view_modifications;
 }
 
 #if NCURSES_MOUSE_VERSION >= 2
@@ -2065,6 +2284,36 @@ teco_interface_blocking_getch(void)
 	return key;
 }
 
+#ifdef CURSES_BRACKETED_PASTE
+
+/**
+ * Read pasted text up to the end of the bracketed paste
+ * and insert it into the command line.
+ *
+ * Key macros are not expanded for pasted text.
+ */
+static gboolean
+teco_interface_paste(GError **error)
+{
+	g_autoptr(GString) str = g_string_new(NULL);
+
+	for (;;) {
+		gint key = teco_interface_blocking_getch();
+		if (key == ERR || key == TECO_KEY_PASTE_END)
+			break;
+		if (key > 0xFF)
+			/* unexpected function key */
+			continue;
+
+		/* terminals report pasted linebreaks as Enter key presses */
+		g_string_append_c(str, key == '\r' ? '\n' : key);
+	}
+
+	return teco_cmdline_paste(str->str, str->len, error);
+}
+
+#endif
+
 /**
  * One iteration of the event loop.
  *
@@ -2122,6 +2371,15 @@ teco_interface_event_loop_iter(void)
 		if (!teco_cmdline_keymacro_c('\n', error))
 			return;
 		break;
+#ifdef CURSES_BRACKETED_PASTE
+	case TECO_KEY_PASTE_BEGIN:
+		if (!teco_interface_paste(error))
+			return;
+		break;
+	case TECO_KEY_PASTE_END:
+		/* stray end of pasted text */
+		return;
+#endif
 
 	/*
 	 * Function key macros
@@ -2297,6 +2555,9 @@ teco_interface_cleanup(void)
 		delwin(teco_interface.cmdline_window);
 	if (teco_interface.cmdline_pad)
 		delwin(teco_interface.cmdline_pad);
+	teco_string_clear(&teco_interface.cmdline_str);
+	if (teco_interface.cmdline_cols)
+		g_array_free(teco_interface.cmdline_cols, TRUE);
 	if (teco_interface.msg_window)
 		delwin(teco_interface.msg_window);
 	if (teco_interface.input_pad)
@@ -25,7 +25,6 @@
 #include <glib.h>
 #include <glib/gprintf.h>
 
-#include "list.h"
 #include "string-utils.h"
 #include "gtk-label.h"
 #include "gtk-info-popup.h"
@@ -34,10 +33,8 @@
  * FIXME: This is redundant with curses-info-popup.c.
  */
 typedef struct {
-	teco_stailq_entry_t entry;
-
-	teco_popup_entry_type_t type;
 	teco_string_t name;
+	teco_popup_entry_type_t type;
 	gboolean highlight;
 } teco_popup_entry_t;
 
@@ -49,7 +46,8 @@ struct _TecoGtkInfoPopup {
 	GtkWidget *flow_box;
 	GdkCursor *cursor; /*< pointer/hand cursor */
 	GStringChunk *chunk;
-	teco_stailq_head_t list;
+	GArray *entries;	/*< array of teco_popup_entry_t */
+	guint next_entry;	/*< index of the next entry to add to the flow box */
 	guint idle_id;
 	gboolean frozen;
 };
@@ -59,6 +57,8 @@ static guint teco_gtk_info_popup_clicked_signal;
 static gboolean teco_gtk_info_popup_scroll_event(GtkWidget *widget, GdkEventScroll *event);
 static void teco_gtk_info_popup_show(GtkWidget *widget);
 static void teco_gtk_info_popup_vadjustment_changed(GtkAdjustment *vadjustment, GtkWidget *scrollbar);
+static void teco_gtk_info_popup_vadjustment_value_changed(GtkAdjustment *vadjustment,
+                                                          TecoGtkInfoPopup *self);
 
 G_DEFINE_TYPE(TecoGtkInfoPopup, teco_gtk_info_popup, GTK_TYPE_EVENT_BOX)
 
@@ -71,9 +71,8 @@ teco_gtk_info_popup_finalize(GObject *obj_self)
 	if (self->chunk)
 		g_string_chunk_free(self->chunk);
 
-	teco_stailq_entry_t *entry;
-	while ((entry = teco_stailq_remove_head(&self->list)))
-		g_free(entry);
+	if (self->entries)
+		g_array_free(self->entries, TRUE);
 
 	if (self->cursor)
 		g_object_unref(self->cursor);
@@ -135,6 +134,9 @@ teco_gtk_info_popup_init(TecoGtkInfoPopup *self)
 	/* show/hide the scrollbar dynamically */
 	g_signal_connect(self->vadjustment, "changed",
 	                 G_CALLBACK(teco_gtk_info_popup_vadjustment_changed), scrollbar);
+	/* resume adding entries when scrolling */
+	g_signal_connect(self->vadjustment, "value-changed",
+	                 G_CALLBACK(teco_gtk_info_popup_vadjustment_value_changed), self);
 
 	self->flow_box = gtk_flow_box_new();
 	g_signal_connect(self->flow_box, "child-activated",
@@ -164,7 +166,8 @@ teco_gtk_info_popup_init(TecoGtkInfoPopup *self)
 	gtk_container_add(GTK_CONTAINER(self), box);
 
 	self->chunk = g_string_chunk_new(32);
-	self->list = TECO_STAILQ_HEAD_INITIALIZER(&self->list);
+	self->entries = g_array_new(FALSE, FALSE, sizeof(teco_popup_entry_t));
+	self->next_entry = 0;
 	self->idle_id = 0;
 	self->frozen = FALSE;
 }
@@ -271,15 +274,13 @@ teco_gtk_info_popup_add(TecoGtkInfoPopup *self, teco_popup_entry_type_t type,
 	g_return_if_fail (self != NULL);
 	g_return_if_fail (TECO_IS_GTK_INFO_POPUP (self));
 
-	teco_popup_entry_t *entry = g_new(teco_popup_entry_t, 1);
-	entry->type = type;
+	teco_popup_entry_t entry = {.type = type, .highlight = highlight};
 	/*
 	 * Popup entries aren't removed individually, so we can
 	 * more efficiently store them via GStringChunk.
 	 */
-	teco_string_init_chunk(&entry->name, name, len < 0 ? strlen(name) : len,
+	teco_string_init_chunk(&entry.name, name, len < 0 ? strlen(name) : len,
 	                       self->chunk);
-	entry->highlight = highlight;
 
 	/*
 	 * NOTE: We don't immediately create the Gtk+ widget and add it
@@ -288,13 +289,15 @@ teco_gtk_info_popup_add(TecoGtkInfoPopup *self, teco_popup_entry_type_t type,
 	 * Instead, we queue and process them in idle time only once the widget
 	 * is shown. This ensures a good reactivity, even though the popup may
 	 * not yet be complete when first shown.
+	 * Entries are only added as far as they can be scrolled to by
+	 * the next page, so huge popups are never built up completely.
 	 *
 	 * While it would be possible to show the widget before the first
 	 * add() call to achieve the same effect, this would prevent keyboard
 	 * interaction unless we add support for interruptions or drive
 	 * the event loop manually.
 	 */
-	teco_stailq_insert_tail(&self->list, &entry->entry);
+	g_array_append_val(self->entries, entry);
 }
 
 static void
@@ -381,8 +384,7 @@ teco_gtk_info_popup_idle_cb(TecoGtkInfoPopup *self)
 	 * but at the same time, the UI will be less responsive.
 	 */
 	for (gint i = 0; i < 5; i++) {
-		teco_popup_entry_t *head = (teco_popup_entry_t *)teco_stailq_remove_head(&self->list);
-		if (G_UNLIKELY(!head)) {
+		if (G_UNLIKELY(self->next_entry >= self->entries->len)) {
 			if (self->frozen)
 				gdk_window_thaw_updates(gtk_widget_get_window(GTK_WIDGET(self)));
 			self->frozen = FALSE;
@@ -390,10 +392,22 @@ teco_gtk_info_popup_idle_cb(TecoGtkInfoPopup *self)
 			return G_SOURCE_REMOVE;
 		}
 
-		teco_gtk_info_popup_idle_add(self, head->type, head->name.data, head->name.len, head->highlight);
+		const teco_popup_entry_t *entry = &g_array_index(self->entries, teco_popup_entry_t,
+		                                                 self->next_entry++);
+		teco_gtk_info_popup_idle_add(self, entry->type, entry->name.data, entry->name.len,
+		                             entry->highlight);
+	}
 
-		/* All teco_popup_entry_t::names are freed via GStringChunk */
-		g_free(head);
+	gdouble page_size = gtk_adjustment_get_page_size(self->vadjustment);
+	if (!self->frozen && page_size > 0 &&
+	    gtk_adjustment_get_upper(self->vadjustment) -
+	    gtk_adjustment_get_value(self->vadjustment) > 2*page_size) {
+		/*
+		 * The current and the next page are complete.
+		 * The remaining entries are added once we scroll.
+		 */
+		self->idle_id = 0;
+		return G_SOURCE_REMOVE;
 	}
 
 	if (self->frozen &&
@@ -407,13 +421,21 @@ teco_gtk_info_popup_idle_cb(TecoGtkInfoPopup *self)
 	return G_SOURCE_CONTINUE;
 }
 
+static void
+teco_gtk_info_popup_vadjustment_value_changed(GtkAdjustment *vadjustment, TecoGtkInfoPopup *self)
+{
+	if (!self->idle_id && self->next_entry < self->entries->len &&
+	    gtk_widget_get_visible(GTK_WIDGET(self)))
+		self->idle_id = gdk_threads_add_idle((GSourceFunc)teco_gtk_info_popup_idle_cb, self);
+}
+
 /** Overrides GtkWidget::show() */
 static void
 teco_gtk_info_popup_show(GtkWidget *widget)
 {
 	TecoGtkInfoPopup *self = TECO_GTK_INFO_POPUP(widget);
 
-	if (!self->idle_id) {
+	if (!self->idle_id && self->next_entry < self->entries->len) {
 		self->idle_id = gdk_threads_add_idle((GSourceFunc)teco_gtk_info_popup_idle_cb, self);
 
 		/*
@@ -441,7 +463,8 @@ teco_gtk_info_popup_scroll_page(TecoGtkInfoPopup *self)
 	GtkAdjustment *adj = self->vadjustment;
 	gdouble new_value;
 
-	if (gtk_adjustment_get_value(adj) + gtk_adjustment_get_page_size(adj) ==
+	if (self->next_entry >= self->entries->len &&
+	    gtk_adjustment_get_value(adj) + gtk_adjustment_get_page_size(adj) ==
 	    gtk_adjustment_get_upper(adj)) {
 		/* wrap and scroll back to the top */
 		new_value = gtk_adjustment_get_lower(adj);
@@ -484,9 +507,50 @@ teco_gtk_info_popup_clear(TecoGtkInfoPopup *self)
 	 * If there are still queued popoup entries, the next teco_gtk_info_popup_idle_cb()
 	 * invocation will also stop the GSource.
 	 */
-	teco_stailq_entry_t *entry;
-	while ((entry = teco_stailq_remove_head(&self->list)))
-		g_free(entry);
+	g_array_set_size(self->entries, 0);
+	self->next_entry = 0;
 
 	g_string_chunk_clear(self->chunk);
 }
+
+/**
+ * Narrow down the popup entries.
+ *
+ * Only entries continuing with the given string after their
+ * first `prefix_len` bytes are kept.
+ * They are compared without considering case unless `case_sensitive` is set.
+ * The flow box is built up again from the remaining entries.
+ *
+ * @return The number of entries left
+ */
+guint
+teco_gtk_info_popup_filter(TecoGtkInfoPopup *self, gsize prefix_len,
+                           gboolean case_sensitive, const gchar *str, gsize len)
+{
+	g_return_val_if_fail(self != NULL, 0);
+	g_return_val_if_fail(TECO_IS_GTK_INFO_POPUP(self), 0);
+
+	teco_string_diff_t diff = case_sensitive ? teco_string_diff : teco_string_casediff;
+
+	guint kept = 0;
+	for (guint i = 0; i < self->entries->len; i++) {
+		teco_popup_entry_t *entry = &g_array_index(self->entries, teco_popup_entry_t, i);
+		if (entry->name.len < prefix_len + len)
+			continue;
+
+		const teco_string_t suffix = {entry->name.data + prefix_len,
+		                              entry->name.len - prefix_len};
+		if (diff(&suffix, str, len) == len)
+			g_array_index(self->entries, teco_popup_entry_t, kept++) = *entry;
+	}
+	g_array_set_size(self->entries, kept);
+
+	gtk_container_foreach(GTK_CONTAINER(self->flow_box), teco_gtk_info_popup_destroy_cb, NULL);
+	self->next_entry = 0;
+	gtk_adjustment_set_value(self->vadjustment, gtk_adjustment_get_lower(self->vadjustment));
+
+	if (!self->idle_id && kept > 0 && gtk_widget_get_visible(GTK_WIDGET(self)))
+		self->idle_id = gdk_threads_add_idle((GSourceFunc)teco_gtk_info_popup_idle_cb, self);
+
+	return kept;
+}
@@ -34,6 +34,8 @@ void teco_gtk_info_popup_add(TecoGtkInfoPopup *self,
                              teco_popup_entry_type_t type,
                              const gchar *name, gssize len,
                              gboolean highlight);
+guint teco_gtk_info_popup_filter(TecoGtkInfoPopup *self, gsize prefix_len,
+                                 gboolean case_sensitive, const gchar *str, gsize len);
 void teco_gtk_info_popup_scroll_page(TecoGtkInfoPopup *self);
 void teco_gtk_info_popup_clear(TecoGtkInfoPopup *self);
 
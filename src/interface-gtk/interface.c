@@ -110,6 +110,8 @@ static struct {
 		TECO_INFO_TYPE_QREG
 	} info_type;
 	teco_string_t info_current;
+	/** Whether the info bar must be refreshed */
+	gboolean info_damaged;
 
 	gboolean no_csd;
 	gint xembed_id;
@@ -130,6 +132,7 @@ static struct {
 
 	GtkWidget *popup_widget;
 	gsize popup_prefix_len;
+	gboolean popup_case_sensitive;
 
 	GtkWidget *current_view_widget;
 
@@ -591,6 +594,7 @@ teco_interface_info_update_qreg(const teco_qreg_t *reg)
 	teco_string_init(&teco_interface.info_current,
 	                 reg->head.name.data, reg->head.name.len);
         teco_interface.info_type = TECO_INFO_TYPE_QREG;
+	teco_interface.info_damaged = TRUE;
 }
 
 void
@@ -602,6 +606,7 @@ teco_interface_info_update_buffer(const teco_buffer_t *buffer)
 	teco_string_init(&teco_interface.info_current, filename, strlen(filename));
 	teco_interface.info_type = buffer->dirty ? TECO_INFO_TYPE_BUFFER_DIRTY
 	                                         : TECO_INFO_TYPE_BUFFER;
+	teco_interface.info_damaged = TRUE;
 }
 
 /**
@@ -794,9 +799,10 @@ teco_interface_popup_add(teco_popup_entry_type_t type, const gchar *name, gsize
 }
 
 void
-teco_interface_popup_show(gsize prefix_len)
+teco_interface_popup_show(gsize prefix_len, gboolean case_sensitive)
 {
 	teco_interface.popup_prefix_len = prefix_len;
+	teco_interface.popup_case_sensitive = case_sensitive;
 	gtk_widget_show(teco_interface.popup_widget);
 }
 
@@ -806,6 +812,19 @@ teco_interface_popup_scroll(void)
 	teco_gtk_info_popup_scroll_page(TECO_GTK_INFO_POPUP(teco_interface.popup_widget));
 }
 
+gboolean
+teco_interface_popup_filter(const gchar *str, gsize len)
+{
+	if (!gtk_widget_get_visible(teco_interface.popup_widget) ||
+	    !teco_gtk_info_popup_filter(TECO_GTK_INFO_POPUP(teco_interface.popup_widget),
+	                                teco_interface.popup_prefix_len,
+	                                teco_interface.popup_case_sensitive, str, len))
+		return FALSE;
+
+	teco_interface.popup_prefix_len += len;
+	return TRUE;
+}
+
 gboolean
 teco_interface_popup_is_shown(void)
 {
@@ -841,17 +860,28 @@ teco_interface_is_interrupted(void)
 		return teco_interrupted != FALSE;
 
 	/*
-	 * By polling only every TECO_POLL_INTERVAL microseconds
+	 * By polling only every TECO_FRAME_INTERVAL microseconds
 	 * we save 75-90% of runtime.
 	 */
 	static guint64 last_poll_ts = 0;
 	guint64 now_ts = g_get_monotonic_time();
 
-	if (G_LIKELY(last_poll_ts+TECO_POLL_INTERVAL > now_ts))
+	if (G_LIKELY(last_poll_ts+TECO_FRAME_INTERVAL > now_ts))
 		return teco_interrupted != FALSE;
 	last_poll_ts = now_ts;
 
-	gtk_main_iteration_do(FALSE);
+	/*
+	 * Painting also polls for keypresses.
+	 * Gtk keeps track of damaged widgets itself, so only
+	 * pending info bar updates have to be applied.
+	 * View changes are still deferred to teco_interface_update()
+	 * since the size reallocations are very costly.
+	 */
+	if (teco_interface.info_damaged) {
+		teco_interface_refresh_info();
+		teco_interface.info_damaged = FALSE;
+	}
+	teco_interface_refresh(FALSE);
 	return teco_interrupted != FALSE;
 }
 
@@ -972,6 +1002,7 @@ teco_interface_update(gboolean current_view_changed)
 	 * the size reallocations are very costly.
 	 */
 	teco_interface_refresh_info();
+	teco_interface.info_damaged = FALSE;
 
 	if (current_view_changed) {
 		/*
@@ -1001,9 +1032,17 @@ static void
 teco_interface_cmdline_commit_cb(GtkIMContext *context, gchar *str, gpointer user_data)
 {
 	g_autoptr(GError) error = NULL;
+	gsize len = strlen(str);
 
-	if (!teco_cmdline_keypress(str, strlen(str), &error) &&
-	    g_error_matches(error, TECO_ERROR, TECO_ERROR_QUIT))
+	/*
+	 * Input methods may commit entire strings at once,
+	 * e.g. when pasting text.
+	 * These are inserted more efficiently than single key presses.
+	 */
+	gboolean rc = len > 0 && *g_utf8_next_char(str)
+			? teco_cmdline_paste(str, len, &error)
+			: teco_cmdline_keypress(str, len, &error);
+	if (!rc && g_error_matches(error, TECO_ERROR, TECO_ERROR_QUIT))
 		gtk_main_quit();
 }
 
@@ -28,6 +28,7 @@
 #include <Scintilla.h>
 #include <ScintillaWidget.h>
 
+#include "stats.h"
 #include "view.h"
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(ScintillaObject, g_object_unref)
@@ -127,6 +128,7 @@ static void teco_view_init(TecoView *self) {}
 sptr_t
 teco_view_ssm(teco_view_t *ctx, unsigned int iMessage, uptr_t wParam, sptr_t lParam)
 {
+	teco_stats_inc_message(iMessage);
 	return scintilla_send_message(SCINTILLA(ctx), iMessage, wParam, lParam);
 }
 
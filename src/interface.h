@@ -47,6 +47,12 @@
  */
 #define TECO_POLL_INTERVAL 100000 /* microseconds */
 
+/**
+ * Minimum interval between screen updates while executing macros
+ * in interactive mode, i.e. the screen is updated with at most 25 FPS.
+ */
+#define TECO_FRAME_INTERVAL 40000 /* microseconds */
+
 /** @protected */
 extern teco_view_t *teco_interface_current_view;
 
@@ -141,10 +147,30 @@ typedef enum {
 /** @pure */
 void teco_interface_popup_add(teco_popup_entry_type_t type,
                               const gchar *name, gsize name_len, gboolean highlight);
-/** @pure */
-void teco_interface_popup_show(gsize prefix_len);
+/**
+ * Show the popup.
+ *
+ * @param prefix_len Length of the prefix common to all entries
+ * @param case_sensitive Whether entries are compared case-sensitively
+ *   when narrowing down the popup
+ *   (see teco_interface_popup_filter()).
+ *   This should match the comparison used for completions.
+ *
+ * @pure
+ */
+void teco_interface_popup_show(gsize prefix_len, gboolean case_sensitive);
 /** @pure */
 void teco_interface_popup_scroll(void);
+/**
+ * Narrow down the entries of the shown popup to those continuing
+ * with the given string and extend its prefix accordingly.
+ *
+ * @return FALSE if no popup is shown or no entries are left.
+ *   The popup should be cleared in this case.
+ *
+ * @pure
+ */
+gboolean teco_interface_popup_filter(const gchar *str, gsize len);
 /** @pure */
 gboolean teco_interface_popup_is_shown(void);
 /** @pure */
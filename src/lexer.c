@@ -26,8 +26,235 @@
 #include "sciteco.h"
 #include "view.h"
 #include "parser.h"
+#include "qreg-commands.h"
 #include "lexer.h"
 
+/*
+ * Parser state checkpoints.
+ *
+ * Lines without a clean parser state (e.g. within @^Uq{...} macro definitions)
+ * would otherwise require lexing to restart from the last clean line.
+ * Instead, the state of both the main and macro definition machines at the
+ * end of such lines is recorded if it can be reconstructed without any
+ * auxiliary data.
+ * Since only few distinct states occur in practice, they are interned into a
+ * global table and their indices are stored in the line state.
+ * Scintilla thereby takes care of shifting and invalidating them along with
+ * modifications of the document.
+ */
+#define TECO_LEXER_CHECKPOINTS_MAX (1 << 16)
+
+/** Line state of lines without a clean parser state and without a checkpoint */
+#define TECO_LEXER_LINESTATE_NONE (-1)
+/** Line states smaller than this refer to checkpoints */
+#define TECO_LEXER_LINESTATE_CHECKPOINT (-2)
+
+typedef struct {
+	teco_state_t *state;
+	teco_mode_t mode;
+	guint modifier_colon;
+	gboolean modifier_at;
+	guint brace_level;
+	gint nest_level;
+
+	gint nesting;
+	gunichar escape_char;
+	teco_state_t *stringbuilding_state;
+	guint stringbuilding_mode;
+} teco_lexer_machine_snapshot_t;
+
+typedef struct {
+	teco_lexer_machine_snapshot_t machine;
+	teco_lexer_machine_snapshot_t macrodef_machine;
+} teco_lexer_checkpoint_t;
+
+static struct {
+	/** interned checkpoints (GBytes) by index */
+	GPtrArray *list;
+	/** maps checkpoints (GBytes) to their index+1 */
+	GHashTable *table;
+} teco_lexer_checkpoints = {NULL, NULL};
+
+static gboolean
+teco_lexer_machine_snapshot(teco_lexer_machine_snapshot_t *snapshot, teco_machine_main_t *machine)
+{
+	/*
+	 * Q-Register specifications, goto labels and incomplete string building
+	 * constructs would require auxiliary state.
+	 * Expected string arguments are not accumulated while lexing.
+	 */
+	if (machine->goto_label.len ||
+	    !machine->expectstring.machine.parent.current->is_start ||
+	    machine->parent.current->initial_cb == (teco_state_initial_cb_t)teco_state_expectqreg_initial)
+		return FALSE;
+
+	snapshot->state = machine->parent.current;
+	snapshot->mode = machine->flags.mode;
+	snapshot->modifier_colon = machine->flags.modifier_colon;
+	snapshot->modifier_at = machine->flags.modifier_at;
+	snapshot->brace_level = machine->brace_level;
+	snapshot->nest_level = machine->nest_level;
+
+	snapshot->nesting = machine->expectstring.nesting;
+	snapshot->escape_char = machine->expectstring.machine.escape_char;
+	snapshot->stringbuilding_state = machine->expectstring.machine.parent.current;
+	snapshot->stringbuilding_mode = machine->expectstring.machine.mode;
+	return TRUE;
+}
+
+static void
+teco_lexer_machine_restore(teco_machine_main_t *machine, const teco_lexer_machine_snapshot_t *snapshot)
+{
+	machine->parent.current = snapshot->state;
+	machine->flags.mode = snapshot->mode;
+	machine->flags.modifier_colon = snapshot->modifier_colon;
+	machine->flags.modifier_at = snapshot->modifier_at;
+	machine->brace_level = snapshot->brace_level;
+	machine->nest_level = snapshot->nest_level;
+
+	machine->expectstring.nesting = snapshot->nesting;
+	machine->expectstring.machine.escape_char = snapshot->escape_char;
+	machine->expectstring.machine.parent.current = snapshot->stringbuilding_state;
+	machine->expectstring.machine.mode = snapshot->stringbuilding_mode;
+}
+
+/**
+ * Record the current state of the lexer's machines.
+ *
+ * @return The line state referring to the checkpoint or
+ *   TECO_LEXER_LINESTATE_NONE if no checkpoint can be recorded.
+ */
+static gint
+teco_lexer_checkpoint_save(teco_machine_main_t *machine, teco_machine_main_t *macrodef_machine)
+{
+	teco_lexer_checkpoint_t checkpoint;
+
+	/* the struct is hashed bytewise, so padding must be initialized */
+	memset(&checkpoint, 0, sizeof(checkpoint));
+	if (!teco_lexer_machine_snapshot(&checkpoint.machine, machine) ||
+	    !teco_lexer_machine_snapshot(&checkpoint.macrodef_machine, macrodef_machine))
+		return TECO_LEXER_LINESTATE_NONE;
+
+	if (G_UNLIKELY(!teco_lexer_checkpoints.table)) {
+		teco_lexer_checkpoints.list = g_ptr_array_new_with_free_func((GDestroyNotify)g_bytes_unref);
+		teco_lexer_checkpoints.table = g_hash_table_new(g_bytes_hash, g_bytes_equal);
+	}
+
+	g_autoptr(GBytes) bytes = g_bytes_new(&checkpoint, sizeof(checkpoint));
+	guint id = GPOINTER_TO_UINT(g_hash_table_lookup(teco_lexer_checkpoints.table, bytes));
+	if (!id) {
+		if (teco_lexer_checkpoints.list->len >= TECO_LEXER_CHECKPOINTS_MAX)
+			return TECO_LEXER_LINESTATE_NONE;
+		g_ptr_array_add(teco_lexer_checkpoints.list, g_bytes_ref(bytes));
+		id = teco_lexer_checkpoints.list->len;
+		g_hash_table_insert(teco_lexer_checkpoints.table, bytes, GUINT_TO_POINTER(id));
+	}
+
+	return TECO_LEXER_LINESTATE_CHECKPOINT - (gint)(id - 1);
+}
+
+static void
+teco_lexer_checkpoint_restore(gint line_state, teco_machine_main_t *machine,
+                              teco_machine_main_t *macrodef_machine)
+{
+	guint id = TECO_LEXER_LINESTATE_CHECKPOINT - line_state;
+	g_assert(teco_lexer_checkpoints.list != NULL && id < teco_lexer_checkpoints.list->len);
+	const teco_lexer_checkpoint_t *checkpoint;
+	checkpoint = g_bytes_get_data(g_ptr_array_index(teco_lexer_checkpoints.list, id), NULL);
+
+	teco_lexer_machine_restore(machine, &checkpoint->machine);
+	teco_lexer_machine_restore(macrodef_machine, &checkpoint->macrodef_machine);
+}
+
+static void TECO_DEBUG_CLEANUP
+teco_lexer_checkpoints_cleanup(void)
+{
+	if (!teco_lexer_checkpoints.table)
+		return;
+	g_hash_table_unref(teco_lexer_checkpoints.table);
+	g_ptr_array_unref(teco_lexer_checkpoints.list);
+}
+
+/*
+ * Styling state of a single teco_lexer_style() pass.
+ *
+ * Styles are accumulated and flushed with SCI_SETSTYLINGEX
+ * and fold levels are set only once per line,
+ * since the Scintilla messages would otherwise dominate lexing time.
+ */
+#define TECO_LEXER_STYLES_SIZE 4096
+
+typedef struct {
+	teco_view_t *view;
+
+	/** lexer properties, read once per pass */
+	gboolean fold;
+	gboolean macrodef;
+
+	/** document position of styles[0] */
+	gsize styles_pos;
+	/** number of buffered styles */
+	guint styles_len;
+	gchar styles[TECO_LEXER_STYLES_SIZE];
+
+	/** fold level of the current line or -1 if it should not be set */
+	gint fold_level;
+} teco_lexer_t;
+
+static void
+teco_lexer_flush_styles(teco_lexer_t *ctx)
+{
+	if (!ctx->styles_len)
+		return;
+
+	teco_view_ssm(ctx->view, SCI_STARTSTYLING, ctx->styles_pos, 0);
+	teco_view_ssm(ctx->view, SCI_SETSTYLINGEX, ctx->styles_len, (sptr_t)ctx->styles);
+	ctx->styles_pos += ctx->styles_len;
+	ctx->styles_len = 0;
+}
+
+/**
+ * Style a range of the document.
+ *
+ * The range may overlap with already styled bytes,
+ * as long as it does not leave a gap behind the styled bytes.
+ */
+static void
+teco_lexer_set_styling(teco_lexer_t *ctx, gsize pos, gsize len, teco_style_t style)
+{
+	g_assert(pos <= ctx->styles_pos + ctx->styles_len);
+
+	if (G_UNLIKELY(pos < ctx->styles_pos)) {
+		/* restyle bytes already flushed (or before the styled range) */
+		gsize flushed = MIN(ctx->styles_pos - pos, len);
+		teco_view_ssm(ctx->view, SCI_STARTSTYLING, pos, 0);
+		teco_view_ssm(ctx->view, SCI_SETSTYLING, flushed, style);
+		pos += flushed;
+		len -= flushed;
+	}
+
+	guint i = pos - ctx->styles_pos;
+	while (len > 0) {
+		if (i == TECO_LEXER_STYLES_SIZE) {
+			teco_lexer_flush_styles(ctx);
+			i = 0;
+		}
+		ctx->styles[i++] = style;
+		ctx->styles_len = MAX(ctx->styles_len, i);
+		len--;
+	}
+}
+
+static void
+teco_lexer_flush_fold_level(teco_lexer_t *ctx, guint line)
+{
+	if (ctx->fold_level < 0)
+		return;
+
+	teco_view_ssm(ctx->view, SCI_SETFOLDLEVEL, line, ctx->fold_level);
+	ctx->fold_level = -1;
+}
+
 static teco_style_t
 teco_lexer_getstyle(teco_view_t *view, teco_machine_main_t *machine,
                     gunichar chr)
@@ -88,17 +315,18 @@ teco_lexer_getstyle(teco_view_t *view, teco_machine_main_t *machine,
 }
 
 static void
-teco_lexer_step(teco_view_t *view, teco_machine_main_t *machine,
+teco_lexer_step(teco_lexer_t *lexer, teco_machine_main_t *machine,
                 teco_machine_main_t *macrodef_machine,
                 const gchar *macro, gsize start, gsize max_len,
                 guint *cur_line, guint *cur_col, gint *safe_col)
 {
+	teco_view_t *view = lexer->view;
+
 	if (*cur_line == 0 && *cur_col == 0 && *macro == '#') {
 		/* hash-bang line */
 		machine->macro_pc = teco_view_ssm(view, SCI_POSITIONFROMLINE, 1, 0);
-		teco_view_ssm(view, SCI_STARTSTYLING, 0, 0);
-		teco_view_ssm(view, SCI_SETSTYLING, machine->macro_pc, SCE_SCITECO_COMMENT);
-		teco_view_ssm(view, SCI_SETLINESTATE, 0, -1);
+		teco_lexer_set_styling(lexer, 0, machine->macro_pc, SCE_SCITECO_COMMENT);
+		teco_view_ssm(view, SCI_SETLINESTATE, 0, TECO_LEXER_LINESTATE_NONE);
 		(*cur_line)++;
 		*safe_col = 0;
 		return;
@@ -140,16 +368,16 @@ teco_lexer_step(teco_view_t *view, teco_machine_main_t *machine,
 		 *
 		 * FIXME: You cannot practically disable folding via properties.
 		 */
-		if (teco_view_ssm(view, SCI_GETPROPERTYINT, (uptr_t)"fold", TRUE)) {
+		if (lexer->fold) {
 			guint next_fold_level = SC_FOLDLEVELBASE+machine->expectstring.nesting-1+
 			                        (machine->expectstring.machine.escape_char == '{' ? 1 : 0);
 
+			/* the fold level is set at the end of the line */
 			if (next_fold_level > fold_level)
 				/* `chr` opened a {...} string argument */
-				teco_view_ssm(view, SCI_SETFOLDLEVEL, *cur_line,
-				              fold_level | SC_FOLDLEVELHEADERFLAG);
+				lexer->fold_level = fold_level | SC_FOLDLEVELHEADERFLAG;
 			else if (!*cur_col)
-				teco_view_ssm(view, SCI_SETFOLDLEVEL, *cur_line, fold_level);
+				lexer->fold_level = fold_level;
 		}
 
 		/*
@@ -165,7 +393,7 @@ teco_lexer_step(teco_view_t *view, teco_machine_main_t *machine,
 		 * rewrite the lexer against the ILexer5 interface, which requires C++.
 		 */
 		if ((escape_char == '{' || machine->expectstring.machine.escape_char == '{') &&
-		    teco_view_ssm(view, SCI_GETPROPERTYINT, (uptr_t)"lexer.sciteco.macrodef", TRUE))
+		    lexer->macrodef)
 			style = teco_lexer_getstyle(view, macrodef_machine, chr);
 	}
 
@@ -178,15 +406,20 @@ teco_lexer_step(teco_view_t *view, teco_machine_main_t *machine,
 	if (style == SCE_SCITECO_COMMENT)
 		old_pc--;
 
-	teco_view_ssm(view, SCI_STARTSTYLING, start+old_pc, 0);
-	teco_view_ssm(view, SCI_SETSTYLING, machine->macro_pc-old_pc, style);
+	teco_lexer_set_styling(lexer, start+old_pc, machine->macro_pc-old_pc, style);
 
 	if (chr == '\n') {
-		/* update line state to the last column with a clean start state */
-		teco_view_ssm(view, SCI_SETLINESTATE, *cur_line, *safe_col);
+		/*
+		 * Update line state to the last column with a clean start state.
+		 * Otherwise try to record the state at the beginning of the next line.
+		 */
+		gint line_state = *safe_col >= 0 ? *safe_col
+		                                 : teco_lexer_checkpoint_save(machine, macrodef_machine);
+		teco_view_ssm(view, SCI_SETLINESTATE, *cur_line, line_state);
+		teco_lexer_flush_fold_level(lexer, *cur_line);
 		(*cur_line)++;
 		*cur_col = 0;
-		*safe_col = -1; /* no clean state by default */
+		*safe_col = TECO_LEXER_LINESTATE_NONE; /* no clean state by default */
 	}
 
 	if (style != SCE_SCITECO_INVALID &&
@@ -217,16 +450,24 @@ teco_lexer_style(teco_view_t *view, gsize end)
 	/*
 	 * The line state stores the laster character (column) in bytes,
 	 * that starts from a fresh parser state.
-	 * It's -1 if the line does not have a clean parser state.
+	 * It's TECO_LEXER_LINESTATE_NONE if the line does not have a clean parser state
+	 * and refers to a checkpoint of the state at the end of the line
+	 * if it is smaller than that.
 	 * Therefore we search for the first line before `start` that has a
-	 * known clean parser state.
+	 * known clean parser state or checkpoint.
 	 */
+	gint line_state = TECO_LEXER_LINESTATE_NONE;
 	if (start_line > 0) {
 		do
 			start_line--;
-		while ((start_col = teco_view_ssm(view, SCI_GETLINESTATE, start_line, 0)) < 0 &&
+		while ((line_state = teco_view_ssm(view, SCI_GETLINESTATE, start_line, 0)) == TECO_LEXER_LINESTATE_NONE &&
 		       start_line > 0);
-		start_col = MAX(start_col, 0);
+
+		if (line_state <= TECO_LEXER_LINESTATE_CHECKPOINT)
+			/* continue at the beginning of the next line */
+			start_line++;
+		else
+			start_col = MAX(line_state, 0);
 	}
 	start = teco_view_ssm(view, SCI_POSITIONFROMLINE, start_line, 0) + start_col;
 	g_assert(end > start);
@@ -243,6 +484,20 @@ teco_lexer_style(teco_view_t *view, gsize end)
 	g_assert(start_col >= 0);
 	guint col = start_col;
 
+	if (line_state <= TECO_LEXER_LINESTATE_CHECKPOINT) {
+		teco_lexer_checkpoint_restore(line_state, &machine, &macrodef_machine);
+		/* the first column does not have a clean state */
+		start_col = TECO_LEXER_LINESTATE_NONE;
+	}
+
+	teco_lexer_t lexer = {
+		.view = view,
+		.fold = teco_view_ssm(view, SCI_GETPROPERTYINT, (uptr_t)"fold", TRUE),
+		.macrodef = teco_view_ssm(view, SCI_GETPROPERTYINT, (uptr_t)"lexer.sciteco.macrodef", TRUE),
+		.styles_pos = start,
+		.fold_level = -1
+	};
+
 	/*
 	 * NOTE: We could have also used teco_view_get_character(),
 	 * but this will use much less Scintilla messages without
@@ -253,7 +508,7 @@ teco_lexer_style(teco_view_t *view, gsize end)
 	if (start < gap && gap < end) {
 		macro = (const gchar *)teco_view_ssm(view, SCI_GETRANGEPOINTER, start, gap);
 		while (machine.macro_pc < gap-start)
-			teco_lexer_step(view, &machine, &macrodef_machine,
+			teco_lexer_step(&lexer, &machine, &macrodef_machine,
 			                macro, start, gap-start,
 			                &start_line, &col, &start_col);
 		/*
@@ -266,12 +521,15 @@ teco_lexer_style(teco_view_t *view, gsize end)
 	macro = (const gchar *)teco_view_ssm(view, SCI_GETRANGEPOINTER, start, end-start);
 	machine.macro_pc = 0;
 	while (machine.macro_pc < end-start)
-		teco_lexer_step(view, &machine, &macrodef_machine,
+		teco_lexer_step(&lexer, &machine, &macrodef_machine,
 		                macro, start, end-start,
 		                &start_line, &col, &start_col);
 
-	/* set line state on the very last line */
+	teco_lexer_flush_styles(&lexer);
+
+	/* set line state and fold level on the very last line */
 	teco_view_ssm(view, SCI_SETLINESTATE, start_line, start_col);
+	teco_lexer_flush_fold_level(&lexer, start_line);
 
 	teco_undo_enabled = old_undo_enabled;
 }
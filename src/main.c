@@ -46,11 +46,16 @@
 #include "interface.h"
 #include "parser.h"
 #include "goto.h"
+#include "help.h"
 #include "qreg.h"
 #include "view.h"
 #include "ring.h"
 #include "undo.h"
 #include "error.h"
+#include "image.h"
+#include "profiler.h"
+#include "stats.h"
+#include "server.h"
 
 /*
  * Define this to pause the program at the beginning
@@ -122,8 +127,20 @@ static gchar *teco_eval_macro = NULL;
 static gboolean teco_mung_file = FALSE;
 static gboolean teco_mung_profile = TRUE;
 static gchar *teco_fake_cmdline = NULL;
+static gchar *teco_fake_paste = NULL;
 static gboolean teco_sandbox = FALSE;
 static gboolean teco_8bit_clean = FALSE;
+static gboolean teco_startup_profile = FALSE;
+static gboolean teco_show_stats = FALSE;
+static gchar *teco_stream_separator = NULL;
+static gchar *teco_image_filename = NULL;
+static gchar *teco_macro_profile_filename = NULL;
+static gchar *teco_help_index_path = NULL;
+#ifdef TECO_SERVER
+static gchar *teco_server_socket = NULL;
+static gchar *teco_client_socket = NULL;
+static gint teco_jobs = 0;
+#endif
 
 static gchar *
 teco_process_options(gchar ***argv)
@@ -150,11 +167,38 @@ teco_process_options(gchar ***argv)
 		{"fake-cmdline", 0, G_OPTION_FLAG_HIDDEN,
 		 G_OPTION_ARG_STRING, &teco_fake_cmdline,
 		 "Emulate key presses in batch mode (for debugging)", "keys"},
+		{"fake-paste", 0, G_OPTION_FLAG_HIDDEN,
+		 G_OPTION_ARG_STRING, &teco_fake_paste,
+		 "Emulate pasted text before --fake-cmdline key presses (for debugging)", "text"},
 		{"sandbox", 0, G_OPTION_FLAG_HIDDEN,
 		 G_OPTION_ARG_NONE, &teco_sandbox,
 		 "Sandbox application (for debugging)"},
 		{"8bit", '8', 0, G_OPTION_ARG_NONE, &teco_8bit_clean,
 		 "Use ANSI encoding by default and disable automatic EOL conversion"},
+		{"startup-profile", 0, 0, G_OPTION_ARG_NONE, &teco_startup_profile,
+		 "Print the time spent munging the profile and every included file to stderr"},
+		{"stats", 0, 0, G_OPTION_ARG_NONE, &teco_show_stats,
+		 "Print the values of internal counters (see EJ) to stderr on exit"},
+		{"macro-profile", 0, 0, G_OPTION_ARG_FILENAME, &teco_macro_profile_filename,
+		 "Sample the macro call stack, writing folded stacks to the given file "
+		 "and a per-command histogram to stderr", "file"},
+		{"stream", 0, 0, G_OPTION_ARG_STRING, &teco_stream_separator,
+		 "Filter stdin into stdout, executing the macro or script on every record "
+		 "terminated by the separator (supports C escapes like \"\\n\")", "separator"},
+		{"image", 0, 0, G_OPTION_ARG_FILENAME, &teco_image_filename,
+		 "Restore the effects of library files included by the profile from "
+		 "the given state image, updating it if necessary", "file"},
+		{"make-help-index", 0, 0, G_OPTION_ARG_FILENAME, &teco_help_index_path,
+		 "Generate the help topic index for the womanpages in the given directory "
+		 "and exit", "directory"},
+#ifdef TECO_SERVER
+		{"server", 0, 0, G_OPTION_ARG_FILENAME, &teco_server_socket,
+		 "Execute jobs of --client invocations, listening on the given socket", "socket"},
+		{"client", 0, 0, G_OPTION_ARG_FILENAME, &teco_client_socket,
+		 "Execute this invocation as a job on the --server listening on the given socket", "socket"},
+		{"jobs", 'j', 0, G_OPTION_ARG_INT, &teco_jobs,
+		 "Execute the script or macro once for every argument in up to N parallel processes", "N"},
+#endif
 		{NULL}
 	};
 
@@ -256,6 +300,38 @@ teco_process_options(gchar ***argv)
 		mung_filename = teco_strv_remove(*argv, 1);
 	}
 
+	if (teco_stream_separator) {
+		gchar *separator = g_strcompress(teco_stream_separator);
+		g_free(teco_stream_separator);
+		teco_stream_separator = separator;
+
+		if (!*teco_stream_separator || (!teco_eval_macro && !mung_filename)) {
+			g_fprintf(stderr, "--stream expects a non-empty separator and --eval or --mung!\n");
+			exit(EXIT_FAILURE);
+		}
+		/* records are read from stdin and written to stdout anyway */
+		teco_stdin = teco_stdout = FALSE;
+	}
+
+#ifdef TECO_SERVER
+	if (teco_jobs > 0 && teco_stream_separator) {
+		g_fprintf(stderr, "--jobs cannot be combined with --stream!\n");
+		exit(EXIT_FAILURE);
+	}
+	if (teco_jobs < 0 || (teco_jobs > 0 && !teco_eval_macro && !mung_filename)) {
+		g_fprintf(stderr, "--jobs expects a positive number of processes and --eval or --mung!\n");
+		exit(EXIT_FAILURE);
+	}
+	if (teco_jobs > 0 && teco_stdin) {
+		g_fprintf(stderr, "--jobs cannot be combined with --stdin!\n");
+		exit(EXIT_FAILURE);
+	}
+	if (teco_jobs > 0 && teco_macro_profile_filename) {
+		g_fprintf(stderr, "--jobs cannot be combined with --macro-profile!\n");
+		exit(EXIT_FAILURE);
+	}
+#endif
+
 	return mung_filename;
 }
 
@@ -339,6 +415,136 @@ teco_initialize_environment(void)
 	}
 }
 
+static void
+teco_startup_profile_clear(teco_execute_file_profile_t *entry)
+{
+	g_free(entry->filename);
+}
+
+static void
+teco_startup_profile_print(gint64 start_time, gint64 init_time)
+{
+	gint64 now = g_get_monotonic_time();
+
+	g_fprintf(stderr, "Startup profile:\n");
+	g_fprintf(stderr, "%10.3f ms  initialization\n", (init_time - start_time)/1000.);
+	for (guint i = 0; i < teco_execute_file_profile->len; i++) {
+		teco_execute_file_profile_t *entry = &g_array_index(teco_execute_file_profile,
+		                                                    teco_execute_file_profile_t, i);
+		g_fprintf(stderr, "%10.3f ms  %*s%s\n", entry->usecs/1000.,
+		          entry->depth*2, "", entry->filename);
+	}
+	g_fprintf(stderr, "%10.3f ms  total\n", (now - start_time)/1000.);
+
+	/* only the startup is profiled */
+	g_array_free(teco_execute_file_profile, TRUE);
+	teco_execute_file_profile = NULL;
+}
+
+static void
+teco_apply_options(void)
+{
+#ifdef HAVE_CAP_ENTER
+	/*
+	 * In the sandbox, we cannot access files or execute external processes.
+	 * Effectively, munging won't work, so you can pass macros only via
+	 * --eval or --fake-cmdline.
+	 */
+	if (G_UNLIKELY(teco_sandbox))
+		cap_enter();
+#endif
+
+	if (teco_startup_profile) {
+		teco_execute_file_profile = g_array_new(FALSE, FALSE, sizeof(teco_execute_file_profile_t));
+		g_array_set_clear_func(teco_execute_file_profile,
+		                       (GDestroyNotify)teco_startup_profile_clear);
+	}
+
+	if (teco_8bit_clean)
+		/* equivalent to 16,4ED but executed earlier */
+		teco_ed = (teco_ed & ~TECO_ED_AUTOEOL) | TECO_ED_DEFAULT_ANSI;
+}
+
+#ifdef TECO_SERVER
+
+/**
+ * Reset all options before parsing the command line of a server job,
+ * so the server's own options do not leak into the job.
+ */
+static void
+teco_reset_options(void)
+{
+	if (teco_8bit_clean)
+		teco_ed = (teco_ed & ~TECO_ED_DEFAULT_ANSI) | TECO_ED_AUTOEOL;
+	if (teco_execute_file_profile) {
+		g_array_free(teco_execute_file_profile, TRUE);
+		teco_execute_file_profile = NULL;
+	}
+
+	teco_quiet = teco_stdin = teco_stdout = FALSE;
+	g_clear_pointer(&teco_eval_macro, g_free);
+	teco_mung_file = FALSE;
+	teco_mung_profile = TRUE;
+	g_clear_pointer(&teco_fake_cmdline, g_free);
+	g_clear_pointer(&teco_fake_paste, g_free);
+	g_clear_pointer(&teco_stream_separator, g_free);
+	g_clear_pointer(&teco_image_filename, g_free);
+	g_clear_pointer(&teco_macro_profile_filename, g_free);
+	g_clear_pointer(&teco_help_index_path, g_free);
+	teco_8bit_clean = teco_startup_profile = teco_show_stats = FALSE;
+	g_clear_pointer(&teco_client_socket, g_free);
+	teco_jobs = 0;
+
+	teco_interface_msg_level = TECO_MSG_USER;
+}
+
+#endif
+
+/**
+ * Apply the --eval macro or --mung script to every record
+ * read from stdin, writing the records to stdout (see --stream).
+ *
+ * Processing stops after a record, if the macro executes EX.
+ */
+static gboolean
+teco_stream_records(const gchar *mung_filename, teco_qreg_table_t *qreg_table_locals,
+                    teco_int_t *ret, GError **error)
+{
+	/* the script is read only once */
+	g_auto(teco_string_t) script = {NULL, 0};
+	if (mung_filename && !g_file_get_contents(mung_filename, &script.data, &script.len, error))
+		return FALSE;
+
+	g_autoptr(teco_view_stream_t) stream = teco_view_stream_new(teco_stream_separator,
+	                                                            strlen(teco_stream_separator));
+
+	while (teco_view_stream_read(stream, teco_ring_current->view, error)) {
+		gboolean rc = mung_filename
+			? teco_execute_script(mung_filename, script.data, script.len,
+			                      qreg_table_locals, error)
+			: teco_execute_macro(teco_eval_macro, strlen(teco_eval_macro),
+			                     qreg_table_locals, error);
+		if (!rc && !g_error_matches(*error, TECO_ERROR, TECO_ERROR_QUIT)) {
+			if (!mung_filename)
+				teco_error_add_frame_toplevel();
+			return FALSE;
+		}
+		gboolean quit = !rc || (teco_ed & TECO_ED_EXIT);
+		g_clear_error(error);
+
+		if (!teco_view_stream_write(stream, teco_ring_current->view, error))
+			return FALSE;
+
+		if (quit)
+			return teco_expressions_pop_num_calc(ret, EXIT_SUCCESS, error);
+
+		/* every record starts out with an empty expression stack */
+		teco_expressions_clear();
+	}
+
+	return *error == NULL;
+}
+
 /*
  * Callbacks
  */
@@ -366,6 +572,7 @@ main(int argc, char **argv)
 {
 	g_autoptr(GError) error = NULL;
 	teco_int_t ret = EXIT_SUCCESS;
+	gint64 start_time = g_get_monotonic_time();
 
 #ifdef G_OS_WIN32
 	/*
@@ -411,6 +618,10 @@ main(int argc, char **argv)
 	g_auto(GStrv) argv_utf8 = g_win32_get_command_line();
 #else
 	g_auto(GStrv) argv_utf8 = g_strdupv(argv);
+#endif
+#ifdef TECO_SERVER
+	/* the client passes on all of its arguments to the server */
+	g_auto(GStrv) argv_client = g_strdupv(argv_utf8);
 #endif
 	g_autofree gchar *mung_filename = teco_process_options(&argv_utf8);
 	/*
@@ -418,19 +629,12 @@ main(int argc, char **argv)
 	 * to the macro or munged file.
 	 */
 
-#ifdef HAVE_CAP_ENTER
-	/*
-	 * In the sandbox, we cannot access files or execute external processes.
-	 * Effectively, munging won't work, so you can pass macros only via
-	 * --eval or --fake-cmdline.
-	 */
-	if (G_UNLIKELY(teco_sandbox))
-		cap_enter();
+#ifdef TECO_SERVER
+	if (teco_client_socket)
+		return teco_client_run(teco_client_socket, argv_client);
 #endif
 
-	if (teco_8bit_clean)
-		/* equivalent to 16,4ED but executed earlier */
-		teco_ed = (teco_ed & ~TECO_ED_AUTOEOL) | TECO_ED_DEFAULT_ANSI;
+	teco_apply_options();
 
 	/*
 	 * Theoretically, QReg tables should only be initialized
@@ -474,6 +678,33 @@ main(int argc, char **argv)
 	/* current working directory ("$") */
 	teco_qreg_table_insert_unique(&teco_qreg_table_globals,
 	                              teco_qreg_workingdir_new());
+
+#ifdef TECO_SERVER
+	if (teco_server_socket) {
+		/*
+		 * Everything up to here is initialized only once.
+		 * Every job continues in a forked process, as if started
+		 * with the client's command line.
+		 */
+		g_clear_pointer(&argv_utf8, g_strfreev);
+		if (!teco_server_run(teco_server_socket, &argv_utf8, &error)) {
+			if (error) {
+				g_fprintf(stderr, "Server error: %s\n", error->message);
+				ret = EXIT_FAILURE;
+			}
+			teco_interface_cleanup();
+			return ret;
+		}
+
+		start_time = g_get_monotonic_time();
+		teco_stats_reset();
+		teco_reset_options();
+		g_free(mung_filename);
+		mung_filename = teco_process_options(&argv_utf8);
+		teco_apply_options();
+	}
+#endif
+
 	/* environment defaults and registers */
 	teco_initialize_environment();
 
@@ -485,6 +716,27 @@ main(int argc, char **argv)
 		goto cleanup;
 	}
 
+	if (teco_help_index_path) {
+		teco_help_write_index(teco_help_index_path, &error);
+		goto cleanup;
+	}
+
+#ifdef TECO_SERVER
+	if (teco_jobs > 0) {
+		/*
+		 * Every worker continues as if started with a single argument.
+		 * The driver only collects the workers' output, which also
+		 * includes their buffers with --stdout.
+		 */
+		gint jobs_ret;
+		if (!teco_worker_pool_run(teco_jobs, &argv_utf8, &jobs_ret, &error)) {
+			ret = jobs_ret;
+			teco_stdout = FALSE;
+			goto cleanup;
+		}
+	}
+#endif
+
 	/*
 	 * Load stdin into the unnamed buffer.
 	 * This will also perform EOL normalization.
@@ -519,6 +771,15 @@ main(int argc, char **argv)
 			goto cleanup;
 	}
 
+	if (teco_macro_profile_filename)
+		teco_profiler_start();
+
+	if (teco_stream_separator) {
+		if (teco_stream_records(mung_filename, &local_qregs, &ret, &error))
+			teco_ed_hook(TECO_ED_HOOK_QUIT, &error);
+		goto cleanup;
+	}
+
 	/*
 	 * Execute macro or mung file
 	 */
@@ -560,15 +821,27 @@ main(int argc, char **argv)
 	}
 
 	if (mung_filename) {
+		gint64 init_time = g_get_monotonic_time();
+
 		/*
 		 * NOTE: Theoretically there is a small timeframe when the file could
 		 * disappear, in which case there will be an error.
 		 */
-		if (!teco_execute_file(mung_filename, &local_qregs, &error) &&
-		    !g_error_matches(error, TECO_ERROR, TECO_ERROR_QUIT))
+		gboolean use_image = teco_image_filename && !teco_mung_file;
+		if (use_image)
+			teco_image_begin(teco_image_filename, mung_filename,
+			                 g_getenv("SCITECOPATH"));
+		gboolean rc = teco_execute_file(mung_filename, &local_qregs, &error) ||
+		              g_error_matches(error, TECO_ERROR, TECO_ERROR_QUIT);
+		if (use_image)
+			teco_image_end(rc);
+		if (!rc)
 			goto cleanup;
 		g_clear_error(&error);
 
+		if (teco_execute_file_profile)
+			teco_startup_profile_print(start_time, init_time);
+
 		if (teco_ed & TECO_ED_EXIT) {
 			/* exit was requested using the EX command */
 			if (!teco_expressions_pop_num_calc(&ret, EXIT_SUCCESS, &error) ||
@@ -581,6 +854,14 @@ main(int argc, char **argv)
 	/*
 	 * If munged file didn't quit, switch into interactive mode
 	 */
+#ifdef TECO_SERVER
+	if (teco_server_socket || teco_jobs > 0) {
+		g_set_error_literal(&error, TECO_ERROR, TECO_ERROR_FAILED,
+		                    "Interactive mode is not supported in server jobs or --jobs workers");
+		goto cleanup;
+	}
+#endif
+
 	/* commandline replacement string register */
 	teco_qreg_table_replace(&teco_qreg_table_globals, teco_qreg_plain_new("\e", 1));
 
@@ -594,13 +875,17 @@ main(int argc, char **argv)
 	 */
 	teco_machine_main_init(&teco_cmdline.machine, &local_qregs, TRUE);
 
-	if (G_UNLIKELY(teco_fake_cmdline != NULL)) {
+	if (G_UNLIKELY(teco_fake_cmdline != NULL || teco_fake_paste != NULL)) {
 		/*
 		 * NOTE: Most errors are already catched at a higher level,
 		 * so you cannot rely on the exit code to detect them.
 		 */
-		if (!teco_cmdline_keypress(teco_fake_cmdline, strlen(teco_fake_cmdline), &error) &&
-		    !g_error_matches(error, TECO_ERROR, TECO_ERROR_QUIT)) {
+		gboolean rc = TRUE;
+		if (teco_fake_paste)
+			rc = teco_cmdline_paste(teco_fake_paste, strlen(teco_fake_paste), &error);
+		if (rc && teco_fake_cmdline)
+			rc = teco_cmdline_keypress(teco_fake_cmdline, strlen(teco_fake_cmdline), &error);
+		if (!rc && !g_error_matches(error, TECO_ERROR, TECO_ERROR_QUIT)) {
 			teco_error_add_frame_toplevel();
 			goto cleanup;
 		}
@@ -629,12 +914,19 @@ cleanup:
 	if (!error && teco_stdout)
 		teco_view_save_to_stdout(teco_ring_current->view, &error);
 
+	if (teco_profiler_enabled)
+		teco_profiler_stop(teco_macro_profile_filename);
+	if (teco_show_stats)
+		teco_stats_print();
+
 	if (error != NULL) {
 		teco_error_display_full(error);
 		ret = EXIT_FAILURE;
 	}
 
 #ifndef NDEBUG
+	if (teco_execute_file_profile)
+		g_array_free(teco_execute_file_profile, TRUE);
 	teco_ring_cleanup();
 	teco_qreg_table_clear(&local_qregs);
 	teco_qreg_table_clear(&teco_qreg_table_globals);
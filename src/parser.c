@@ -35,6 +35,9 @@
 #include "qreg.h"
 #include "ring.h"
 #include "glob.h"
+#include "image.h"
+#include "profiler.h"
+#include "stats.h"
 #include "error.h"
 #include "core-commands.h"
 #include "goto-commands.h"
@@ -67,6 +70,7 @@ teco_machine_input(teco_machine_t *ctx, gunichar chr, GError **error)
 		return FALSE;
 
 	if (next != ctx->current) {
+		teco_stats_inc(TECO_STATS_TRANSITIONS);
 		if (ctx->must_undo)
 			teco_undo_ptr(ctx->current);
 		ctx->current = next;
@@ -119,6 +123,8 @@ teco_machine_main_step(teco_machine_main_t *ctx, const gchar *macro, gsize stop_
 		if (!teco_memory_check(0, error))
 			goto error_attach;
 
+		teco_stats_inc(TECO_STATS_CHARS);
+
 		/* UTF-8 sequences are already validated */
 		gunichar chr = g_utf8_get_char(macro+ctx->macro_pc);
 
@@ -127,25 +133,15 @@ teco_machine_main_step(teco_machine_main_t *ctx, const gchar *macro, gsize stop_
 			 ctx->macro_pc, chr, chr, ctx->parent.current, ctx->flags.mode);
 #endif
 
+		if (G_UNLIKELY(teco_profiler_enabled))
+			teco_profiler_step(ctx->macro_pc, chr, ctx->parent.current == &teco_state_start);
+
 		ctx->macro_pc = g_utf8_next_char(macro+ctx->macro_pc) - macro;
 
 		if (!teco_machine_input(&ctx->parent, chr, error))
 			goto error_attach;
 	}
 
-	/*
-	 * Provide interactive feedback when the
-	 * PC is at the end of the command line.
-	 * This will actually be called in other situations,
-	 * like at the end of macros but that does not hurt.
-	 * It should perhaps be in teco_cmdline_insert(),
-	 * but doing it here ensures that exceptions get
-	 * normalized.
-	 */
-	if (ctx->parent.current->refresh_cb &&
-	    !ctx->parent.current->refresh_cb(&ctx->parent, error))
-		goto error_attach;
-
 	return TRUE;
 
 error_attach:
@@ -158,6 +154,34 @@ error_attach:
 	return FALSE;
 }
 
+/**
+ * Provide interactive feedback at the current PC.
+ *
+ * This is only done by the command line after processing
+ * key presses, so that re-inserted or replaced parts of the
+ * command line are not processed character by character
+ * (e.g. there is only one incremental search per key press).
+ * In macros, this is never necessary since they cannot end
+ * in the middle of a string argument.
+ *
+ * @param ctx State machine.
+ * @param macro The macro executed so far.
+ * @param error Location to store error.
+ * @return FALSE if an error occurred.
+ */
+gboolean
+teco_machine_main_refresh(teco_machine_main_t *ctx, const gchar *macro, GError **error)
+{
+	if (!ctx->parent.current->refresh_cb ||
+	    ctx->parent.current->refresh_cb(&ctx->parent, error))
+		return TRUE;
+
+	/* attribute the error to the last character */
+	const gchar *p = g_utf8_find_prev_char(macro, macro+ctx->macro_pc);
+	teco_error_set_coord(macro, p ? p - macro : 0);
+	return FALSE;
+}
+
 gboolean
 teco_execute_macro(const gchar *macro, gsize macro_len,
                    teco_qreg_table_t *qreg_table_locals, GError **error)
@@ -289,35 +313,55 @@ error_cleanup:
 	return FALSE;
 }
 
+/**
+ * Execution times of all files executed via teco_execute_file()
+ * as teco_execute_file_profile_t in the order they were started.
+ * Times are only recorded if this is non-NULL (see --startup-profile).
+ */
+GArray *teco_execute_file_profile = NULL;
+
+/**
+ * Execute the contents of a script file.
+ *
+ * This behaves like teco_execute_file(), but the file
+ * has already been read, so it can be executed repeatedly
+ * without accessing the file system.
+ *
+ * @param filename The script's file name for error messages.
+ * @param data The null-terminated contents of the script.
+ * @param len Length of data in bytes.
+ * @param qreg_table_locals Local Q-Register table or NULL.
+ * @param error A GError.
+ * @return FALSE in case of a GError.
+ */
 gboolean
-teco_execute_file(const gchar *filename, teco_qreg_table_t *qreg_table_locals, GError **error)
+teco_execute_script(const gchar *filename, const gchar *data, gsize len,
+                    teco_qreg_table_t *qreg_table_locals, GError **error)
 {
-	g_auto(teco_string_t) macro = {NULL, 0};
-	if (!g_file_get_contents(filename, &macro.data, &macro.len, error))
-		return FALSE;
-
-	gchar *p;
+	const gchar *p;
 
 	/* only when executing files, ignore Hash-Bang line */
-	if (*macro.data == '#') {
+	if (len > 0 && *data == '#') {
 		/*
 		 * NOTE: We assume that a file starting with Hash does not contain
 		 * a null-byte in its first line.
 		 */
-		p = strpbrk(macro.data, "\r\n");
+		p = strpbrk(data, "\r\n");
 		if (G_UNLIKELY(!p))
 			/* empty script */
 			return TRUE;
 		p++;
 	} else {
-		p = macro.data;
+		p = data;
 	}
 
-	if (!teco_execute_macro(p, macro.len - (p - macro.data),
-	                        qreg_table_locals, error)) {
+	teco_profiler_push_file(filename);
+	gboolean rc = teco_execute_macro(p, len - (p - data), qreg_table_locals, error);
+	teco_profiler_pop();
+	if (!rc) {
 		/* correct error position for Hash-Bang line */
-		teco_error_pos += p - macro.data;
-		if (*macro.data == '#')
+		teco_error_pos += p - data;
+		if (len > 0 && *data == '#')
 			teco_error_line++;
 		teco_error_add_frame_file(filename);
 		return FALSE;
@@ -326,6 +370,56 @@ teco_execute_file(const gchar *filename, teco_qreg_table_t *qreg_table_locals, G
 	return TRUE;
 }
 
+static gboolean
+teco_execute_file_contents(const gchar *filename, teco_qreg_table_t *qreg_table_locals, GError **error)
+{
+	g_auto(teco_string_t) macro = {NULL, 0};
+	if (!g_file_get_contents(filename, &macro.data, &macro.len, error))
+		return FALSE;
+
+	return teco_execute_script(filename, macro.data, macro.len, qreg_table_locals, error);
+}
+
+gboolean
+teco_execute_file(const gchar *filename, teco_qreg_table_t *qreg_table_locals, GError **error)
+{
+	static guint depth = 0;
+
+	if (G_LIKELY(!teco_execute_file_profile && !teco_image_active))
+		return teco_execute_file_contents(filename, qreg_table_locals, error);
+
+	if (teco_image_active) {
+		gboolean restored;
+		if (!teco_image_enter(filename, depth, &restored, error))
+			return FALSE;
+		if (restored)
+			return TRUE;
+	}
+
+	/*
+	 * The entry is added before executing the file,
+	 * so nested files are listed after their parents.
+	 */
+	guint i = 0;
+	if (teco_execute_file_profile) {
+		teco_execute_file_profile_t entry = {depth, g_strdup(filename), 0};
+		i = teco_execute_file_profile->len;
+		g_array_append_val(teco_execute_file_profile, entry);
+	}
+
+	gint64 start = g_get_monotonic_time();
+	depth++;
+	gboolean rc = teco_execute_file_contents(filename, qreg_table_locals, error);
+	depth--;
+	if (teco_execute_file_profile)
+		g_array_index(teco_execute_file_profile, teco_execute_file_profile_t, i).usecs =
+			g_get_monotonic_time() - start;
+	if (teco_image_active)
+		teco_image_leave(depth, rc);
+
+	return rc;
+}
+
 TECO_DEFINE_UNDO_SCALAR(teco_machine_main_flags_t);
 
 void
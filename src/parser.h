@@ -88,6 +88,15 @@ typedef const struct {
 	gboolean (*process_cb)(teco_machine_main_t *ctx, const teco_string_t *str,
 	                       gsize new_chars, GError **error);
 
+	/**
+	 * Called to revert the processing of the last `chars` bytes of the
+	 * string argument in place, when rubbing out pasted text.
+	 *
+	 * Can be NULL if process_cb() always processes the entire string
+	 * (e.g. searches), so the feedback is simply refreshed.
+	 */
+	void (*truncate_cb)(teco_machine_main_t *ctx, gsize chars);
+
 	/**
 	 * Called at the end of the string argument to determine the next state.
 	 * Commands that don't give interactive feedback can use this callback
@@ -546,11 +555,25 @@ gboolean teco_machine_main_eval_at(teco_machine_main_t *ctx);
 
 gboolean teco_machine_main_step(teco_machine_main_t *ctx,
                                 const gchar *macro, gsize stop_pos, GError **error);
+gboolean teco_machine_main_refresh(teco_machine_main_t *ctx,
+                                   const gchar *macro, GError **error);
 
 gboolean teco_execute_macro(const gchar *macro, gsize macro_len,
                             teco_qreg_table_t *qreg_table_locals, GError **error);
+gboolean teco_execute_script(const gchar *filename, const gchar *data, gsize len,
+                             teco_qreg_table_t *qreg_table_locals, GError **error);
 gboolean teco_execute_file(const gchar *filename, teco_qreg_table_t *qreg_table_locals, GError **error);
 
+typedef struct {
+	/** nesting level of the file (0 for the munged file) */
+	guint depth;
+	gchar *filename;
+	/** wall time spent executing the file including nested files */
+	gint64 usecs;
+} teco_execute_file_profile_t;
+
+extern GArray *teco_execute_file_profile;
+
 typedef const struct {
 	/** next state after receiving the input character */
 	teco_state_t *next;
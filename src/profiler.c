@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2012-2025 Robin Haberkorn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gprintf.h>
+
+#include "sciteco.h"
+#include "string-utils.h"
+#include "interface.h"
+#include "profiler.h"
+
+/*
+ * Sampling profiler for macros (see --macro-profile).
+ *
+ * A background thread ticks at a fixed interval.
+ * The ticks are consumed by the main thread in teco_machine_main_step(),
+ * attributing them to the macro call stack and the command being executed.
+ * Since ticks are only consumed between commands, the time spent in
+ * long-running commands (e.g. searches) is attributed to the command
+ * that has been started last.
+ */
+
+/** Sampling interval in microseconds */
+#define TECO_PROFILER_INTERVAL 1000
+
+gboolean teco_profiler_enabled = FALSE;
+
+typedef struct {
+	gchar *name;
+	/** whether pc and command are valid */
+	gboolean started;
+	/** start of the current command in bytes */
+	gsize pc;
+	/** the current command, i.e. up to two characters */
+	gunichar command[2];
+} teco_profiler_frame_t;
+
+static struct {
+	GThread *thread;
+	gint running;
+	gint ticks;
+
+	/** stack of teco_profiler_frame_t, starting with the toplevel frame */
+	GArray *frames;
+	/** folded stack to number of samples */
+	GHashTable *stacks;
+	/** command to number of samples */
+	GHashTable *commands;
+	gsize total;
+} teco_profiler;
+
+static gpointer
+teco_profiler_thread_cb(gpointer data)
+{
+	while (g_atomic_int_get(&teco_profiler.running)) {
+		g_usleep(TECO_PROFILER_INTERVAL);
+		g_atomic_int_inc(&teco_profiler.ticks);
+	}
+
+	return NULL;
+}
+
+static void
+teco_profiler_frame_clear(teco_profiler_frame_t *frame)
+{
+	g_free(frame->name);
+}
+
+static void
+teco_profiler_append_command(GString *str, const teco_profiler_frame_t *frame)
+{
+	gchar buf[2*6];
+	gsize len = 0;
+
+	for (guint i = 0; i < G_N_ELEMENTS(frame->command) && frame->command[i]; i++)
+		len += g_unichar_to_utf8(g_unichar_toupper(frame->command[i]), buf+len);
+
+	g_autofree gchar *command_printable = teco_string_echo(buf, len);
+	g_string_append(str, command_printable);
+}
+
+static void
+teco_profiler_count(GHashTable *table, const gchar *key, gsize samples)
+{
+	gpointer value;
+
+	if (g_hash_table_lookup_extended(table, key, NULL, &value))
+		g_hash_table_insert(table, g_strdup(key),
+		                    GSIZE_TO_POINTER(GPOINTER_TO_SIZE(value) + samples));
+	else
+		g_hash_table_insert(table, g_strdup(key), GSIZE_TO_POINTER(samples));
+}
+
+/**
+ * Attribute all pending ticks to the current stack.
+ */
+static void
+teco_profiler_flush(void)
+{
+	gint ticks = g_atomic_int_get(&teco_profiler.ticks);
+	if (G_LIKELY(!ticks))
+		return;
+	g_atomic_int_add(&teco_profiler.ticks, -ticks);
+	teco_profiler.total += ticks;
+
+	g_autoptr(GString) stack = g_string_new(NULL);
+	const teco_profiler_frame_t *top = NULL;
+
+	for (guint i = 0; i < teco_profiler.frames->len; i++) {
+		const teco_profiler_frame_t *frame;
+		frame = &g_array_index(teco_profiler.frames, teco_profiler_frame_t, i);
+
+		/* the toplevel frame is only shown when executing toplevel macros */
+		if (i == 0 && !frame->started)
+			continue;
+
+		if (stack->len > 0)
+			g_string_append_c(stack, ';');
+		g_string_append(stack, frame->name);
+		if (frame->started)
+			g_string_append_printf(stack, " at %" G_GSIZE_FORMAT, frame->pc);
+		top = frame;
+	}
+
+	if (top && top->started) {
+		gsize len = stack->len;
+		g_string_append_c(stack, ';');
+		teco_profiler_append_command(stack, top);
+		teco_profiler_count(teco_profiler.commands, stack->str+len+1, ticks);
+	}
+
+	if (stack->len > 0)
+		teco_profiler_count(teco_profiler.stacks, stack->str, ticks);
+}
+
+/**
+ * Start profiling macros.
+ *
+ * Frames are pushed and popped by the callers of
+ * teco_execute_macro() (see teco_profiler_push_qreg()).
+ */
+void
+teco_profiler_start(void)
+{
+	teco_profiler.frames = g_array_new(FALSE, TRUE, sizeof(teco_profiler_frame_t));
+	g_array_set_clear_func(teco_profiler.frames, (GDestroyNotify)teco_profiler_frame_clear);
+	teco_profiler_push_frame("toplevel macro");
+
+	teco_profiler.stacks = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	teco_profiler.commands = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+	g_atomic_int_set(&teco_profiler.running, TRUE);
+	teco_profiler.thread = g_thread_new("profiler", teco_profiler_thread_cb, NULL);
+
+	teco_profiler_enabled = TRUE;
+}
+
+static gint
+teco_profiler_cmp_samples(gconstpointer a, gconstpointer b)
+{
+	gsize samples_a = GPOINTER_TO_SIZE(g_hash_table_lookup(teco_profiler.commands,
+	                                                       *(const gchar **)a));
+	gsize samples_b = GPOINTER_TO_SIZE(g_hash_table_lookup(teco_profiler.commands,
+	                                                       *(const gchar **)b));
+
+	return samples_a < samples_b ? 1 : samples_a > samples_b ? -1
+	                             : strcmp(*(const gchar **)a, *(const gchar **)b);
+}
+
+static gint
+teco_profiler_cmp_strings(gconstpointer a, gconstpointer b)
+{
+	return strcmp(*(const gchar **)a, *(const gchar **)b);
+}
+
+/**
+ * Stop profiling and write the results.
+ *
+ * The samples per stack are written in the "folded" format
+ * understood by flame graph tools.
+ * The samples per command are printed to stderr.
+ *
+ * @param filename File to write the folded stacks to.
+ */
+void
+teco_profiler_stop(const gchar *filename)
+{
+	teco_profiler_enabled = FALSE;
+	g_atomic_int_set(&teco_profiler.running, FALSE);
+	g_thread_join(teco_profiler.thread);
+
+	guint len;
+	g_autofree gchar **stacks = (gchar **)g_hash_table_get_keys_as_array(teco_profiler.stacks, &len);
+	qsort(stacks, len, sizeof(*stacks), teco_profiler_cmp_strings);
+
+	g_autoptr(GString) folded = g_string_new(NULL);
+	for (guint i = 0; i < len; i++)
+		g_string_append_printf(folded, "%s %" G_GSIZE_FORMAT "\n", stacks[i],
+		                       GPOINTER_TO_SIZE(g_hash_table_lookup(teco_profiler.stacks, stacks[i])));
+
+	g_autoptr(GError) error = NULL;
+	if (!g_file_set_contents(filename, folded->str, folded->len, &error))
+		teco_interface_msg(TECO_MSG_WARNING, "Cannot write profile \"%s\": %s",
+		                   filename, error->message);
+
+	g_autofree gchar **commands = (gchar **)g_hash_table_get_keys_as_array(teco_profiler.commands, &len);
+	qsort(commands, len, sizeof(*commands), teco_profiler_cmp_samples);
+
+	g_fprintf(stderr, "Command profile (%" G_GSIZE_FORMAT " samples):\n", teco_profiler.total);
+	for (guint i = 0; i < len; i++) {
+		gsize samples = GPOINTER_TO_SIZE(g_hash_table_lookup(teco_profiler.commands, commands[i]));
+		g_fprintf(stderr, "%6.1f %%  %8" G_GSIZE_FORMAT "  %s\n",
+		          100.*samples/teco_profiler.total, samples, commands[i]);
+	}
+
+	g_array_free(teco_profiler.frames, TRUE);
+	g_hash_table_destroy(teco_profiler.stacks);
+	g_hash_table_destroy(teco_profiler.commands);
+	memset(&teco_profiler, 0, sizeof(teco_profiler));
+}
+
+/**
+ * Push a frame onto the profiler's macro call stack.
+ *
+ * Should be called via wrappers like teco_profiler_push_qreg().
+ */
+void
+teco_profiler_push_frame(const gchar *fmt, ...)
+{
+	/* pending ticks belong to the calling command */
+	teco_profiler_flush();
+
+	va_list ap;
+	va_start(ap, fmt);
+	teco_profiler_frame_t frame = {g_strdup_vprintf(fmt, ap)};
+	va_end(ap);
+
+	/* semicolons separate frames in the folded format */
+	g_strdelimit(frame.name, ";", ',');
+	g_array_append_val(teco_profiler.frames, frame);
+}
+
+void
+teco_profiler_pop_frame(void)
+{
+	teco_profiler_flush();
+	g_array_set_size(teco_profiler.frames, teco_profiler.frames->len-1);
+}
+
+/**
+ * Called before executing every character of a macro
+ * (see teco_machine_main_step()).
+ *
+ * @param pc Position of the character in bytes.
+ * @param chr The character to execute.
+ * @param command Whether the character starts a new command.
+ */
+void
+teco_profiler_step(gsize pc, gunichar chr, gboolean command)
+{
+	teco_profiler_flush();
+
+	teco_profiler_frame_t *frame = &g_array_index(teco_profiler.frames, teco_profiler_frame_t,
+	                                              teco_profiler.frames->len-1);
+
+	if (command) {
+		frame->started = TRUE;
+		frame->pc = pc;
+		frame->command[0] = chr;
+		frame->command[1] = 0;
+	} else if (frame->started && !frame->command[1] &&
+	           (g_unichar_toupper(frame->command[0]) == 'E' ||
+	            g_unichar_toupper(frame->command[0]) == 'F' ||
+	            frame->command[0] == '^')) {
+		/* two-character commands */
+		frame->command[1] = chr;
+	}
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2012-2025 Robin Haberkorn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <glib.h>
+
+#include "sciteco.h"
+#include "string-utils.h"
+
+/** Whether macro execution is being profiled (see --macro-profile) */
+extern gboolean teco_profiler_enabled;
+
+void teco_profiler_start(void);
+void teco_profiler_stop(const gchar *filename);
+
+void teco_profiler_push_frame(const gchar *fmt, ...) G_GNUC_PRINTF(1, 2);
+void teco_profiler_pop_frame(void);
+void teco_profiler_step(gsize pc, gunichar chr, gboolean command);
+
+static inline void
+teco_profiler_push_qreg(const gchar *name, gsize len)
+{
+	if (G_UNLIKELY(teco_profiler_enabled)) {
+		g_autofree gchar *name_printable = teco_string_echo(name, len);
+		teco_profiler_push_frame("Q-Register \"%s\"", name_printable);
+	}
+}
+
+static inline void
+teco_profiler_push_file(const gchar *filename)
+{
+	if (G_UNLIKELY(teco_profiler_enabled))
+		teco_profiler_push_frame("file \"%s\"", filename);
+}
+
+static inline void
+teco_profiler_push_edhook(const gchar *type)
+{
+	if (G_UNLIKELY(teco_profiler_enabled))
+		teco_profiler_push_frame("\"%s\" hook", type);
+}
+
+static inline void
+teco_profiler_pop(void)
+{
+	if (G_UNLIKELY(teco_profiler_enabled))
+		teco_profiler_pop_frame();
+}
@@ -39,6 +39,7 @@
 #include "ring.h"
 #include "eol.h"
 #include "error.h"
+#include "profiler.h"
 #include "rb3str.h"
 #include "qreg.h"
 
@@ -90,8 +91,11 @@ teco_qreg_execute(teco_qreg_t *qreg, teco_qreg_table_t *qreg_table_locals, GErro
 	 * so as not to complicate TECO_ED_DEFAULT_ANSI mode.
 	 * The UTF-8 byte sequences are checked anyway.
 	 */
-	if (!qreg->vtable->get_string(qreg, &macro.data, &macro.len, NULL, error) ||
-	    !teco_execute_macro(macro.data, macro.len, qreg_table_locals, error)) {
+	teco_profiler_push_qreg(qreg->head.name.data, qreg->head.name.len);
+	gboolean rc = qreg->vtable->get_string(qreg, &macro.data, &macro.len, NULL, error) &&
+	              teco_execute_macro(macro.data, macro.len, qreg_table_locals, error);
+	teco_profiler_pop();
+	if (!rc) {
 		teco_error_add_frame_qreg(qreg->head.name.data, qreg->head.name.len);
 		return FALSE;
 	}
@@ -383,13 +387,25 @@ teco_qreg_plain_save(teco_qreg_t *qreg, const gchar *filename, GError **error)
 	##__VA_ARGS__ \
 }
 
+static teco_qreg_vtable_t teco_qreg_plain_vtable = TECO_INIT_QREG();
+
 /** @static @memberof teco_qreg_t */
 teco_qreg_t *
 teco_qreg_plain_new(const gchar *name, gsize len)
 {
-	static teco_qreg_vtable_t vtable = TECO_INIT_QREG();
+	return teco_qreg_new(&teco_qreg_plain_vtable, name, len);
+}
 
-	return teco_qreg_new(&vtable, name, len);
+/**
+ * Check whether a register is a plain register,
+ * i.e. not backed by any other state.
+ *
+ * @memberof teco_qreg_t
+ */
+gboolean
+teco_qreg_is_plain(teco_qreg_t *qreg)
+{
+	return qreg->vtable == &teco_qreg_plain_vtable;
 }
 
 /* see also teco_state_start_jump() */
@@ -834,7 +850,7 @@ teco_qreg_clipboard_set_string(teco_qreg_t *qreg, const gchar *str, gsize len,
 		 */
 		g_auto(teco_eol_writer_t) writer;
 		teco_eol_writer_init_mem(&writer, teco_view_ssm(teco_qreg_view, SCI_GETEOLMODE, 0, 0),
-		                         str_converted);
+		                         TRUE, str_converted);
 
 		gssize bytes_written = teco_eol_writer_convert(&writer, str, len, error);
 		if (bytes_written < 0)
@@ -899,7 +915,7 @@ teco_qreg_clipboard_get_string(teco_qreg_t *qreg, gchar **str, gsize *len,
 		return FALSE;
 
 	g_auto(teco_eol_reader_t) reader;
-	teco_eol_reader_init_mem(&reader, temp.data, temp.len);
+	teco_eol_reader_init_mem(&reader, TRUE, temp.data, temp.len);
 
 	/*
 	 * FIXME: Could be simplified if teco_eol_reader_convert_all() had the
@@ -1289,6 +1305,13 @@ teco_ed_hook(teco_ed_hook_t type, GError **error)
 	if (!(teco_ed & TECO_ED_HOOKS))
 		return TRUE;
 
+	static const gchar *const type2name[] = {
+		[TECO_ED_HOOK_ADD]	= "ADD",
+		[TECO_ED_HOOK_EDIT]	= "EDIT",
+		[TECO_ED_HOOK_CLOSE]	= "CLOSE",
+		[TECO_ED_HOOK_QUIT]	= "QUIT"
+	};
+
 	/*
 	 * NOTE: It is crucial to declare this before the first goto,
 	 * since it runs all destructors.
@@ -1321,7 +1344,10 @@ teco_ed_hook(teco_ed_hook_t type, GError **error)
 	teco_expressions_brace_open();
 	teco_expressions_push_int(type);
 
-	if (!teco_qreg_execute(qreg, &locals, error))
+	teco_profiler_push_edhook(type2name[type]);
+	gboolean rc = teco_qreg_execute(qreg, &locals, error);
+	teco_profiler_pop();
+	if (!rc)
 		goto error_add_frame;
 	if (teco_qreg_table_current == &locals) {
 		/* currently editing local Q-Register that's about to be freed */
@@ -1333,13 +1359,6 @@ teco_ed_hook(teco_ed_hook_t type, GError **error)
 	return teco_expressions_discard_args(error) &&
 	       teco_expressions_brace_close(error);
 
-	static const gchar *const type2name[] = {
-		[TECO_ED_HOOK_ADD]	= "ADD",
-		[TECO_ED_HOOK_EDIT]	= "EDIT",
-		[TECO_ED_HOOK_CLOSE]	= "CLOSE",
-		[TECO_ED_HOOK_QUIT]	= "QUIT"
-	};
-
 error_add_frame:
 	g_assert(0 <= type && type < G_N_ELEMENTS(type2name));
 	teco_error_add_frame_edhook(type2name[type]);
@@ -121,6 +121,8 @@ teco_qreg_t *teco_qreg_bufferinfo_new(void);
 teco_qreg_t *teco_qreg_workingdir_new(void);
 teco_qreg_t *teco_qreg_clipboard_new(const gchar *name);
 
+gboolean teco_qreg_is_plain(teco_qreg_t *qreg);
+
 gboolean teco_qreg_execute(teco_qreg_t *qreg, teco_qreg_table_t *qreg_table_locals, GError **error);
 
 void teco_qreg_undo_set_eol_mode(teco_qreg_t *qreg);
@@ -34,10 +34,76 @@
 #include "expressions.h"
 #include "qreg.h"
 #include "glob.h"
+#include "image.h"
 #include "error.h"
 #include "list.h"
 #include "ring.h"
 
+/*
+ * Indices over the buffer ring, so that buffers can be looked up
+ * by id or file name without walking the ring.
+ * They are kept in sync with the ring's tail queue
+ * by teco_ring_insert() and teco_ring_remove_buffer().
+ */
+static struct {
+	/** All buffers in ring order, ie. the buffer with id `n` is at index `n-1` */
+	GPtrArray *buffers;
+	/**
+	 * Maps canonical file names to the first buffer in the ring with that name.
+	 * The keys are owned by the buffers.
+	 */
+	GHashTable *names;
+	/** Number of named buffers in the ring, may be larger than the size of `names` */
+	guint named_count;
+	/** Set of all dirty buffers in the ring */
+	GHashTable *dirty;
+} teco_ring_index;
+
+static void __attribute__((constructor))
+teco_ring_index_init(void)
+{
+	teco_ring_index.buffers = g_ptr_array_new();
+	teco_ring_index.names = g_hash_table_new(g_str_hash, g_str_equal);
+	teco_ring_index.dirty = g_hash_table_new(NULL, NULL);
+}
+
+static void
+teco_ring_index_name(teco_buffer_t *buffer)
+{
+	if (!buffer->filename)
+		return;
+	teco_ring_index.named_count++;
+
+	/* teco_ring_find_by_name() always returns the first matching buffer */
+	teco_buffer_t *other = g_hash_table_lookup(teco_ring_index.names, buffer->filename);
+	if (!other || teco_ring_get_id(buffer) < teco_ring_get_id(other))
+		g_hash_table_replace(teco_ring_index.names, buffer->filename, buffer);
+}
+
+static void
+teco_ring_unindex_name(teco_buffer_t *buffer)
+{
+	if (!buffer->filename)
+		return;
+	teco_ring_index.named_count--;
+
+	if (g_hash_table_lookup(teco_ring_index.names, buffer->filename) != buffer)
+		return;
+	g_hash_table_remove(teco_ring_index.names, buffer->filename);
+
+	if (g_hash_table_size(teco_ring_index.names) == teco_ring_index.named_count)
+		/* there are no buffers with duplicate names */
+		return;
+
+	for (guint i = 0; i < teco_ring_index.buffers->len; i++) {
+		teco_buffer_t *cur = g_ptr_array_index(teco_ring_index.buffers, i);
+		if (cur != buffer && !g_strcmp0(cur->filename, buffer->filename)) {
+			g_hash_table_replace(teco_ring_index.names, cur->filename, cur);
+			break;
+		}
+	}
+}
+
 /** @private @static @memberof teco_buffer_t */
 static teco_buffer_t *
 teco_buffer_new(void)
@@ -53,18 +119,107 @@ static void
 teco_buffer_set_filename(teco_buffer_t *ctx, const gchar *filename)
 {
 	gchar *resolved = teco_file_get_absolute_path(filename);
+	teco_ring_unindex_name(ctx);
 	g_free(ctx->filename);
 	ctx->filename = resolved;
+	teco_ring_index_name(ctx);
 	if (ctx == teco_ring_current && !teco_qreg_current)
 		teco_interface_info_update(ctx);
 }
 
+typedef struct {
+	teco_buffer_t *buffer;
+	gchar *filename;
+} teco_undo_buffer_filename_t;
+
+static void
+teco_undo_buffer_filename_action(teco_undo_buffer_filename_t *ctx, gboolean run)
+{
+	if (run) {
+		teco_ring_unindex_name(ctx->buffer);
+		g_free(ctx->buffer->filename);
+		ctx->buffer->filename = ctx->filename;
+		teco_ring_index_name(ctx->buffer);
+	} else {
+		g_free(ctx->filename);
+	}
+}
+
+/**
+ * Restore the buffer's file name on rubout.
+ * This is like teco_undo_cstring(), but keeps the ring index up to date.
+ *
+ * @private @memberof teco_buffer_t
+ */
+static void
+teco_buffer_undo_filename(teco_buffer_t *ctx)
+{
+	teco_undo_buffer_filename_t *token;
+	token = teco_undo_push_size((teco_undo_action_t)teco_undo_buffer_filename_action,
+	                            sizeof(*token));
+	if (token) {
+		token->buffer = ctx;
+		token->filename = g_strdup(ctx->filename);
+	}
+}
+
+/** @private @memberof teco_buffer_t */
+static void
+teco_buffer_set_dirty(teco_buffer_t *ctx, gboolean dirty)
+{
+	ctx->dirty = dirty;
+	if (dirty)
+		g_hash_table_add(teco_ring_index.dirty, ctx);
+	else
+		g_hash_table_remove(teco_ring_index.dirty, ctx);
+}
+
+TECO_DEFINE_UNDO_CALL(teco_buffer_set_dirty, teco_buffer_t *, gboolean);
+
+/**
+ * Load the file of a lazily added buffer.
+ *
+ * Buffers added by teco_ring_add_lazy() do not have a view
+ * until their contents are required for the first time.
+ * Materialization is not undone, as it does not change
+ * the observable state of the buffer.
+ * In particular, it does not run any ED hook, since it is
+ * also required when accessing buffers without editing them
+ * (e.g. by searches over buffer boundaries).
+ *
+ * @memberof teco_buffer_t
+ */
+gboolean
+teco_buffer_materialize(teco_buffer_t *ctx, GError **error)
+{
+	if (G_LIKELY(!ctx->lazy))
+		return TRUE;
+
+	teco_view_t *view = teco_view_new();
+	teco_view_setup(view);
+
+	/* the file might have been removed in the meantime */
+	if (g_file_test(ctx->filename, G_FILE_TEST_IS_REGULAR) &&
+	    !teco_view_load(view, ctx->filename, TRUE, error)) {
+		teco_view_free(view);
+		return FALSE;
+	}
+
+	ctx->view = view;
+	ctx->lazy = FALSE;
+	return TRUE;
+}
+
 /** @memberof teco_buffer_t */
-void
-teco_buffer_edit(teco_buffer_t *ctx)
+gboolean
+teco_buffer_edit(teco_buffer_t *ctx, GError **error)
 {
+	if (!teco_buffer_materialize(ctx, error))
+		return FALSE;
+
 	teco_interface_show_view(ctx->view);
 	teco_interface_info_update(ctx);
+	return TRUE;
 }
 /** @memberof teco_buffer_t */
 void
@@ -74,11 +229,46 @@ teco_buffer_undo_edit(teco_buffer_t *ctx)
 	undo__teco_interface_show_view(ctx->view);
 }
 
-/** @private @memberof teco_buffer_t */
+/**
+ * Mark buffer as dirty.
+ * The buffer does not have to be the current one.
+ *
+ * @memberof teco_buffer_t
+ */
+void
+teco_buffer_dirtify(teco_buffer_t *ctx)
+{
+	if (ctx->dirty)
+		return;
+
+	gboolean is_current = ctx == teco_ring_current && !teco_qreg_current;
+	if (is_current)
+		undo__teco_interface_info_update_buffer(ctx);
+	undo__teco_buffer_set_dirty(ctx, FALSE);
+	teco_buffer_set_dirty(ctx, TRUE);
+	if (is_current)
+		teco_interface_info_update(ctx);
+}
+
+/**
+ * Load file into buffer.
+ *
+ * @param ctx The buffer to load.
+ * @param filename The file to load.
+ * @param loader Loader object that already prepared the file in the background
+ *   (the file name must have been returned by teco_view_loader_next())
+ *   or NULL to read the file synchronously.
+ * @param error A GError.
+ * @return FALSE in case of a GError.
+ *
+ * @private @memberof teco_buffer_t
+ */
 static gboolean
-teco_buffer_load(teco_buffer_t *ctx, const gchar *filename, GError **error)
+teco_buffer_load(teco_buffer_t *ctx, const gchar *filename,
+                 teco_view_loader_t *loader, GError **error)
 {
-	if (!teco_view_load(ctx->view, filename, TRUE, error))
+	if (loader ? !teco_view_loader_load(loader, ctx->view, error)
+	           : !teco_view_load(ctx->view, filename, TRUE, error))
 		return FALSE;
 
 #if 0		/* NOTE: currently buffer cannot be dirty */
@@ -90,27 +280,26 @@ teco_buffer_load(teco_buffer_t *ctx, const gchar *filename, GError **error)
 	return TRUE;
 }
 
-/** @private @memberof teco_buffer_t */
-static gboolean
-teco_buffer_save(teco_buffer_t *ctx, const gchar *filename, GError **error)
+/**
+ * Update buffer state after it has been written.
+ *
+ * @param ctx The buffer that has been saved.
+ * @param filename The file name it has been saved under
+ *   or NULL if it has been saved under its own file name.
+ *
+ * @private @memberof teco_buffer_t
+ */
+static void
+teco_buffer_set_saved(teco_buffer_t *ctx, const gchar *filename)
 {
-	if (!filename && !ctx->filename) {
-		g_set_error_literal(error, TECO_ERROR, TECO_ERROR_FAILED,
-		                    "Cannot save the unnamed file "
-		                    "without providing a file name");
-		return FALSE;
-	}
-
-	if (!teco_view_save(ctx->view, filename ? : ctx->filename, error))
-		return FALSE;
-
 	/*
 	 * Undirtify
 	 * NOTE: info update is performed by set_filename()
 	 */
 	if (ctx == teco_ring_current && !teco_qreg_current)
 		undo__teco_interface_info_update_buffer(ctx);
-	teco_undo_gboolean(ctx->dirty) = FALSE;
+	undo__teco_buffer_set_dirty(ctx, ctx->dirty);
+	teco_buffer_set_dirty(ctx, FALSE);
 
 	/*
 	 * FIXME: necessary also if the filename was not specified but the file
@@ -119,9 +308,26 @@ teco_buffer_save(teco_buffer_t *ctx, const gchar *filename, GError **error)
 	 * name to exist (like readlink -f)
 	 * NOTE: undo_info_update is already called above
 	 */
-	teco_undo_cstring(ctx->filename);
+	teco_buffer_undo_filename(ctx);
 	teco_buffer_set_filename(ctx, filename ? : ctx->filename);
+}
+
+/** @private @memberof teco_buffer_t */
+static gboolean
+teco_buffer_save(teco_buffer_t *ctx, const gchar *filename, GError **error)
+{
+	if (!filename && !ctx->filename) {
+		g_set_error_literal(error, TECO_ERROR, TECO_ERROR_FAILED,
+		                    "Cannot save the unnamed file "
+		                    "without providing a file name");
+		return FALSE;
+	}
 
+	if (!teco_buffer_materialize(ctx, error) ||
+	    !teco_view_save(ctx->view, filename ? : ctx->filename, error))
+		return FALSE;
+
+	teco_buffer_set_saved(ctx, filename);
 	return TRUE;
 }
 
@@ -129,7 +335,8 @@ teco_buffer_save(teco_buffer_t *ctx, const gchar *filename, GError **error)
 static inline void
 teco_buffer_free(teco_buffer_t *ctx)
 {
-	teco_view_free(ctx->view);
+	if (ctx->view)
+		teco_view_free(ctx->view);
 	g_free(ctx->filename);
 	g_free(ctx);
 }
@@ -152,6 +359,34 @@ teco_ring_last(void)
 	return (teco_buffer_t *)teco_ring_head.last->prev->next;
 }
 
+/**
+ * Insert buffer into the ring and update all indices.
+ *
+ * @param buffer The buffer to insert.
+ * @param next The buffer to insert before or NULL to insert at the tail.
+ */
+static void
+teco_ring_insert(teco_buffer_t *buffer, teco_buffer_t *next)
+{
+	GPtrArray *buffers = teco_ring_index.buffers;
+
+	if (next) {
+		guint i = teco_ring_get_id(next)-1;
+		teco_tailq_insert_before(&next->entry, &buffer->entry);
+		/* the cached ids of all following buffers are invalidated */
+		g_ptr_array_insert(buffers, i, buffer);
+		buffer->id = i+1;
+	} else {
+		teco_tailq_insert_tail(&teco_ring_head, &buffer->entry);
+		g_ptr_array_add(buffers, buffer);
+		buffer->id = buffers->len;
+	}
+
+	teco_ring_index_name(buffer);
+	if (buffer->dirty)
+		g_hash_table_add(teco_ring_index.dirty, buffer);
+}
+
 static void
 teco_undo_ring_reinsert_action(teco_buffer_t **buffer, gboolean run)
 {
@@ -160,10 +395,7 @@ teco_undo_ring_reinsert_action(teco_buffer_t **buffer, gboolean run)
 		 * assumes that buffer still has correct prev/next
 		 * pointers
 		 */
-		if (teco_buffer_next(*buffer))
-			teco_tailq_insert_before((*buffer)->entry.next, &(*buffer)->entry);
-		else
-			teco_tailq_insert_tail(&teco_ring_head, &(*buffer)->entry);
+		teco_ring_insert(*buffer, teco_buffer_next(*buffer));
 	} else {
 		teco_buffer_free(*buffer);
 	}
@@ -184,107 +416,222 @@ teco_undo_ring_reinsert(teco_buffer_t *buffer)
 		teco_buffer_free(buffer);
 }
 
+/**
+ * Get the id of a buffer in the ring.
+ *
+ * The id is cached in the buffer and validated against the index.
+ * After insertions or removals in the middle of the ring,
+ * all ids are recalculated once.
+ */
 teco_int_t
 teco_ring_get_id(teco_buffer_t *buffer)
 {
-	teco_int_t ret = 1;
-
-	for (teco_tailq_entry_t *cur = teco_ring_head.first;
-	     cur != &buffer->entry;
-	     cur = cur->next)
-		ret++;
+	GPtrArray *buffers = teco_ring_index.buffers;
+
+	if (G_UNLIKELY(!buffer->id || buffer->id > buffers->len ||
+	               g_ptr_array_index(buffers, buffer->id-1) != buffer)) {
+		for (guint i = 0; i < buffers->len; i++)
+			((teco_buffer_t *)g_ptr_array_index(buffers, i))->id = i+1;
+		g_assert(buffer->id > 0 && buffer->id <= buffers->len &&
+		         g_ptr_array_index(buffers, buffer->id-1) == buffer);
+	}
 
-	return ret;
+	return buffer->id;
 }
 
 teco_buffer_t *
 teco_ring_find_by_name(const gchar *filename)
 {
-	g_autofree gchar *resolved = teco_file_get_absolute_path(filename);
+	if (!filename) {
+		if (teco_ring_index.named_count == teco_ring_index.buffers->len)
+			return NULL;
 
-	for (teco_tailq_entry_t *cur = teco_ring_head.first; cur != NULL; cur = cur->next) {
-		teco_buffer_t *buffer = (teco_buffer_t *)cur;
-		if (!g_strcmp0(buffer->filename, resolved))
-			return buffer;
+		for (guint i = 0; i < teco_ring_index.buffers->len; i++) {
+			teco_buffer_t *buffer = g_ptr_array_index(teco_ring_index.buffers, i);
+			if (!buffer->filename)
+				return buffer;
+		}
+
+		g_assert_not_reached();
 	}
 
-	return NULL;
+	/*
+	 * The keys are canonical, so absolute file names can be looked up
+	 * directly, avoiding teco_file_get_absolute_path() in the common case.
+	 */
+	teco_buffer_t *buffer;
+	if (g_path_is_absolute(filename) &&
+	    (buffer = g_hash_table_lookup(teco_ring_index.names, filename)))
+		return buffer;
+
+	g_autofree gchar *resolved = teco_file_get_absolute_path(filename);
+	return resolved ? g_hash_table_lookup(teco_ring_index.names, resolved)
+	                : teco_ring_find_by_name(NULL);
 }
 
 teco_buffer_t *
 teco_ring_find_by_id(teco_int_t id)
 {
-	for (teco_tailq_entry_t *cur = teco_ring_head.first; cur != NULL; cur = cur->next) {
-		if (!--id)
-			return (teco_buffer_t *)cur;
-	}
-
-	return NULL;
+	return 1 <= id && id <= teco_ring_index.buffers->len
+			? g_ptr_array_index(teco_ring_index.buffers, id-1) : NULL;
 }
 
 void
 teco_ring_dirtify(void)
 {
-	if (teco_qreg_current || teco_ring_current->dirty)
-		return;
-
-	undo__teco_interface_info_update_buffer(teco_ring_current);
-	teco_undo_gboolean(teco_ring_current->dirty) = TRUE;
-	teco_interface_info_update(teco_ring_current);
+	if (!teco_qreg_current)
+		teco_buffer_dirtify(teco_ring_current);
 }
 
 /** Get id of first dirty buffer, or otherwise 0 */
 guint
 teco_ring_get_first_dirty(void)
 {
-	guint id = 1;
-
-	for (teco_tailq_entry_t *cur = teco_ring_head.first; cur != NULL; cur = cur->next) {
-		teco_buffer_t *buffer = (teco_buffer_t *)cur;
-		if (buffer->dirty)
-			return id;
-		id++;
+	guint id = 0;
+
+	GHashTableIter iter;
+	gpointer buffer;
+	g_hash_table_iter_init(&iter, teco_ring_index.dirty);
+	while (g_hash_table_iter_next(&iter, &buffer, NULL)) {
+		guint cur_id = teco_ring_get_id(buffer);
+		if (!id || cur_id < id)
+			id = cur_id;
 	}
 
-	return 0;
+	return id;
+}
+
+static gint
+teco_ring_cmp_ids(gconstpointer a, gconstpointer b)
+{
+	teco_int_t id_a = teco_ring_get_id(*(teco_buffer_t **)a);
+	teco_int_t id_b = teco_ring_get_id(*(teco_buffer_t **)b);
+	return id_a < id_b ? -1 : id_a > id_b;
+}
+
+/**
+ * Get all dirty buffers in ring order.
+ *
+ * @return A new array of buffers that must be freed with g_ptr_array_unref().
+ */
+static GPtrArray *
+teco_ring_get_dirty_buffers(void)
+{
+	GPtrArray *ret = g_ptr_array_sized_new(g_hash_table_size(teco_ring_index.dirty));
+
+	GHashTableIter iter;
+	gpointer buffer;
+	g_hash_table_iter_init(&iter, teco_ring_index.dirty);
+	while (g_hash_table_iter_next(&iter, &buffer, NULL))
+		g_ptr_array_add(ret, buffer);
+	g_ptr_array_sort(ret, teco_ring_cmp_ids);
+
+	return ret;
 }
 
 gboolean
 teco_ring_save_all_dirty_buffers(GError **error)
 {
-	for (teco_tailq_entry_t *cur = teco_ring_head.first; cur != NULL; cur = cur->next) {
-		teco_buffer_t *buffer = (teco_buffer_t *)cur;
-		/* NOTE: Will fail for a dirty unnamed file */
-		if (buffer->dirty && !teco_buffer_save(buffer, NULL, error))
-			return FALSE;
+	/* saving modifies the dirty set, so we iterate a copy */
+	g_autoptr(GPtrArray) dirty = teco_ring_get_dirty_buffers();
+
+	/*
+	 * Saving would stop at a dirty unnamed file,
+	 * so only the buffers before it are written.
+	 */
+	guint named = 0;
+	while (named < dirty->len &&
+	       ((teco_buffer_t *)g_ptr_array_index(dirty, named))->filename)
+		named++;
+
+	/*
+	 * The documents are written concurrently by worker threads.
+	 * Dirty buffers are never lazy, so their views already exist.
+	 * If several buffers cannot be written, the first error is
+	 * reported, while the others are logged.
+	 */
+	g_autoptr(teco_view_saver_t) saver = teco_view_saver_new();
+	for (guint i = 0; i < named; i++) {
+		teco_buffer_t *buffer = g_ptr_array_index(dirty, i);
+		teco_view_saver_add(saver, buffer->view, buffer->filename);
 	}
 
-	return TRUE;
+	gboolean ret = TRUE;
+	for (guint i = 0; i < named; i++) {
+		teco_buffer_t *buffer = g_ptr_array_index(dirty, i);
+		g_autoptr(GError) tmp_error = NULL;
+
+		if (teco_view_saver_wait(saver, i, &tmp_error)) {
+			teco_buffer_set_saved(buffer, NULL);
+		} else if (ret) {
+			g_propagate_error(error, g_steal_pointer(&tmp_error));
+			ret = FALSE;
+		} else {
+			teco_interface_msg(TECO_MSG_ERROR, "%s", tmp_error->message);
+		}
+	}
+
+	/* NOTE: Will fail for a dirty unnamed file */
+	return ret && (named == dirty->len ||
+	               teco_buffer_save(g_ptr_array_index(dirty, named), NULL, error));
 }
 
+/**
+ * Run the deferred ED hook for added buffers.
+ *
+ * Lazily added buffers are reported as added only when
+ * they become the current buffer for the first time.
+ * Must be called after the buffer has been made current
+ * in an undoable way, so the hook can do anything it could
+ * also do when the buffer is added immediately.
+ */
 gboolean
-teco_ring_edit_by_name(const gchar *filename, GError **error)
+teco_ring_run_deferred_hook(GError **error)
+{
+	if (!teco_ring_current->pending_add_hook)
+		return TRUE;
+
+	teco_undo_gboolean(teco_ring_current->pending_add_hook) = FALSE;
+	return teco_ed_hook(TECO_ED_HOOK_ADD, error);
+}
+
+/**
+ * Make an existing buffer the current one.
+ * Executes the appropriate ED hook.
+ */
+static gboolean
+teco_ring_edit_buffer(teco_buffer_t *buffer, GError **error)
+{
+	/* make sure that the current buffer is never lazy */
+	if (!teco_buffer_materialize(buffer, error))
+		return FALSE;
+	teco_ring_current = buffer;
+	teco_buffer_edit(buffer, NULL);
+
+	return buffer->pending_add_hook ? teco_ring_run_deferred_hook(error)
+	                                : teco_ed_hook(TECO_ED_HOOK_EDIT, error);
+}
+
+static gboolean
+teco_ring_edit_file(const gchar *filename, teco_view_loader_t *loader, GError **error)
 {
 	teco_buffer_t *buffer = teco_ring_find(filename);
 
 	teco_qreg_table_current = NULL;
 	teco_qreg_current = NULL;
-	if (buffer) {
-		teco_ring_current = buffer;
-		teco_buffer_edit(buffer);
-
-		return teco_ed_hook(TECO_ED_HOOK_EDIT, error);
-	}
+	if (buffer)
+		return teco_ring_edit_buffer(buffer, error);
 
 	buffer = teco_buffer_new();
-	teco_tailq_insert_tail(&teco_ring_head, &buffer->entry);
+	teco_ring_insert(buffer, NULL);
 
 	teco_ring_current = buffer;
 	teco_ring_undo_close();
 
-	teco_buffer_edit(buffer);
+	if (!teco_buffer_edit(buffer, error))
+		return FALSE;
 	if (filename && g_file_test(filename, G_FILE_TEST_IS_REGULAR)) {
-		if (!teco_buffer_load(buffer, filename, error))
+		if (!teco_buffer_load(buffer, filename, loader, error))
 			return FALSE;
 
 		teco_interface_msg(TECO_MSG_INFO,
@@ -304,6 +651,12 @@ teco_ring_edit_by_name(const gchar *filename, GError **error)
 	return teco_ed_hook(TECO_ED_HOOK_ADD, error);
 }
 
+gboolean
+teco_ring_edit_by_name(const gchar *filename, GError **error)
+{
+	return teco_ring_edit_file(filename, NULL, error);
+}
+
 gboolean
 teco_ring_edit_by_id(teco_int_t id, GError **error)
 {
@@ -315,16 +668,16 @@ teco_ring_edit_by_id(teco_int_t id, GError **error)
 
 	teco_qreg_table_current = NULL;
 	teco_qreg_current = NULL;
-	teco_ring_current = buffer;
-	teco_buffer_edit(buffer);
-
-	return teco_ed_hook(TECO_ED_HOOK_EDIT, error);
+	return teco_ring_edit_buffer(buffer, error);
 }
 
 static void
 teco_ring_remove_buffer(teco_buffer_t *buffer)
 {
+	g_ptr_array_remove_index(teco_ring_index.buffers, teco_ring_get_id(buffer)-1);
 	teco_tailq_remove(&teco_ring_head, &buffer->entry);
+	teco_ring_unindex_name(buffer);
+	g_hash_table_remove(teco_ring_index.dirty, buffer);
 
 	if (buffer->filename)
 		teco_interface_msg(TECO_MSG_INFO,
@@ -337,6 +690,34 @@ teco_ring_remove_buffer(teco_buffer_t *buffer)
 
 TECO_DEFINE_UNDO_CALL(teco_ring_remove_buffer, teco_buffer_t *);
 
+/**
+ * Add file to the ring without loading it or making it the current buffer.
+ *
+ * The file is loaded only once the buffer's contents are
+ * required (see teco_buffer_materialize()).
+ * The ED hook for added buffers is deferred until the buffer
+ * is edited for the first time.
+ * Does nothing if the file is already in the ring.
+ */
+static void
+teco_ring_add_lazy(const gchar *filename)
+{
+	if (teco_ring_find(filename))
+		return;
+
+	teco_buffer_t *buffer = g_new0(teco_buffer_t, 1);
+	buffer->lazy = buffer->pending_add_hook = TRUE;
+	teco_ring_insert(buffer, NULL);
+
+	undo__teco_buffer_free(buffer);
+	undo__teco_ring_remove_buffer(buffer);
+
+	teco_buffer_set_filename(buffer, filename);
+
+	teco_interface_msg(TECO_MSG_INFO,
+	                   "Added file \"%s\" to ring (not loaded yet)", filename);
+}
+
 /**
  * Close the given buffer.
  * Executes close hooks and changes the current buffer if necessary.
@@ -349,18 +730,24 @@ teco_ring_close(teco_buffer_t *buffer, GError **error)
 		if (!teco_ed_hook(TECO_ED_HOOK_CLOSE, error))
 			return FALSE;
 
+		/*
+		 * The next buffer is loaded before removing the current
+		 * one, so loading errors do not leave the ring inconsistent.
+		 */
+		teco_buffer_t *next = teco_buffer_next(buffer) ? : teco_buffer_prev(buffer);
+		if (next && !teco_buffer_materialize(next, error))
+			return FALSE;
+
 		teco_ring_undo_edit();
 		teco_ring_remove_buffer(buffer);
 
-		teco_ring_current = teco_buffer_next(buffer) ? : teco_buffer_prev(buffer);
-		if (!teco_ring_current) {
+		if (!next) {
 			/* edit new unnamed buffer */
+			teco_ring_current = NULL;
 			if (!teco_ring_edit_by_name(NULL, error))
 				return FALSE;
-		} else {
-			teco_buffer_edit(teco_ring_current);
-			if (!teco_ed_hook(TECO_ED_HOOK_EDIT, error))
-				return FALSE;
+		} else if (!teco_ring_edit_buffer(next, error)) {
+			return FALSE;
 		}
 	} else {
 		teco_ring_remove_buffer(buffer);
@@ -384,7 +771,8 @@ teco_ring_set_scintilla_undo(gboolean state)
 {
 	for (teco_tailq_entry_t *cur = teco_ring_head.first; cur != NULL; cur = cur->next) {
 		teco_buffer_t *buffer = (teco_buffer_t *)cur;
-		teco_view_set_scintilla_undo(buffer->view, state);
+		if (!buffer->lazy)
+			teco_view_set_scintilla_undo(buffer->view, state);
 	}
 }
 
@@ -399,6 +787,19 @@ teco_ring_cleanup(void)
 	}
 
 	teco_ring_head = TECO_TAILQ_HEAD_INITIALIZER(&teco_ring_head);
+
+	g_ptr_array_set_size(teco_ring_index.buffers, 0);
+	g_hash_table_remove_all(teco_ring_index.names);
+	teco_ring_index.named_count = 0;
+	g_hash_table_remove_all(teco_ring_index.dirty);
+}
+
+static void TECO_DEBUG_CLEANUP
+teco_ring_index_cleanup(void)
+{
+	g_ptr_array_unref(teco_ring_index.buffers);
+	g_hash_table_unref(teco_ring_index.names);
+	g_hash_table_unref(teco_ring_index.dirty);
 }
 
 /*
@@ -431,7 +832,7 @@ teco_state_edit_file_initial(teco_machine_main_t *ctx, GError **error)
 			                         strlen(filename), cur == teco_ring_current);
 		}
 
-		teco_interface_popup_show(0);
+		teco_interface_popup_show(0, TRUE);
 	} else if (id > 0) {
 		allow_filename = FALSE;
 		if (!teco_current_doc_undo_edit(error) ||
@@ -448,6 +849,9 @@ teco_state_edit_file_done(teco_machine_main_t *ctx, const teco_string_t *str, GE
 	if (ctx->flags.mode > TECO_MODE_NORMAL)
 		return &teco_state_start;
 
+	/* buffers cannot be restored from state images */
+	teco_image_taint();
+
 	if (!allow_filename) {
 		if (str->len > 0) {
 			g_set_error_literal(error, TECO_ERROR, TECO_ERROR_FAILED,
@@ -465,12 +869,43 @@ teco_state_edit_file_done(teco_machine_main_t *ctx, const teco_string_t *str, GE
 		teco_globber_init(&globber, filename, G_FILE_TEST_IS_REGULAR);
 
 		gchar *globbed_filename;
-		while ((globbed_filename = teco_globber_next(&globber))) {
-			gboolean rc = teco_current_doc_undo_edit(error) &&
-			              teco_ring_edit(globbed_filename, error);
-			g_free(globbed_filename);
-			if (!rc)
+		if (teco_ed & TECO_ED_LAZYLOAD) {
+			g_autofree gchar *last_filename = NULL;
+			while ((globbed_filename = teco_globber_next(&globber))) {
+				/* all but the last matching file are added lazily */
+				if (last_filename)
+					teco_ring_add_lazy(last_filename);
+				g_free(last_filename);
+				last_filename = globbed_filename;
+			}
+
+			if (last_filename &&
+			    (!teco_current_doc_undo_edit(error) || !teco_ring_edit(last_filename, error)))
+				return NULL;
+
+			return &teco_state_start;
+		}
+
+		/*
+		 * The files are read and EOL-normalized by worker threads
+		 * ahead of time, so only inserting them into the views
+		 * and executing the hooks is serialized.
+		 */
+		g_autoptr(GPtrArray) filenames = g_ptr_array_new_with_free_func(g_free);
+		while ((globbed_filename = teco_globber_next(&globber)))
+			g_ptr_array_add(filenames, globbed_filename);
+
+		g_autoptr(teco_view_loader_t) loader = teco_view_loader_new(filenames);
+		const gchar *loader_filename;
+		while ((loader_filename = teco_view_loader_next(loader))) {
+			if (!teco_current_doc_undo_edit(error) ||
+			    !teco_ring_edit_file(loader_filename, loader, error))
+				return NULL;
+
+			if (G_UNLIKELY(teco_interface_is_interrupted())) {
+				teco_error_interrupted_set(error);
 				return NULL;
+			}
 		}
 	} else {
 		if (!teco_current_doc_undo_edit(error) ||
@@ -510,6 +945,11 @@ teco_state_edit_file_done(teco_machine_main_t *ctx, const teco_string_t *str, GE
  * Also refer to the section called
  * .B Glob Patterns
  * for more details.
+ * If bit 2048 is set in the \fBED\fP flags, all but the
+ * last matching file are added to the ring without loading
+ * them, which is considerably faster when opening many files.
+ * They are loaded only when first edited or when their
+ * contents are otherwise required.
  *
  * File names of buffers in the ring are normalized
  * by making them absolute.
@@ -32,6 +32,22 @@ typedef struct teco_buffer_t {
 
 	gchar *filename;
 	gboolean dirty;
+
+	/**
+	 * Whether the buffer's file has not been loaded yet.
+	 * Lazy buffers do not have a view.
+	 * Use teco_buffer_materialize() before accessing it.
+	 */
+	gboolean lazy;
+	/** Whether the ED hook for added buffers has been deferred */
+	gboolean pending_add_hook;
+
+	/**
+	 * Cached buffer id.
+	 * Only valid if it refers to this buffer in the ring index.
+	 * Use teco_ring_get_id() to retrieve it.
+	 */
+	guint id;
 } teco_buffer_t;
 
 /** @memberof teco_buffer_t */
@@ -48,8 +64,10 @@ teco_buffer_prev(teco_buffer_t *ctx)
 	return (teco_buffer_t *)ctx->entry.prev->prev->next;
 }
 
-void teco_buffer_edit(teco_buffer_t *ctx);
+gboolean teco_buffer_materialize(teco_buffer_t *ctx, GError **error);
+gboolean teco_buffer_edit(teco_buffer_t *ctx, GError **error);
 void teco_buffer_undo_edit(teco_buffer_t *ctx);
+void teco_buffer_dirtify(teco_buffer_t *ctx);
 
 extern teco_buffer_t *teco_ring_current;
 
@@ -70,6 +88,8 @@ void teco_ring_dirtify(void);
 guint teco_ring_get_first_dirty(void);
 gboolean teco_ring_save_all_dirty_buffers(GError **error);
 
+gboolean teco_ring_run_deferred_hook(GError **error);
+
 gboolean teco_ring_edit_by_name(const gchar *filename, GError **error);
 gboolean teco_ring_edit_by_id(teco_int_t id, GError **error);
 
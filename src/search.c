@@ -35,6 +35,7 @@
 #include "parser.h"
 #include "core-commands.h"
 #include "error.h"
+#include "stats.h"
 #include "search.h"
 
 typedef struct {
@@ -353,7 +354,7 @@ teco_class2regexp(teco_search_state_t *state, teco_string_t *pattern,
  * @return The regular expression string or NULL in case of GError.
  *         Must be freed with g_free().
  */
-static gchar *
+gchar *
 teco_pattern2regexp(teco_string_t *pattern, teco_machine_qregspec_t *qreg_machine,
                     guint codepage, gboolean single_expr, GError **error)
 {
@@ -585,6 +586,7 @@ teco_do_search(GRegex *re, gsize from, gsize to, gint *count, GError **error)
 	 * NOTE: The return boolean does NOT signal whether an error was generated.
 	 */
 	g_regex_match_full(re, buffer, to-from, 0, 0, &info, &tmp_error);
+	teco_stats_inc(TECO_STATS_REGEX_MATCHED);
 	if (tmp_error) {
 		g_propagate_error(error, tmp_error);
 		return FALSE;
@@ -599,6 +601,7 @@ teco_do_search(GRegex *re, gsize from, gsize to, gint *count, GError **error)
 			 * NOTE: The return boolean does NOT signal whether an error was generated.
 			 */
 			g_match_info_next(info, &tmp_error);
+			teco_stats_inc(TECO_STATS_REGEX_MATCHED);
 			if (tmp_error) {
 				g_propagate_error(error, tmp_error);
 				return FALSE;
@@ -652,6 +655,7 @@ teco_do_search(GRegex *re, gsize from, gsize to, gint *count, GError **error)
 			 * NOTE: The return boolean does NOT signal whether an error was generated.
 			 */
 			g_match_info_next(info, &tmp_error);
+			teco_stats_inc(TECO_STATS_REGEX_MATCHED);
 			if (tmp_error) {
 				g_propagate_error(error, tmp_error);
 				for (int i = 0; i < matched_num; i++)
@@ -759,11 +763,13 @@ teco_state_search_process(teco_machine_main_t *ctx, const teco_string_t *str, gs
 	re = g_regex_new(re_pattern, flags, 0, NULL);
 	if (!re)
 		goto failure;
+	teco_stats_inc(TECO_STATS_REGEX_COMPILED);
 
 	if (!teco_qreg_current &&
 	    teco_ring_current != teco_search_parameters.from_buffer) {
 		teco_ring_undo_edit();
-		teco_buffer_edit(teco_search_parameters.from_buffer);
+		if (!teco_buffer_edit(teco_search_parameters.from_buffer, error))
+			return FALSE;
 	}
 
 	gint count = teco_search_parameters.count;
@@ -780,7 +786,8 @@ teco_state_search_process(teco_machine_main_t *ctx, const teco_string_t *str, gs
 		if (count > 0) {
 			do {
 				buffer = teco_buffer_next(buffer) ? : teco_ring_first();
-				teco_buffer_edit(buffer);
+				if (!teco_buffer_edit(buffer, error))
+					return FALSE;
 
 				if (buffer == teco_search_parameters.to_buffer) {
 					if (!teco_do_search(re, 0, teco_search_parameters.dot, &count, error))
@@ -795,7 +802,8 @@ teco_state_search_process(teco_machine_main_t *ctx, const teco_string_t *str, gs
 		} else /* count < 0 */ {
 			do {
 				buffer = teco_buffer_prev(buffer) ? : teco_ring_last();
-				teco_buffer_edit(buffer);
+				if (!teco_buffer_edit(buffer, error))
+					return FALSE;
 
 				if (buffer == teco_search_parameters.to_buffer) {
 					if (!teco_do_search(re, teco_search_parameters.dot,
@@ -815,6 +823,10 @@ teco_state_search_process(teco_machine_main_t *ctx, const teco_string_t *str, gs
 		 * FIXME: Why is this necessary?
 		 */
 		teco_ring_current = buffer;
+
+		/* the buffer might have been added lazily */
+		if (!teco_ring_run_deferred_hook(error))
+			return FALSE;
 	}
 
 	if (!search_reg->vtable->set_integer(search_reg, teco_bool(!count), error))
@@ -20,6 +20,9 @@
 
 #include "parser.h"
 
+gchar *teco_pattern2regexp(teco_string_t *pattern, teco_machine_qregspec_t *qreg_machine,
+                           guint codepage, gboolean single_expr, GError **error);
+
 void teco_state_control_search_mode(teco_machine_main_t *ctx, GError **error);
 
 TECO_DECLARE_STATE(teco_state_search);
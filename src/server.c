@@ -0,0 +1,877 @@
+/*
+ * Copyright (C) 2012-2025 Robin Haberkorn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+/* for struct ucred */
+#define _GNU_SOURCE
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+
+#include <glib.h>
+#include <glib/gprintf.h>
+#include <glib/gstdio.h>
+
+#include "sciteco.h"
+#include "error.h"
+#include "server.h"
+
+#ifdef TECO_SERVER
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+/** Number of file descriptors (stdin, stdout and stderr) passed along with every job */
+#define TECO_SERVER_FDS 3
+
+/**
+ * Client connections of running jobs, indexed by the job's PID.
+ * Their exit codes are reported back on these connections.
+ */
+static GHashTable *teco_server_jobs = NULL;
+
+/**
+ * Self-pipe for waking up the server when jobs terminate.
+ * This avoids races between reaping jobs and waiting for new connections.
+ */
+static int teco_server_sigchld_pipe[2] = {-1, -1};
+
+/** PID of the job executing on behalf of the client */
+static volatile sig_atomic_t teco_client_job_pid = 0;
+
+static gboolean
+teco_server_get_address(const gchar *path, struct sockaddr_un *addr, GError **error)
+{
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+
+	if (strlen(path) >= sizeof(addr->sun_path)) {
+		g_set_error(error, TECO_ERROR, TECO_ERROR_FAILED,
+		            "Socket path \"%s\" is too long", path);
+		return FALSE;
+	}
+	strcpy(addr->sun_path, path);
+
+	return TRUE;
+}
+
+static gboolean
+teco_server_write(int fd, const void *buf, gsize len)
+{
+	const gchar *p = buf;
+
+	while (len > 0) {
+		gssize rc = write(fd, p, len);
+		if (rc < 0 && errno == EINTR)
+			continue;
+		if (rc < 0)
+			return FALSE;
+		p += rc;
+		len -= rc;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+teco_server_read(int fd, void *buf, gsize len)
+{
+	gchar *p = buf;
+
+	while (len > 0) {
+		gssize rc = read(fd, p, len);
+		if (rc < 0 && errno == EINTR)
+			continue;
+		if (rc <= 0)
+			return FALSE;
+		p += rc;
+		len -= rc;
+	}
+
+	return TRUE;
+}
+
+/*
+ * Jobs are serialized as a sequence of null-terminated strings:
+ * The working directory, followed by the command line arguments and
+ * the environment, each prefixed with the number of strings.
+ */
+
+static void
+teco_server_append_strv(GString *payload, gchar **strv)
+{
+	guint32 n = g_strv_length(strv);
+
+	g_string_append_len(payload, (const gchar *)&n, sizeof(n));
+	for (guint i = 0; i < n; i++)
+		g_string_append_len(payload, strv[i], strlen(strv[i])+1);
+}
+
+static gchar *
+teco_server_parse_str(const gchar **p, const gchar *end)
+{
+	const gchar *nul = memchr(*p, '\0', end - *p);
+	if (!nul)
+		return NULL;
+
+	gchar *str = g_strndup(*p, nul - *p);
+	*p = nul+1;
+	return str;
+}
+
+static gchar **
+teco_server_parse_strv(const gchar **p, const gchar *end)
+{
+	guint32 n;
+
+	if (end - *p < sizeof(n))
+		return NULL;
+	memcpy(&n, *p, sizeof(n));
+	*p += sizeof(n);
+	/* every string takes at least one byte */
+	if (n > end - *p)
+		return NULL;
+
+	gchar **strv = g_new0(gchar *, n+1);
+	for (guint i = 0; i < n; i++) {
+		strv[i] = teco_server_parse_str(p, end);
+		if (!strv[i]) {
+			g_strfreev(strv);
+			return NULL;
+		}
+	}
+
+	return strv;
+}
+
+/**
+ * Send a job to the server.
+ *
+ * The standard file descriptors are passed along with the
+ * length of the job payload (SCM_RIGHTS), so the job
+ * reads and writes directly from/to the client's streams.
+ */
+static gboolean
+teco_client_send_job(int fd, gchar **argv, GError **error)
+{
+	g_autofree gchar *cwd = g_get_current_dir();
+	g_auto(GStrv) env = g_get_environ();
+
+	g_autoptr(GString) payload = g_string_new(cwd);
+	g_string_append_c(payload, '\0');
+	teco_server_append_strv(payload, argv);
+	teco_server_append_strv(payload, env);
+
+	guint32 len = payload->len;
+	struct iovec iov = {.iov_base = &len, .iov_len = sizeof(len)};
+	union {
+		struct cmsghdr align;
+		gchar buf[CMSG_SPACE(sizeof(int)*TECO_SERVER_FDS)];
+	} control;
+	memset(&control, 0, sizeof(control));
+	struct msghdr msg = {
+		.msg_iov = &iov, .msg_iovlen = 1,
+		.msg_control = control.buf, .msg_controllen = sizeof(control.buf)
+	};
+
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int)*TECO_SERVER_FDS);
+	const int fds[TECO_SERVER_FDS] = {0, 1, 2};
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+	if (sendmsg(fd, &msg, 0) != sizeof(len) ||
+	    !teco_server_write(fd, payload->str, payload->len)) {
+		g_set_error(error, TECO_ERROR, TECO_ERROR_FAILED,
+		            "Cannot send job to server: %s", g_strerror(errno));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Receive a job from the client and take over its
+ * standard streams, working directory and environment.
+ */
+static gboolean
+teco_server_receive_job(int fd, gchar ***argv, GError **error)
+{
+	guint32 len;
+	struct iovec iov = {.iov_base = &len, .iov_len = sizeof(len)};
+	union {
+		struct cmsghdr align;
+		gchar buf[CMSG_SPACE(sizeof(int)*TECO_SERVER_FDS)];
+	} control;
+	struct msghdr msg = {
+		.msg_iov = &iov, .msg_iovlen = 1,
+		.msg_control = control.buf, .msg_controllen = sizeof(control.buf)
+	};
+
+	if (recvmsg(fd, &msg, 0) != sizeof(len)) {
+		g_set_error(error, TECO_ERROR, TECO_ERROR_FAILED,
+		            "Cannot receive job: %s", g_strerror(errno));
+		return FALSE;
+	}
+
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+	    cmsg->cmsg_len != CMSG_LEN(sizeof(int)*TECO_SERVER_FDS)) {
+		g_set_error_literal(error, TECO_ERROR, TECO_ERROR_FAILED,
+		                    "Invalid job received");
+		return FALSE;
+	}
+	int fds[TECO_SERVER_FDS];
+	memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+
+	/*
+	 * NOTE: The received descriptors are always > 2,
+	 * unless the server was started with closed standard streams.
+	 */
+	for (gint i = 0; i < TECO_SERVER_FDS; i++) {
+		dup2(fds[i], i);
+		if (fds[i] != i)
+			close(fds[i]);
+	}
+
+	g_autofree gchar *payload = g_malloc(len);
+	if (!teco_server_read(fd, payload, len)) {
+		g_set_error_literal(error, TECO_ERROR, TECO_ERROR_FAILED,
+		                    "Cannot receive job: Connection lost");
+		return FALSE;
+	}
+
+	const gchar *p = payload, *end = payload + len;
+	g_autofree gchar *cwd = teco_server_parse_str(&p, end);
+	g_auto(GStrv) job_argv = cwd ? teco_server_parse_strv(&p, end) : NULL;
+	g_auto(GStrv) env = job_argv ? teco_server_parse_strv(&p, end) : NULL;
+	if (!env || !job_argv[0]) {
+		g_set_error_literal(error, TECO_ERROR, TECO_ERROR_FAILED,
+		                    "Invalid job received");
+		return FALSE;
+	}
+
+	if (g_chdir(cwd)) {
+		g_set_error(error, TECO_ERROR, TECO_ERROR_FAILED,
+		            "Cannot change into working directory \"%s\": %s",
+		            cwd, g_strerror(errno));
+		return FALSE;
+	}
+
+	/*
+	 * The environment is imported into the Q-Register table
+	 * only afterwards, so it is still safe to modify it.
+	 */
+	g_auto(GStrv) vars = g_listenv();
+	for (gchar **var = vars; *var; var++)
+		g_unsetenv(*var);
+	for (gchar **var = env; *var; var++) {
+		gchar *sep = strchr(*var, '=');
+		if (!sep)
+			continue;
+		*sep = '\0';
+		g_setenv(*var, sep+1, TRUE);
+	}
+
+	*argv = g_steal_pointer(&job_argv);
+	return TRUE;
+}
+
+static void
+teco_server_sigint_handler(int signal)
+{
+	teco_interrupted = TRUE;
+}
+
+static void
+teco_server_sigchld_handler(int signal)
+{
+	int saved_errno = errno;
+	G_GNUC_UNUSED gssize rc = write(teco_server_sigchld_pipe[1], "", 1);
+	errno = saved_errno;
+}
+
+static void
+teco_server_reap_jobs(void)
+{
+	gchar buf[64];
+	while (read(teco_server_sigchld_pipe[0], buf, sizeof(buf)) > 0);
+
+	pid_t pid;
+	int status;
+	while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+		gpointer fd;
+		if (!g_hash_table_lookup_extended(teco_server_jobs, GINT_TO_POINTER(pid), NULL, &fd))
+			continue;
+		g_hash_table_remove(teco_server_jobs, GINT_TO_POINTER(pid));
+
+		/* same as the shell would report */
+		gint32 code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+		/* the client might be gone already */
+		teco_server_write(GPOINTER_TO_INT(fd), &code, sizeof(code));
+		close(GPOINTER_TO_INT(fd));
+	}
+}
+
+static void
+teco_server_close_jobs(void)
+{
+	GHashTableIter iter;
+	gpointer fd;
+
+	g_hash_table_iter_init(&iter, teco_server_jobs);
+	while (g_hash_table_iter_next(&iter, NULL, &fd))
+		close(GPOINTER_TO_INT(fd));
+	g_hash_table_destroy(teco_server_jobs);
+	teco_server_jobs = NULL;
+
+	close(teco_server_sigchld_pipe[0]);
+	close(teco_server_sigchld_pipe[1]);
+	teco_server_sigchld_pipe[0] = teco_server_sigchld_pipe[1] = -1;
+}
+
+/**
+ * Check whether a client connection is owned by the server's user.
+ *
+ * Jobs can do anything the server's user can do (e.g. via EC),
+ * so they must not be accepted from other users.
+ * The socket's permissions already deny access to other users,
+ * but not every platform enforces them.
+ */
+static gboolean
+teco_server_peer_is_trusted(int fd)
+{
+#if defined(__linux__) && defined(SO_PEERCRED)
+	struct ucred cred;
+	socklen_t len = sizeof(cred);
+	return !getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) &&
+	       cred.uid == geteuid();
+#elif defined(HAVE_GETPEEREID)
+	uid_t uid;
+	gid_t gid;
+	return !getpeereid(fd, &uid, &gid) && uid == geteuid();
+#else
+	/* rely on the socket's permissions */
+	return TRUE;
+#endif
+}
+
+/**
+ * Run a persistent server, listening on a Unix domain socket.
+ *
+ * Every job received from a client (see teco_client_run()) is
+ * executed in a process forked from the server, so it starts
+ * with the server's already initialized state, but cannot
+ * affect the server or any other job.
+ * The server terminates on SIGINT or SIGTERM.
+ *
+ * @param path Path of the socket to create.
+ * @param argv Where to store the job's command line arguments.
+ * @param error Where to store errors.
+ * @return TRUE in the job process, after it has taken over the client's
+ *   standard streams, working directory and environment.
+ *   FALSE in the server process after it terminated,
+ *   or in the job process if the job could not be received.
+ *   error is set only on failures.
+ */
+gboolean
+teco_server_run(const gchar *path, gchar ***argv, GError **error)
+{
+	struct sockaddr_un addr;
+	if (!teco_server_get_address(path, &addr, error))
+		return FALSE;
+
+	/*
+	 * Remove stale sockets, but never any other file
+	 * and never the socket of a running server.
+	 */
+	GStatBuf st;
+	if (!g_lstat(path, &st) && S_ISSOCK(st.st_mode)) {
+		int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		gboolean alive = fd >= 0 && !connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+		int connect_errno = errno;
+		if (fd >= 0)
+			close(fd);
+
+		if (alive) {
+			g_set_error(error, TECO_ERROR, TECO_ERROR_FAILED,
+			            "Server is already listening on \"%s\"", path);
+			return FALSE;
+		}
+		if (connect_errno == ECONNREFUSED)
+			g_unlink(path);
+	}
+
+	/*
+	 * Only the server's user may connect.
+	 * The umask applies while binding, so the socket
+	 * is never accessible to anybody else.
+	 */
+	int server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	mode_t mask = umask(0077);
+	gboolean bound = server_fd >= 0 &&
+	                 !bind(server_fd, (struct sockaddr *)&addr, sizeof(addr));
+	umask(mask);
+	if (!bound || listen(server_fd, SOMAXCONN)) {
+		g_set_error(error, TECO_ERROR, TECO_ERROR_FAILED,
+		            "Cannot listen on \"%s\": %s", path, g_strerror(errno));
+		if (server_fd >= 0)
+			close(server_fd);
+		return FALSE;
+	}
+
+	if (pipe(teco_server_sigchld_pipe)) {
+		g_set_error(error, TECO_ERROR, TECO_ERROR_FAILED,
+		            "Cannot create pipe: %s", g_strerror(errno));
+		close(server_fd);
+		g_unlink(path);
+		return FALSE;
+	}
+	for (gint i = 0; i < 2; i++)
+		fcntl(teco_server_sigchld_pipe[i], F_SETFL, O_NONBLOCK);
+
+	teco_server_jobs = g_hash_table_new(NULL, NULL);
+
+	/*
+	 * Signals must interrupt poll(), so we cannot use signal(),
+	 * which might imply SA_RESTART.
+	 */
+	struct sigaction sa = {.sa_handler = teco_server_sigint_handler};
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	sa.sa_handler = teco_server_sigchld_handler;
+	sigaction(SIGCHLD, &sa, NULL);
+	/* writing exit codes to vanished clients must not kill the server */
+	signal(SIGPIPE, SIG_IGN);
+
+	while (!teco_interrupted) {
+		struct pollfd pfds[] = {
+			{.fd = server_fd, .events = POLLIN},
+			{.fd = teco_server_sigchld_pipe[0], .events = POLLIN}
+		};
+		if (poll(pfds, G_N_ELEMENTS(pfds), -1) <= 0)
+			continue;
+
+		if (pfds[1].revents)
+			teco_server_reap_jobs();
+		if (!pfds[0].revents)
+			continue;
+
+		int fd = accept(server_fd, NULL, NULL);
+		if (fd < 0)
+			continue;
+		if (!teco_server_peer_is_trusted(fd)) {
+			g_fprintf(stderr, "Rejected job from foreign user\n");
+			close(fd);
+			continue;
+		}
+
+		/* buffered output must not be duplicated into the job */
+		fflush(NULL);
+
+		pid_t pid = fork();
+		if (pid == 0) {
+			/* job process */
+			close(server_fd);
+			teco_server_close_jobs();
+
+			signal(SIGPIPE, SIG_DFL);
+			signal(SIGCHLD, SIG_DFL);
+			signal(SIGINT, teco_server_sigint_handler);
+			signal(SIGTERM, teco_server_sigint_handler);
+
+			gboolean rc = teco_server_receive_job(fd, argv, error);
+			close(fd);
+			return rc;
+		}
+
+		if (pid < 0) {
+			/* the client will see the connection closing */
+			g_fprintf(stderr, "Cannot fork job: %s\n", g_strerror(errno));
+			close(fd);
+			continue;
+		}
+
+		gint32 job_pid = pid;
+		teco_server_write(fd, &job_pid, sizeof(job_pid));
+		g_hash_table_insert(teco_server_jobs, GINT_TO_POINTER(pid), GINT_TO_POINTER(fd));
+	}
+
+	/* jobs that are still running will not report their exit codes */
+	close(server_fd);
+	g_unlink(path);
+	teco_server_close_jobs();
+	return FALSE;
+}
+
+static void
+teco_client_signal_handler(int signal)
+{
+	if (teco_client_job_pid > 0)
+		kill(teco_client_job_pid, signal);
+}
+
+/**
+ * Execute a job on a server (see teco_server_run()).
+ *
+ * The job runs with the client's standard streams,
+ * working directory and environment.
+ * SIGINT and SIGTERM are forwarded to the job.
+ *
+ * @param path Path of the server's socket.
+ * @param argv Command line arguments of the job, including the program name.
+ * @return The job's exit code.
+ */
+gint
+teco_client_run(const gchar *path, gchar **argv)
+{
+	g_autoptr(GError) error = NULL;
+	int fd = -1;
+	gint32 pid, code;
+
+	struct sockaddr_un addr;
+	if (!teco_server_get_address(path, &addr, &error))
+		goto error;
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+		g_set_error(&error, TECO_ERROR, TECO_ERROR_FAILED,
+		            "Cannot connect to server \"%s\": %s", path, g_strerror(errno));
+		goto error;
+	}
+
+	if (!teco_client_send_job(fd, argv, &error))
+		goto error;
+
+	if (!teco_server_read(fd, &pid, sizeof(pid))) {
+		g_set_error_literal(&error, TECO_ERROR, TECO_ERROR_FAILED,
+		                    "Server did not accept job");
+		goto error;
+	}
+	teco_client_job_pid = pid;
+
+	struct sigaction sa = {.sa_handler = teco_client_signal_handler};
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	if (!teco_server_read(fd, &code, sizeof(code))) {
+		g_set_error_literal(&error, TECO_ERROR, TECO_ERROR_FAILED,
+		                    "Connection to server lost");
+		goto error;
+	}
+
+	close(fd);
+	return code;
+
+error:
+	if (fd >= 0)
+		close(fd);
+	g_fprintf(stderr, "Client error: %s\n", error->message);
+	return EXIT_FAILURE;
+}
+
+/*
+ * Parallel batch mode (--jobs)
+ */
+
+typedef struct {
+	pid_t pid;
+	/** Pipes of the worker's stdout and stderr, -1 after EOF */
+	int fds[2];
+	/** Output not yet printed */
+	GString *output[2];
+	/** Exit code or -1 while the worker is running */
+	gint code;
+} teco_worker_t;
+
+static struct {
+	teco_worker_t *workers;
+	guint workers_len;
+	/** index of the next worker to start */
+	guint next;
+	/** index of the next worker to print the output of */
+	guint printed;
+	guint running, max_running;
+} teco_worker_pool;
+
+static void
+teco_worker_pool_close(void)
+{
+	for (guint i = teco_worker_pool.printed; i < teco_worker_pool.next; i++) {
+		teco_worker_t *worker = teco_worker_pool.workers + i;
+		for (gint j = 0; j < 2; j++) {
+			if (worker->fds[j] >= 0)
+				close(worker->fds[j]);
+			g_string_free(worker->output[j], TRUE);
+		}
+	}
+	g_free(teco_worker_pool.workers);
+	memset(&teco_worker_pool, 0, sizeof(teco_worker_pool));
+}
+
+/**
+ * Start a worker process.
+ *
+ * @param worker The worker to start.
+ * @param is_worker Set to TRUE in the worker process.
+ * @param error Where to store errors.
+ * @return FALSE on failure.
+ */
+static gboolean
+teco_worker_start(teco_worker_t *worker, gboolean *is_worker, GError **error)
+{
+	int pipes[2][2];
+
+	*is_worker = FALSE;
+
+	if (pipe(pipes[0])) {
+		g_set_error(error, TECO_ERROR, TECO_ERROR_FAILED,
+		            "Cannot create pipe: %s", g_strerror(errno));
+		return FALSE;
+	}
+	if (pipe(pipes[1])) {
+		g_set_error(error, TECO_ERROR, TECO_ERROR_FAILED,
+		            "Cannot create pipe: %s", g_strerror(errno));
+		close(pipes[0][0]);
+		close(pipes[0][1]);
+		return FALSE;
+	}
+
+	/* buffered output must not be duplicated into the worker */
+	fflush(NULL);
+
+	worker->pid = fork();
+	if (worker->pid == 0) {
+		/* worker process */
+		for (gint i = 0; i < 2; i++) {
+			dup2(pipes[i][1], 1+i);
+			close(pipes[i][0]);
+			close(pipes[i][1]);
+		}
+		/* the worker must not keep the other workers' pipes open */
+		teco_worker_pool_close();
+
+		/* workers cannot share the driver's stdin */
+		int null_fd = open("/dev/null", O_RDONLY);
+		if (null_fd >= 0) {
+			dup2(null_fd, 0);
+			close(null_fd);
+		}
+
+		*is_worker = TRUE;
+		return TRUE;
+	}
+
+	for (gint i = 0; i < 2; i++)
+		close(pipes[i][1]);
+
+	if (worker->pid < 0) {
+		g_set_error(error, TECO_ERROR, TECO_ERROR_FAILED,
+		            "Cannot fork worker: %s", g_strerror(errno));
+		for (gint i = 0; i < 2; i++)
+			close(pipes[i][0]);
+		return FALSE;
+	}
+
+	for (gint i = 0; i < 2; i++) {
+		worker->fds[i] = pipes[i][0];
+		worker->output[i] = g_string_new(NULL);
+	}
+	worker->code = -1;
+	teco_worker_pool.running++;
+
+	return TRUE;
+}
+
+/**
+ * Print the output of all workers in input order,
+ * as far as it is available.
+ *
+ * @return The exit code of the first failed worker or 0.
+ */
+static gint
+teco_worker_pool_print(void)
+{
+	gint ret = 0;
+
+	while (teco_worker_pool.printed < teco_worker_pool.next) {
+		teco_worker_t *worker = teco_worker_pool.workers + teco_worker_pool.printed;
+
+		for (gint i = 0; i < 2; i++) {
+			FILE *stream = i ? stderr : stdout;
+			fwrite(worker->output[i]->str, 1, worker->output[i]->len, stream);
+			fflush(stream);
+			g_string_truncate(worker->output[i], 0);
+		}
+
+		if (worker->code < 0)
+			break;
+
+		if (!ret)
+			ret = worker->code;
+		for (gint i = 0; i < 2; i++)
+			g_string_free(worker->output[i], TRUE);
+		teco_worker_pool.printed++;
+	}
+
+	return ret;
+}
+
+/**
+ * Execute the remaining program in parallel worker processes,
+ * once for every command line argument.
+ *
+ * The workers are forked from the already initialized process,
+ * so they share its state copy-on-write, but every argument
+ * is processed in isolation.
+ * The workers' stdout and stderr are printed in input order
+ * and stdin is redirected from /dev/null.
+ *
+ * @param max_running Maximum number of workers running at once.
+ * @param argv Command line arguments, including the program name.
+ *   In the worker process, this will be replaced with the program
+ *   name followed by the worker's argument.
+ * @param ret Where to store the exit code of the first
+ *   failed worker (in input order) or 0.
+ * @param error Where to store errors of the driver.
+ * @return TRUE in the worker processes,
+ *   FALSE in the driver process after all workers terminated.
+ *   error is only set on failures.
+ */
+gboolean
+teco_worker_pool_run(guint max_running, gchar ***argv, gint *ret, GError **error)
+{
+	*ret = 0;
+
+	teco_worker_pool.workers_len = g_strv_length(*argv);
+	if (teco_worker_pool.workers_len <= 1)
+		return FALSE;
+	teco_worker_pool.workers_len--;
+	teco_worker_pool.workers = g_new0(teco_worker_t, teco_worker_pool.workers_len);
+	teco_worker_pool.next = teco_worker_pool.printed = 0;
+	teco_worker_pool.running = 0;
+	teco_worker_pool.max_running = MAX(max_running, 1);
+
+	gboolean failed = FALSE;
+	for (;;) {
+		while (!failed && !teco_interrupted &&
+		       teco_worker_pool.next < teco_worker_pool.workers_len &&
+		       teco_worker_pool.running < teco_worker_pool.max_running) {
+			guint i = teco_worker_pool.next;
+			gboolean is_worker;
+			if (!teco_worker_start(teco_worker_pool.workers + i, &is_worker, error)) {
+				/* the running workers are still waited for */
+				failed = TRUE;
+				*ret = EXIT_FAILURE;
+				break;
+			}
+			if (is_worker) {
+				gchar **worker_argv = g_new0(gchar *, 3);
+				worker_argv[0] = g_strdup((*argv)[0]);
+				worker_argv[1] = g_strdup((*argv)[1+i]);
+				g_strfreev(*argv);
+				*argv = worker_argv;
+				return TRUE;
+			}
+			teco_worker_pool.next++;
+		}
+
+		gint code = teco_worker_pool_print();
+		if (!*ret)
+			*ret = code;
+		if (!teco_worker_pool.running)
+			break;
+
+		g_autofree struct pollfd *pfds = g_new(struct pollfd, teco_worker_pool.running*2);
+		guint pfds_len = 0;
+		for (guint i = teco_worker_pool.printed; i < teco_worker_pool.next; i++) {
+			teco_worker_t *worker = teco_worker_pool.workers + i;
+			for (gint j = 0; j < 2; j++) {
+				if (worker->fds[j] < 0)
+					continue;
+				pfds[pfds_len].fd = worker->fds[j];
+				pfds[pfds_len].events = POLLIN;
+				pfds_len++;
+			}
+		}
+
+		/*
+		 * NOTE: SIGINT is also received by the workers,
+		 * so we just keep collecting their output.
+		 */
+		if (pfds_len && poll(pfds, pfds_len, -1) <= 0)
+			continue;
+
+		for (guint i = teco_worker_pool.printed; i < teco_worker_pool.next; i++) {
+			teco_worker_t *worker = teco_worker_pool.workers + i;
+			if (worker->code >= 0)
+				continue;
+
+			for (gint j = 0; j < 2; j++) {
+				if (worker->fds[j] < 0)
+					continue;
+				struct pollfd *pfd = NULL;
+				for (guint k = 0; k < pfds_len && !pfd; k++)
+					if (pfds[k].fd == worker->fds[j])
+						pfd = pfds + k;
+				if (!pfd || !pfd->revents)
+					continue;
+
+				gchar buf[4096];
+				gssize len = read(worker->fds[j], buf, sizeof(buf));
+				if (len < 0 && errno == EINTR)
+					continue;
+				if (len > 0) {
+					g_string_append_len(worker->output[j], buf, len);
+					continue;
+				}
+				close(worker->fds[j]);
+				worker->fds[j] = -1;
+			}
+
+			if (worker->fds[0] >= 0 || worker->fds[1] >= 0)
+				continue;
+
+			/*
+			 * Both streams are closed, so the worker
+			 * should be terminating.
+			 */
+			int status;
+			while (waitpid(worker->pid, &status, 0) < 0 && errno == EINTR);
+			/* same as the shell would report */
+			worker->code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+			teco_worker_pool.running--;
+		}
+	}
+
+	teco_worker_pool_close();
+	return FALSE;
+}
+
+#endif /* TECO_SERVER */
@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2012-2025 Robin Haberkorn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <glib.h>
+
+#include "sciteco.h"
+
+/*
+ * Server jobs and --jobs workers are forked from the fully initialized
+ * process, which is not safe after the Gtk interface has been initialized.
+ */
+#if defined(G_OS_UNIX) && !defined(INTERFACE_GTK)
+#define TECO_SERVER
+
+gboolean teco_server_run(const gchar *path, gchar ***argv, GError **error);
+gint teco_client_run(const gchar *path, gchar **argv);
+
+gboolean teco_worker_pool_run(guint max_running, gchar ***argv, gint *ret, GError **error);
+
+#endif
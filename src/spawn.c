@@ -19,9 +19,11 @@
 #include "config.h"
 #endif
 
+#include <string.h>
 #include <signal.h>
 
 #include <glib.h>
+#include <glib/gstdio.h>
 
 #include <gmodule.h>
 
@@ -43,6 +45,7 @@
 #include "ring.h"
 #include "parser.h"
 #include "memory.h"
+#include "stats.h"
 #include "core-commands.h"
 #include "qreg-commands.h"
 #include "error.h"
@@ -168,6 +171,54 @@ teco_parse_shell_command_line(const gchar *cmdline, GError **error)
 	return g_shell_parse_argv(cmdline, NULL, &argv, error) ? argv : NULL;
 }
 
+#ifdef G_OS_WIN32
+
+/**
+ * Create a Job Object for the given process.
+ *
+ * Assigning the process to a job object will allow us to
+ * kill the entire process tree relatively easily and without
+ * race conditions.
+ *
+ * @return The job object handle or NULL in case of errors.
+ */
+static GPid
+teco_spawn_create_job(GPid pid, GError **error)
+{
+	GPid job = CreateJobObject(NULL, NULL);
+	if (!job) {
+		teco_error_win32_set(error, "Cannot create job object", GetLastError());
+		return NULL;
+	}
+	JOBOBJECT_EXTENDED_LIMIT_INFORMATION job_info = {
+		.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE
+	};
+	if (!SetInformationJobObject(job, JobObjectExtendedLimitInformation,
+	                             &job_info, sizeof(job_info))) {
+		CloseHandle(job);
+		teco_error_win32_set(error, "Cannot configure job object", GetLastError());
+		return NULL;
+	}
+	/*
+	 * There can be a race condition while assigning the
+	 * job object since the process could already be dead.
+	 */
+	DWORD exit_code;
+	if (!AssignProcessToJobObject(job, pid) &&
+	    (GetLastError() != ERROR_ACCESS_DENIED ||
+	     !GetExitCodeProcess(pid, &exit_code) ||
+	     exit_code == STILL_ACTIVE)) {
+		CloseHandle(job);
+		teco_error_win32_set(error, "Cannot assign process to job object",
+		                     GetLastError());
+		return NULL;
+	}
+
+	return job;
+}
+
+#endif
+
 static gboolean
 teco_state_execute_initial(teco_machine_main_t *ctx, GError **error)
 {
@@ -305,6 +356,7 @@ teco_state_execute_done(teco_machine_main_t *ctx, const teco_string_t *str, GErr
 	if (!g_spawn_async_with_pipes(NULL, argv, envp, flags, NULL, NULL, &pid,
 	                              &stdin_fd, &stdout_fd, NULL, error))
 		goto gerror;
+	teco_stats_inc(TECO_STATS_SPAWNED);
 
 	/*
 	 * FIXME: At least on Win32, we cannot resume a main loop
@@ -330,37 +382,9 @@ teco_state_execute_done(teco_machine_main_t *ctx, const teco_string_t *str, GErr
 	/*
 	 * FIXME: In case of errors, we will leak memory.
 	 */
-	teco_spawn_ctx.pid = CreateJobObject(NULL, NULL);
-	if (!teco_spawn_ctx.pid) {
-		teco_error_win32_set(error, "Cannot create job object", GetLastError());
-		goto gerror;
-	}
-	JOBOBJECT_EXTENDED_LIMIT_INFORMATION job_info = {
-		.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE
-	};
-	if (!SetInformationJobObject(teco_spawn_ctx.pid, JobObjectExtendedLimitInformation,
-	                             &job_info, sizeof(job_info))) {
-		CloseHandle(teco_spawn_ctx.pid);
-		teco_error_win32_set(error, "Cannot configure job object", GetLastError());
-		goto gerror;
-	}
-	/*
-	 * Assigning the process to a job object will allow us to
-	 * kill the entire process tree relatively easily and without
-	 * race conditions.
-	 * There can however be a race condition while assigning the
-	 * job object since the process could already be dead.
-	 */
-	DWORD exit_code;
-	if (!AssignProcessToJobObject(teco_spawn_ctx.pid, pid) &&
-	    (GetLastError() != ERROR_ACCESS_DENIED ||
-	     !GetExitCodeProcess(teco_spawn_ctx.pid, &exit_code) ||
-	     exit_code == STILL_ACTIVE)) {
-		CloseHandle(teco_spawn_ctx.pid);
-		teco_error_win32_set(error, "Cannot assign process to job object",
-		                     GetLastError());
+	teco_spawn_ctx.pid = teco_spawn_create_job(pid, error);
+	if (!teco_spawn_ctx.pid)
 		goto gerror;
-	}
 
 	stdin_chan = g_io_channel_win32_new_fd(stdin_fd);
 	stdout_chan = g_io_channel_win32_new_fd(stdout_fd);
@@ -386,8 +410,10 @@ teco_state_execute_done(teco_machine_main_t *ctx, const teco_string_t *str, GErr
 	 * We always read from the current view,
 	 * so we use its EOL mode.
 	 */
-	teco_eol_writer_init_gio(&teco_spawn_ctx.stdin_writer, teco_interface_ssm(SCI_GETEOLMODE, 0, 0), stdin_chan);
-	teco_eol_reader_init_gio(&teco_spawn_ctx.stdout_reader, stdout_chan);
+	gboolean autoeol = teco_ed & TECO_ED_AUTOEOL ? TRUE : FALSE;
+	teco_eol_writer_init_gio(&teco_spawn_ctx.stdin_writer, teco_interface_ssm(SCI_GETEOLMODE, 0, 0),
+	                         autoeol, stdin_chan);
+	teco_eol_reader_init_gio(&teco_spawn_ctx.stdout_reader, autoeol, stdout_chan);
 
 	teco_spawn_ctx.stdin_src = g_io_create_watch(stdin_chan,
 	                                             G_IO_OUT | G_IO_ERR | G_IO_HUP);
@@ -881,6 +907,588 @@ teco_spawn_idle_cb(gpointer user_data)
 	return G_SOURCE_CONTINUE;
 }
 
+/*
+ * Parallel filtering of ring buffers (EP).
+ *
+ * Every buffer is assigned a job, but only a limited number of
+ * processes are running at any given time.
+ * Process output is collected into memory and applied to the
+ * buffers strictly in ring order as soon as all preceding jobs
+ * have been applied.
+ */
+
+typedef struct {
+	teco_buffer_t *buffer;
+
+	/** Process ID or Job Object handle on Windows */
+	GPid pid;
+	/** Process ID as returned by g_spawn_async_with_pipes() */
+	GPid child_pid;
+	GSource *child_src;
+	GSource *stdin_src, *stdout_src;
+	GIOChannel *stdin_chan, *stdout_chan;
+
+	gboolean running;
+	/** job has terminated (successfully or not) */
+	gboolean done;
+
+	gsize start, to;
+
+	teco_eol_writer_t stdin_writer;
+	teco_eol_reader_t stdout_reader;
+	GString *output;
+
+	GError *error;
+	teco_bool_t rc;
+} teco_spawn_job_t;
+
+static void teco_spawn_job_child_watch_cb(GPid pid, gint status, gpointer data);
+static gboolean teco_spawn_job_read(teco_spawn_job_t *job, gboolean read_to_eof);
+static gboolean teco_spawn_job_stdin_watch_cb(GIOChannel *chan,
+                                              GIOCondition condition, gpointer data);
+static gboolean teco_spawn_job_stdout_watch_cb(GIOChannel *chan,
+                                               GIOCondition condition, gpointer data);
+
+static struct {
+	GMainContext *mainctx;
+	GMainLoop *mainloop;
+	gboolean interrupted;
+
+	gchar **argv, **envp;
+
+	teco_spawn_job_t *jobs;
+	guint jobs_len;
+	/** index of the next job to spawn */
+	guint next;
+	/** index of the next job to apply */
+	guint applied;
+	guint running, max_running;
+
+	/** first error encountered, stops spawning new jobs */
+	GError *error;
+	teco_bool_t rc;
+} teco_spawn_pool;
+
+static gboolean
+teco_spawn_job_start(teco_spawn_job_t *job, GError **error)
+{
+	/* see teco_state_execute_done() */
+	static const GSpawnFlags flags = G_SPAWN_DO_NOT_REAP_CHILD | G_SPAWN_SEARCH_PATH |
+#ifdef G_OS_UNIX
+	                                 G_SPAWN_LEAVE_DESCRIPTORS_OPEN |
+#endif
+	                                 G_SPAWN_STDERR_TO_DEV_NULL;
+
+	gint stdin_fd, stdout_fd;
+
+	if (!g_spawn_async_with_pipes(NULL, teco_spawn_pool.argv, teco_spawn_pool.envp, flags,
+	                              NULL, NULL, &job->child_pid,
+	                              &stdin_fd, &stdout_fd, NULL, error))
+		return FALSE;
+	teco_stats_inc(TECO_STATS_SPAWNED);
+
+#ifdef G_OS_WIN32
+	job->pid = teco_spawn_create_job(job->child_pid, error);
+	if (!job->pid) {
+		TerminateProcess(job->child_pid, 1);
+		g_spawn_close_pid(job->child_pid);
+		g_close(stdin_fd, NULL);
+		g_close(stdout_fd, NULL);
+		return FALSE;
+	}
+
+	job->stdin_chan = g_io_channel_win32_new_fd(stdin_fd);
+	job->stdout_chan = g_io_channel_win32_new_fd(stdout_fd);
+#else
+	job->pid = job->child_pid;
+
+	job->stdin_chan = g_io_channel_unix_new(stdin_fd);
+	job->stdout_chan = g_io_channel_unix_new(stdout_fd);
+#endif
+	g_io_channel_set_flags(job->stdin_chan, G_IO_FLAG_NONBLOCK, NULL);
+	g_io_channel_set_encoding(job->stdin_chan, NULL, NULL);
+	g_io_channel_set_buffered(job->stdin_chan, TRUE);
+	g_io_channel_set_flags(job->stdout_chan, G_IO_FLAG_NONBLOCK, NULL);
+	g_io_channel_set_encoding(job->stdout_chan, NULL, NULL);
+	g_io_channel_set_buffered(job->stdout_chan, FALSE);
+
+	gboolean autoeol = teco_ed & TECO_ED_AUTOEOL ? TRUE : FALSE;
+	teco_eol_writer_init_gio(&job->stdin_writer,
+	                         teco_view_ssm(job->buffer->view, SCI_GETEOLMODE, 0, 0),
+	                         autoeol, job->stdin_chan);
+	teco_eol_reader_init_gio(&job->stdout_reader, autoeol, job->stdout_chan);
+	job->output = g_string_new(NULL);
+
+	job->child_src = g_child_watch_source_new(job->child_pid);
+	g_source_set_callback(job->child_src, (GSourceFunc)teco_spawn_job_child_watch_cb,
+	                      job, NULL);
+	g_source_attach(job->child_src, teco_spawn_pool.mainctx);
+
+	job->stdin_src = g_io_create_watch(job->stdin_chan, G_IO_OUT | G_IO_ERR | G_IO_HUP);
+	g_source_set_callback(job->stdin_src, (GSourceFunc)teco_spawn_job_stdin_watch_cb,
+	                      job, NULL);
+	g_source_attach(job->stdin_src, teco_spawn_pool.mainctx);
+
+	job->stdout_src = g_io_create_watch(job->stdout_chan, G_IO_IN | G_IO_ERR | G_IO_HUP);
+	g_source_set_callback(job->stdout_src, (GSourceFunc)teco_spawn_job_stdout_watch_cb,
+	                      job, NULL);
+	g_source_attach(job->stdout_src, teco_spawn_pool.mainctx);
+
+	job->running = TRUE;
+	teco_spawn_pool.running++;
+	return TRUE;
+}
+
+/**
+ * Release all resources of a terminated job except for its output.
+ */
+static void
+teco_spawn_job_finish(teco_spawn_job_t *job)
+{
+	job->running = FALSE;
+	job->done = TRUE;
+	teco_spawn_pool.running--;
+
+	/*
+	 * Other jobs may still be running, so the watches must
+	 * not be dispatched anymore.
+	 */
+	if (!g_source_is_destroyed(job->stdin_src)) {
+		g_source_destroy(job->stdin_src);
+		g_io_channel_shutdown(job->stdin_chan, FALSE, NULL);
+	}
+	g_source_unref(job->stdin_src);
+	g_source_destroy(job->stdout_src);
+	g_source_unref(job->stdout_src);
+	g_source_unref(job->child_src);
+
+	teco_eol_writer_clear(&job->stdin_writer);
+	teco_eol_reader_clear(&job->stdout_reader);
+	g_io_channel_unref(job->stdin_chan);
+	g_io_channel_shutdown(job->stdout_chan, FALSE, NULL);
+	g_io_channel_unref(job->stdout_chan);
+
+	g_spawn_close_pid(job->child_pid);
+#ifdef G_OS_WIN32
+	CloseHandle(job->pid);
+#endif
+}
+
+/**
+ * Replace the buffer's contents with the process output.
+ *
+ * This is a single Scintilla undo action per buffer.
+ * Buffers whose contents did not change are not modified
+ * and do not become dirty.
+ */
+static void
+teco_spawn_job_apply(teco_spawn_job_t *job)
+{
+	teco_view_t *view = job->buffer->view;
+	sptr_t len = teco_view_ssm(view, SCI_GETLENGTH, 0, 0);
+
+	if (job->output->len == len) {
+		/* compare without moving the gap */
+		sptr_t gap = teco_view_ssm(view, SCI_GETGAPPOSITION, 0, 0);
+		const gchar *first = (const gchar *)teco_view_ssm(view, SCI_GETRANGEPOINTER, 0, gap);
+		const gchar *second = (const gchar *)teco_view_ssm(view, SCI_GETRANGEPOINTER, gap, len-gap);
+		if (!memcmp(job->output->str, first, gap) &&
+		    !memcmp(job->output->str+gap, second, len-gap))
+			return;
+	}
+
+	sptr_t pos = teco_view_ssm(view, SCI_GETCURRENTPOS, 0, 0);
+	undo__teco_view_ssm(view, SCI_GOTOPOS, pos, 0);
+
+	teco_view_ssm(view, SCI_BEGINUNDOACTION, 0, 0);
+	teco_view_ssm(view, SCI_SETTARGETRANGE, 0, len);
+	teco_view_ssm(view, SCI_REPLACETARGET, job->output->len, (sptr_t)job->output->str);
+	teco_view_ssm(view, SCI_ENDUNDOACTION, 0, 0);
+	teco_view_ssm(view, SCI_GOTOPOS, MIN(pos, job->output->len), 0);
+	undo__teco_view_ssm(view, SCI_UNDO, 0, 0);
+
+	teco_buffer_dirtify(job->buffer);
+}
+
+/**
+ * Apply all terminated jobs in order and spawn new ones
+ * until the concurrency limit is reached.
+ */
+static void
+teco_spawn_pool_update(void)
+{
+	while (teco_spawn_pool.applied < teco_spawn_pool.next) {
+		teco_spawn_job_t *job = teco_spawn_pool.jobs + teco_spawn_pool.applied;
+		if (!job->done || job->error)
+			break;
+		teco_spawn_job_apply(job);
+		g_string_free(job->output, TRUE);
+		job->output = NULL;
+		teco_spawn_pool.applied++;
+	}
+
+	while (!teco_spawn_pool.error && !teco_spawn_pool.interrupted &&
+	       teco_spawn_pool.next < teco_spawn_pool.jobs_len &&
+	       teco_spawn_pool.running < teco_spawn_pool.max_running) {
+		teco_spawn_job_t *job = teco_spawn_pool.jobs + teco_spawn_pool.next;
+		if (!teco_spawn_job_start(job, &teco_spawn_pool.error)) {
+			teco_spawn_pool.rc = TECO_FAILURE;
+			break;
+		}
+		teco_spawn_pool.next++;
+	}
+
+	if (!teco_spawn_pool.running)
+		g_main_loop_quit(teco_spawn_pool.mainloop);
+}
+
+static void
+teco_spawn_pool_terminate(gboolean hard)
+{
+	for (guint i = teco_spawn_pool.applied; i < teco_spawn_pool.next; i++) {
+		teco_spawn_job_t *job = teco_spawn_pool.jobs + i;
+		if (!job->running)
+			continue;
+		if (hard)
+			teco_spawn_terminate_hard(job->pid);
+		else
+			teco_spawn_terminate_soft(job->pid);
+	}
+}
+
+static gboolean
+teco_spawn_pool_idle_cb(gpointer user_data)
+{
+	if (G_LIKELY(!teco_interface_is_interrupted()))
+		return G_SOURCE_CONTINUE;
+	teco_interrupted = FALSE;
+
+	/*
+	 * The first CTRL+C will try to gracefully terminate the processes.
+	 */
+	teco_spawn_pool_terminate(teco_spawn_pool.interrupted);
+	teco_spawn_pool.interrupted = TRUE;
+
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+teco_state_pipe_buffers_initial(teco_machine_main_t *ctx, GError **error)
+{
+	if (ctx->flags.mode > TECO_MODE_NORMAL)
+		return TRUE;
+
+	teco_machine_stringbuilding_set_codepage(&ctx->expectstring.machine,
+	                                         teco_default_codepage());
+
+	if (!teco_expressions_eval(FALSE, error))
+		return FALSE;
+
+	teco_int_t max_running;
+	if (!teco_expressions_pop_num_calc(&max_running, g_get_num_processors(), error))
+		return FALSE;
+	if (max_running <= 0) {
+		teco_error_range_set(error, "EP");
+		return FALSE;
+	}
+	teco_spawn_pool.max_running = MIN(max_running, G_MAXUINT);
+
+	return TRUE;
+}
+
+static teco_state_t *
+teco_state_pipe_buffers_done(teco_machine_main_t *ctx, const teco_string_t *str, GError **error)
+{
+	if (ctx->flags.mode > TECO_MODE_NORMAL)
+		return &teco_state_start;
+
+	teco_spawn_pool.rc = TECO_FAILURE;
+
+	g_auto(GStrv) argv = NULL, envp = NULL;
+
+#ifdef HAVE_CAP_GETMODE
+	u_int sandbox_mode;
+	if (G_UNLIKELY(cap_getmode(&sandbox_mode) || sandbox_mode)) {
+		g_set_error(error, TECO_ERROR, TECO_ERROR_FAILED,
+		            "Forbidden in Capsicum sandbox");
+		goto gerror;
+	}
+#endif
+
+	if (!str->len || teco_string_contains(str, '\0')) {
+		g_set_error(error, TECO_ERROR, TECO_ERROR_FAILED,
+		            "Command line must not be empty or contain null-bytes");
+		goto gerror;
+	}
+
+	argv = teco_parse_shell_command_line(str->data, error);
+	if (!argv)
+		goto gerror;
+	envp = teco_qreg_table_get_environ(&teco_qreg_table_globals, error);
+	if (!envp)
+		goto gerror;
+	teco_spawn_pool.argv = argv;
+	teco_spawn_pool.envp = envp;
+
+	teco_spawn_pool.jobs_len = 0;
+	for (teco_buffer_t *cur = teco_ring_first(); cur; cur = teco_buffer_next(cur)) {
+		if (!teco_buffer_materialize(cur, error))
+			goto gerror;
+		teco_spawn_pool.jobs_len++;
+	}
+	teco_spawn_pool.jobs = g_new0(teco_spawn_job_t, teco_spawn_pool.jobs_len);
+
+	teco_spawn_job_t *job = teco_spawn_pool.jobs;
+	GSource *idle_src;
+	for (teco_buffer_t *cur = teco_ring_first(); cur; cur = teco_buffer_next(cur)) {
+		job->buffer = cur;
+		job->to = teco_view_ssm(cur->view, SCI_GETLENGTH, 0, 0);
+		job->rc = TECO_FAILURE;
+		job++;
+	}
+
+	teco_spawn_pool.next = teco_spawn_pool.applied = 0;
+	teco_spawn_pool.running = 0;
+	teco_spawn_pool.interrupted = FALSE;
+
+	/* see teco_state_execute_done() */
+	teco_spawn_pool.mainctx = g_main_context_new();
+	teco_spawn_pool.mainloop = g_main_loop_new(teco_spawn_pool.mainctx, FALSE);
+
+	idle_src = g_idle_source_new();
+	g_source_set_priority(idle_src, G_PRIORITY_LOW);
+	g_source_set_callback(idle_src, (GSourceFunc)teco_spawn_pool_idle_cb, NULL, NULL);
+	g_source_attach(idle_src, teco_spawn_pool.mainctx);
+
+	teco_spawn_pool_update();
+	if (teco_spawn_pool.running)
+		g_main_loop_run(teco_spawn_pool.mainloop);
+	g_assert(!teco_spawn_pool.running);
+
+	for (guint i = 0; i < teco_spawn_pool.jobs_len; i++) {
+		job = teco_spawn_pool.jobs + i;
+		if (job->output)
+			g_string_free(job->output, TRUE);
+		g_clear_error(&job->error);
+	}
+	g_free(teco_spawn_pool.jobs);
+	teco_spawn_pool.jobs = NULL;
+	teco_spawn_pool.argv = teco_spawn_pool.envp = NULL;
+
+	g_source_destroy(idle_src);
+	g_source_unref(idle_src);
+	g_main_loop_unref(teco_spawn_pool.mainloop);
+	g_main_context_unref(teco_spawn_pool.mainctx);
+
+	if (!teco_spawn_pool.error && teco_spawn_pool.interrupted)
+		teco_error_interrupted_set(&teco_spawn_pool.error);
+
+	if (teco_spawn_pool.error) {
+		g_propagate_error(error, teco_spawn_pool.error);
+		teco_spawn_pool.error = NULL;
+		goto gerror;
+	}
+
+	if (teco_machine_main_eval_colon(ctx) > 0)
+		teco_expressions_push(TECO_SUCCESS);
+	return &teco_state_start;
+
+gerror:
+	/* `error` has been set */
+	if (!teco_machine_main_eval_colon(ctx))
+		return NULL;
+	g_clear_error(error);
+
+	/* May contain the exit status encoded as a teco_bool_t. */
+	teco_expressions_push(teco_spawn_pool.rc);
+	return &teco_state_start;
+}
+
+/*$ "EP" ":EP" "pipe buffers" "parallel filter"
+ * EPcommand$ -- Filter all buffers through operating system command in parallel
+ * nEPcommand$
+ * :EPcommand$ -> Success|Failure
+ * n:EPcommand$ -> Success|Failure
+ *
+ * Runs <command> as a filter over the entire contents of
+ * every buffer in the ring.
+ * This is similar to executing \(lqHECcommand$\(rq on every
+ * buffer, but up to <n> processes are executed concurrently.
+ * <n> defaults to the number of available processors.
+ * Setting <n> to 1 effectively runs all processes sequentially.
+ *
+ * The output of the processes is collected and replaces
+ * the contents of the buffers strictly in ring order,
+ * regardless of the order in which the processes terminate.
+ * The replacement of every buffer is a separate undoable
+ * operation.
+ * Buffers whose contents did not change are not modified
+ * and will not be marked dirty, so this can be used to
+ * efficiently run a code formatter over a large number
+ * of files and saving only the changed ones, e.g. with
+ * \(lq:EX\(rq.
+ * Dot is left unchanged in all buffers, unless it would lie
+ * beyond the end of the new buffer contents.
+ * The current buffer is not changed.
+ *
+ * <command> is executed exactly as with the \fBEC\fP command,
+ * including end of line translations.
+ * Process execution errors and unsuccessful exit codes
+ * are also handled just like with \fBEC\fP:
+ * If any process fails, no more processes are started
+ * and the remaining buffers are left unchanged.
+ * Buffers preceding the failed one in the ring may still
+ * have been modified.
+ * If colon-modified, the exit code of the failed process
+ * is returned instead.
+ *
+ * In interactive mode, \*(ST performs TAB-completion
+ * of filenames in the <command> string parameter.
+ */
+TECO_DEFINE_STATE_EXPECTSTRING(teco_state_pipe_buffers,
+	.initial_cb = (teco_state_initial_cb_t)teco_state_pipe_buffers_initial,
+	.process_edit_cmd_cb = (teco_state_process_edit_cmd_cb_t)teco_state_execute_process_edit_cmd
+);
+
+static void
+teco_spawn_job_fail(teco_spawn_job_t *job)
+{
+	/* will eventually trigger teco_spawn_job_child_watch_cb() */
+	teco_spawn_terminate_hard(job->pid);
+}
+
+static void
+teco_spawn_job_child_watch_cb(GPid pid, gint status, gpointer data)
+{
+	teco_spawn_job_t *job = data;
+
+	/*
+	 * There might still be data to read from stdout.
+	 * See teco_spawn_child_watch_cb().
+	 */
+#ifdef G_OS_WIN32
+	if (!teco_spawn_pool.interrupted) {
+		g_io_channel_set_flags(job->stdout_chan, 0, NULL);
+		teco_spawn_job_read(job, TRUE);
+	}
+#else
+	teco_spawn_job_read(job, FALSE);
+#endif
+
+	if (!job->error) {
+		if (teco_spawn_check_wait_status(status, &job->error))
+			job->rc = TECO_SUCCESS;
+		else
+			job->rc = job->error->domain == G_SPAWN_EXIT_ERROR
+					? ABS(job->error->code) : TECO_FAILURE;
+	}
+
+	teco_spawn_job_finish(job);
+
+	if (job->error && !teco_spawn_pool.error) {
+		if (job->buffer->filename)
+			g_prefix_error(&job->error, "Error filtering \"%s\": ",
+			               job->buffer->filename);
+		else
+			g_prefix_error(&job->error, "Error filtering unnamed buffer: ");
+		/* job->error must be kept, so the job is never applied */
+		teco_spawn_pool.error = g_error_copy(job->error);
+		teco_spawn_pool.rc = job->rc;
+
+		/* no need to wait for the remaining processes */
+		teco_spawn_pool_terminate(TRUE);
+	}
+
+	teco_spawn_pool_update();
+}
+
+static gboolean
+teco_spawn_job_stdin_watch_cb(GIOChannel *chan, GIOCondition condition, gpointer data)
+{
+	teco_spawn_job_t *job = data;
+
+	if (!(condition & G_IO_OUT))
+		/* stdin might be closed prematurely */
+		goto remove;
+
+	teco_view_t *view = job->buffer->view;
+	sptr_t gap = teco_view_ssm(view, SCI_GETGAPPOSITION, 0, 0);
+	gsize convert_len = job->start < gap && gap < job->to
+				? gap - job->start : job->to - job->start;
+	const gchar *buffer = (const gchar *)teco_view_ssm(view, SCI_GETRANGEPOINTER,
+	                                                   job->start, convert_len);
+
+	gssize bytes_written = teco_eol_writer_convert(&job->stdin_writer, buffer,
+	                                               convert_len, &job->error);
+	if (bytes_written < 0) {
+		teco_spawn_job_fail(job);
+		goto remove;
+	}
+
+	job->start += bytes_written;
+
+	if (job->start == job->to)
+		/* this will signal EOF to the process */
+		goto remove;
+
+	return G_SOURCE_CONTINUE;
+
+remove:
+	/* the channel is shut down IF the GSource has been destroyed */
+	g_io_channel_shutdown(chan, TRUE, NULL);
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * Read process output into memory.
+ *
+ * @param job The job to read output from.
+ * @param read_to_eof Whether to continue reading after
+ *   reading 0 bytes. See teco_spawn_stdout_watch_cb().
+ * @return FALSE if the watch should be removed.
+ */
+static gboolean
+teco_spawn_job_read(teco_spawn_job_t *job, gboolean read_to_eof)
+{
+	if (job->error)
+		return FALSE;
+
+	for (;;) {
+		teco_string_t buffer;
+
+		switch (teco_eol_reader_convert(&job->stdout_reader,
+		                                &buffer.data, &buffer.len, &job->error)) {
+		case G_IO_STATUS_ERROR:
+			goto error;
+		case G_IO_STATUS_EOF:
+			return FALSE;
+		default:
+			break;
+		}
+
+		if (!read_to_eof && !buffer.len)
+			return TRUE;
+
+		g_string_append_len(job->output, buffer.data, buffer.len);
+
+		/* see teco_spawn_stdout_watch_cb() */
+		if (!teco_memory_check(0, &job->error))
+			goto error;
+	}
+
+	g_assert_not_reached();
+
+error:
+	teco_spawn_job_fail(job);
+	return FALSE;
+}
+
+static gboolean
+teco_spawn_job_stdout_watch_cb(GIOChannel *chan, GIOCondition condition, gpointer data)
+{
+	return teco_spawn_job_read(data, FALSE) ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
 static void TECO_DEBUG_CLEANUP
 teco_spawn_cleanup(void)
 {
@@ -894,4 +1502,6 @@ teco_spawn_cleanup(void)
 
 	if (teco_spawn_ctx.error)
 		g_error_free(teco_spawn_ctx.error);
+	if (teco_spawn_pool.error)
+		g_error_free(teco_spawn_pool.error);
 }
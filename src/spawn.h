@@ -20,3 +20,4 @@
 
 TECO_DECLARE_STATE(teco_state_execute);
 TECO_DECLARE_STATE(teco_state_egcommand);
+TECO_DECLARE_STATE(teco_state_pipe_buffers);
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2012-2025 Robin Haberkorn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gprintf.h>
+
+#include "sciteco.h"
+#include "symbols.h"
+#include "stats.h"
+
+gsize teco_stats_counters[TECO_STATS_COUNTERS];
+gsize teco_stats_messages[TECO_STATS_MESSAGES_MAX];
+
+void
+teco_stats_reset(void)
+{
+	for (guint i = 0; i < TECO_STATS_COUNTERS; i++)
+		teco_stats_set(i, 0);
+	memset(teco_stats_messages, 0, sizeof(teco_stats_messages));
+}
+
+static const gchar *
+teco_stats_message_name(unsigned int iMessage)
+{
+	const teco_symbol_list_t *list = &teco_symbol_list_scintilla;
+
+	for (gint i = 0; i < list->size; i++)
+		if (list->entries[i].value == iMessage &&
+		    g_str_has_prefix(list->entries[i].name, "SCI_"))
+			return list->entries[i].name;
+
+	return NULL;
+}
+
+static gint
+teco_stats_cmp_messages(gconstpointer a, gconstpointer b)
+{
+	gsize count_a = teco_stats_messages[*(const guint *)a];
+	gsize count_b = teco_stats_messages[*(const guint *)b];
+
+	return count_a < count_b ? 1 : count_a > count_b ? -1 : 0;
+}
+
+/**
+ * Print all counters to stderr (see --stats).
+ *
+ * Only the most frequent Scintilla messages are listed individually.
+ */
+void
+teco_stats_print(void)
+{
+	static const gchar *const names[TECO_STATS_COUNTERS] = {
+		[TECO_STATS_CHARS]		= "characters executed",
+		[TECO_STATS_TRANSITIONS]	= "state transitions",
+		[TECO_STATS_UNDO_PUSHED]	= "undo tokens pushed",
+		[TECO_STATS_UNDO_POPPED]	= "undo tokens popped",
+		[TECO_STATS_REGEX_COMPILED]	= "regular expressions compiled",
+		[TECO_STATS_REGEX_MATCHED]	= "regular expression matches",
+		[TECO_STATS_MESSAGES]		= "Scintilla messages",
+		[TECO_STATS_DOC_EDITS]		= "document switches",
+		[TECO_STATS_EOL_READ]		= "bytes read by EOL readers",
+		[TECO_STATS_EOL_WRITTEN]	= "bytes written by EOL writers",
+		[TECO_STATS_SPAWNED]		= "processes spawned"
+	};
+
+	g_fprintf(stderr, "Statistics:\n");
+	for (guint i = 0; i < TECO_STATS_COUNTERS; i++)
+		g_fprintf(stderr, "%12" G_GSIZE_FORMAT "  %s\n",
+		          teco_stats_get(i), names[i]);
+
+	guint ids[TECO_STATS_MESSAGES_MAX];
+	guint len = 0;
+	for (guint i = 0; i < TECO_STATS_MESSAGES_MAX; i++)
+		if (teco_stats_messages[i])
+			ids[len++] = i;
+	qsort(ids, len, sizeof(*ids), teco_stats_cmp_messages);
+
+	for (guint i = 0; i < MIN(len, 10); i++) {
+		const gchar *name = teco_stats_message_name(ids[i]);
+		if (name)
+			g_fprintf(stderr, "%12" G_GSIZE_FORMAT "    %s\n",
+			          teco_stats_messages[ids[i]], name);
+		else
+			g_fprintf(stderr, "%12" G_GSIZE_FORMAT "    message %u\n",
+			          teco_stats_messages[ids[i]], ids[i]);
+	}
+}
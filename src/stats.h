@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2012-2025 Robin Haberkorn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <glib.h>
+
+#include "sciteco.h"
+
+/**
+ * Always-on counters of hot code paths.
+ *
+ * They can be queried via EJ and are dumped on exit with --stats.
+ * The order corresponds to the EJ property keys.
+ */
+typedef enum {
+	/** characters executed by teco_machine_main_step() */
+	TECO_STATS_CHARS = 0,
+	/** state transitions in teco_machine_input() */
+	TECO_STATS_TRANSITIONS,
+	TECO_STATS_UNDO_PUSHED,
+	TECO_STATS_UNDO_POPPED,
+	/** regular expressions compiled for searches */
+	TECO_STATS_REGEX_COMPILED,
+	/** regular expression matches attempted by searches */
+	TECO_STATS_REGEX_MATCHED,
+	/** Scintilla messages sent via teco_view_ssm() */
+	TECO_STATS_MESSAGES,
+	/** document switches in teco_doc_edit() */
+	TECO_STATS_DOC_EDITS,
+	/** bytes read by EOL readers (updated atomically) */
+	TECO_STATS_EOL_READ,
+	/** bytes written by EOL writers (updated atomically) */
+	TECO_STATS_EOL_WRITTEN,
+	/** processes spawned */
+	TECO_STATS_SPAWNED,
+	TECO_STATS_COUNTERS
+} teco_stats_counter_t;
+
+/** Scintilla messages are counted individually up to this id */
+#define TECO_STATS_MESSAGES_MAX 5000
+
+extern gsize teco_stats_counters[TECO_STATS_COUNTERS];
+extern gsize teco_stats_messages[TECO_STATS_MESSAGES_MAX];
+
+static inline void
+teco_stats_inc(teco_stats_counter_t counter)
+{
+	teco_stats_counters[counter]++;
+}
+
+/**
+ * Count bytes in code that may also run in worker threads.
+ *
+ * Counters updated this way must only be accessed via
+ * teco_stats_get() and teco_stats_set().
+ */
+static inline void
+teco_stats_add_atomic(teco_stats_counter_t counter, gsize n)
+{
+	g_atomic_pointer_add(&teco_stats_counters[counter], n);
+}
+
+/** Get a counter, which may be concurrently updated by worker threads. */
+static inline gsize
+teco_stats_get(teco_stats_counter_t counter)
+{
+	return (gsize)g_atomic_pointer_get(&teco_stats_counters[counter]);
+}
+
+/** Set a counter, which may be concurrently updated by worker threads. */
+static inline void
+teco_stats_set(teco_stats_counter_t counter, gsize value)
+{
+	g_atomic_pointer_set(&teco_stats_counters[counter], value);
+}
+
+static inline void
+teco_stats_inc_message(unsigned int iMessage)
+{
+	teco_stats_counters[TECO_STATS_MESSAGES]++;
+	if (G_LIKELY(iMessage < TECO_STATS_MESSAGES_MAX))
+		teco_stats_messages[iMessage]++;
+}
+
+void teco_stats_reset(void);
+void teco_stats_print(void);
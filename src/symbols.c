@@ -38,6 +38,7 @@
 #include "undo.h"
 #include "expressions.h"
 #include "interface.h"
+#include "image.h"
 #include "symbols.h"
 
 teco_symbol_list_t teco_symbol_list_scintilla = {NULL, 0};
@@ -156,7 +157,7 @@ teco_symbol_list_auto_complete(teco_symbol_list_t *ctx, const gchar *symbol, tec
 			                         strlen(entry->data), FALSE);
 		}
 
-		teco_interface_popup_show(symbol_len);
+		teco_interface_popup_show(symbol_len, FALSE);
 	}
 
 	return glist_len == 1;
@@ -172,15 +173,9 @@ teco_symbol_list_auto_complete(teco_symbol_list_t *ctx, const gchar *symbol, tec
 TECO_DECLARE_STATE(teco_state_scintilla_lparam);
 
 static gboolean
-teco_scintilla_parse_symbols(teco_machine_scintilla_t *scintilla, const teco_string_t *str, GError **error)
+teco_scintilla_lookup_symbols(teco_machine_scintilla_t *scintilla, const gchar *str, GError **error)
 {
-	if (teco_string_contains(str, '\0')) {
-		g_set_error_literal(error, TECO_ERROR, TECO_ERROR_FAILED,
-		                    "Scintilla symbol names must not contain null-byte");
-		return FALSE;
-	}
-
-	g_auto(GStrv) symbols = g_strsplit(str->data, ",", -1);
+	g_auto(GStrv) symbols = g_strsplit(str, ",", -1);
 
 	if (!symbols[0])
 		return TRUE;
@@ -211,6 +206,68 @@ teco_scintilla_parse_symbols(teco_machine_scintilla_t *scintilla, const teco_str
 	return TRUE;
 }
 
+/**
+ * Cache of successfully parsed symbol strings.
+ *
+ * Library macros tend to send the same symbolic messages over and over
+ * again (e.g. in loops), so this avoids splitting the string and
+ * looking up every symbol on every invocation.
+ * The cache is simply flushed when growing too large, since
+ * symbol strings may also be generated dynamically.
+ */
+static GHashTable *teco_scintilla_symbols_cache = NULL;
+
+#define TECO_SCINTILLA_SYMBOLS_CACHE_MAX 1024
+
+/**
+ * Parse symbolic message and wParam.
+ *
+ * @param scintilla Where to store the message and wParam.
+ *   Must be initialized with zeroes, since the cache
+ *   stores the result as a whole.
+ * @param str The symbol string, e.g. "SETFIRSTVISIBLELINE" or "STYLESETFORE,SCE_C_DEFAULT".
+ * @param error A GError.
+ * @return FALSE in case of a GError.
+ */
+static gboolean
+teco_scintilla_parse_symbols(teco_machine_scintilla_t *scintilla, const teco_string_t *str, GError **error)
+{
+	if (teco_string_contains(str, '\0')) {
+		g_set_error_literal(error, TECO_ERROR, TECO_ERROR_FAILED,
+		                    "Scintilla symbol names must not contain null-byte");
+		return FALSE;
+	}
+
+	if (G_UNLIKELY(!teco_scintilla_symbols_cache))
+		teco_scintilla_symbols_cache = g_hash_table_new_full(g_str_hash, g_str_equal,
+		                                                     g_free, g_free);
+
+	const teco_machine_scintilla_t *cached;
+	cached = g_hash_table_lookup(teco_scintilla_symbols_cache, str->data);
+	if (cached) {
+		*scintilla = *cached;
+		return TRUE;
+	}
+
+	if (!teco_scintilla_lookup_symbols(scintilla, str->data, error))
+		return FALSE;
+
+	if (g_hash_table_size(teco_scintilla_symbols_cache) >= TECO_SCINTILLA_SYMBOLS_CACHE_MAX)
+		g_hash_table_remove_all(teco_scintilla_symbols_cache);
+	teco_machine_scintilla_t *entry = g_new(teco_machine_scintilla_t, 1);
+	*entry = *scintilla;
+	g_hash_table_insert(teco_scintilla_symbols_cache, g_strdup(str->data), entry);
+
+	return TRUE;
+}
+
+static void TECO_DEBUG_CLEANUP
+teco_scintilla_symbols_cache_cleanup(void)
+{
+	if (teco_scintilla_symbols_cache)
+		g_hash_table_destroy(teco_scintilla_symbols_cache);
+}
+
 static teco_state_t *
 teco_state_scintilla_symbols_done(teco_machine_main_t *ctx, const teco_string_t *str, GError **error)
 {
@@ -425,6 +482,9 @@ teco_state_scintilla_lparam_done(teco_machine_main_t *ctx, const teco_string_t *
 	if (ctx->flags.mode > TECO_MODE_NORMAL)
 		return &teco_state_start;
 
+	/* Scintilla state cannot be restored from state images */
+	teco_image_taint();
+
 	sptr_t lParam = 0;
 
 	if (ctx->scintilla.iMessage == SCI_NAMEOFSTYLE) {
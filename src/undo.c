@@ -26,6 +26,7 @@
 
 #include "sciteco.h"
 #include "cmdline.h"
+#include "stats.h"
 #include "undo.h"
 
 //#define DEBUG
@@ -92,6 +93,7 @@ teco_undo_push_size(teco_undo_action_t action_cb, gsize size)
 
 	teco_undo_token_t *token = g_malloc(sizeof(teco_undo_token_t) + size);
 	token->action_cb = action_cb;
+	teco_stats_inc(TECO_STATS_UNDO_PUSHED);
 
 #ifdef DEBUG
 	g_printf("UNDO PUSH %p\n", token);
@@ -128,6 +130,7 @@ teco_undo_pop(gsize pc)
 			fflush(stdout);
 #endif
 			top->action_cb(top->user_data, TRUE);
+			teco_stats_inc(TECO_STATS_UNDO_POPPED);
 
 			g_free(top);
 			top = next;
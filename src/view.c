@@ -215,7 +215,7 @@ teco_view_load_from_channel(teco_view_t *ctx, GIOChannel *channel,
 	unsigned int message = SCI_ADDTEXT;
 
 	g_auto(teco_eol_reader_t) reader;
-	teco_eol_reader_init_gio(&reader, channel);
+	teco_eol_reader_init_gio(&reader, teco_ed & TECO_ED_AUTOEOL ? TRUE : FALSE, channel);
 
 	/*
 	 * Temporarily disable the line character index.
@@ -388,6 +388,289 @@ teco_view_load_from_stdin(teco_view_t *ctx, gboolean clear, GError **error)
 	return TRUE;
 }
 
+/*
+ * Background loading of a sequence of files.
+ *
+ * Reading files and normalizing their EOLs does not require
+ * Scintilla and can therefore be performed by a pool of worker threads,
+ * while the main thread merely inserts the prepared contents into the views
+ * in order.
+ * At most TECO_VIEW_LOADER_LOOKAHEAD files per worker thread are kept in
+ * memory ahead of the file currently being inserted.
+ *
+ * NOTE: Whether EOLs are translated is captured when scheduling a file,
+ * since teco_ed may be modified by hooks executed on the main thread
+ * in the meantime.
+ * teco_view_loader_load() falls back to loading synchronously
+ * if EOL translation has been toggled.
+ *
+ * NOTE: Loading does not validate UTF-8 or detect codepages.
+ * Documents are always inserted as raw bytes and their encoding
+ * can only be changed afterwards (see EE), so there is nothing else
+ * that could be done by the worker threads.
+ */
+#define TECO_VIEW_LOADER_LOOKAHEAD 2
+
+typedef struct {
+	const gchar *filename;
+
+	/** whether automatic EOL translation was enabled when scheduling the file */
+	gboolean autoeol;
+
+	/*
+	 * The following fields are written by the worker thread and
+	 * may only be accessed by the main thread once `done` is set.
+	 */
+	gchar *data;
+	gsize len;
+	gint eol_style;
+	gboolean eol_style_inconsistent;
+	GError *error;
+
+	/** protected by teco_view_loader_t::mutex */
+	gboolean done;
+} teco_view_loader_file_t;
+
+struct teco_view_loader_t {
+	GThreadPool *pool;
+	GMutex mutex;
+	GCond cond;
+
+	GPtrArray *filenames;
+	teco_view_loader_file_t *files;
+
+	/** number of files pushed into the thread pool */
+	guint scheduled;
+	/** index of the next file returned by teco_view_loader_next() */
+	guint next;
+	/** maximum number of files scheduled beyond the current one */
+	guint lookahead;
+};
+
+static void
+teco_view_loader_worker(gpointer data, gpointer user_data)
+{
+	teco_view_loader_file_t *file = data;
+	teco_view_loader_t *ctx = user_data;
+
+	if (g_file_get_contents(file->filename, &file->data, &file->len, &file->error)) {
+		g_auto(teco_eol_reader_t) reader;
+		teco_eol_reader_init_mem(&reader, file->autoeol, file->data, file->len);
+
+		/*
+		 * Compact the EOL-normalized chunks in place.
+		 * They always point into the buffer behind the
+		 * already compacted data.
+		 */
+		gsize len = 0;
+		gchar *chunk;
+		gsize chunk_len;
+		GIOStatus rc;
+		while ((rc = teco_eol_reader_convert(&reader, &chunk, &chunk_len,
+		                                     &file->error)) == G_IO_STATUS_NORMAL) {
+			memmove(file->data + len, chunk, chunk_len);
+			len += chunk_len;
+		}
+
+		file->len = len;
+		file->eol_style = reader.eol_style;
+		file->eol_style_inconsistent = reader.eol_style_inconsistent;
+
+		if (rc == G_IO_STATUS_ERROR) {
+			g_clear_pointer(&file->data, g_free);
+			file->len = 0;
+		}
+	}
+
+	if (file->error)
+		g_prefix_error(&file->error, "Error reading file \"%s\": ", file->filename);
+
+	g_mutex_lock(&ctx->mutex);
+	file->done = TRUE;
+	g_cond_broadcast(&ctx->cond);
+	g_mutex_unlock(&ctx->mutex);
+}
+
+/**
+ * Start loading files in the background.
+ *
+ * @param filenames Array of file names to load.
+ *   The files must be consumed in this order via
+ *   teco_view_loader_next().
+ * @return A new loader object.
+ *
+ * @memberof teco_view_loader_t
+ */
+teco_view_loader_t *
+teco_view_loader_new(GPtrArray *filenames)
+{
+	teco_view_loader_t *ctx = g_new0(teco_view_loader_t, 1);
+	guint threads = MAX(g_get_num_processors(), 1);
+
+	/* not exclusive, so this cannot fail */
+	ctx->pool = g_thread_pool_new(teco_view_loader_worker, ctx, threads, FALSE, NULL);
+	g_mutex_init(&ctx->mutex);
+	g_cond_init(&ctx->cond);
+
+	ctx->filenames = g_ptr_array_ref(filenames);
+	ctx->files = g_new0(teco_view_loader_file_t, filenames->len);
+	ctx->lookahead = threads*TECO_VIEW_LOADER_LOOKAHEAD;
+
+	return ctx;
+}
+
+/**
+ * Advance to the next file.
+ *
+ * This also schedules further files to be read in the background
+ * and releases the contents of the previous file.
+ *
+ * @return The name of the file, that can be loaded with
+ *   teco_view_loader_load() or NULL after the last file.
+ *
+ * @memberof teco_view_loader_t
+ */
+const gchar *
+teco_view_loader_next(teco_view_loader_t *ctx)
+{
+	if (ctx->next > 0) {
+		teco_view_loader_file_t *prev = ctx->files + ctx->next - 1;
+
+		g_mutex_lock(&ctx->mutex);
+		if (prev->done) {
+			g_free(prev->data);
+			prev->data = NULL;
+		}
+		g_mutex_unlock(&ctx->mutex);
+	}
+
+	if (ctx->next >= ctx->filenames->len)
+		return NULL;
+
+	while (ctx->scheduled < ctx->filenames->len &&
+	       ctx->scheduled <= ctx->next + ctx->lookahead) {
+		teco_view_loader_file_t *file = ctx->files + ctx->scheduled;
+
+		file->filename = g_ptr_array_index(ctx->filenames, ctx->scheduled);
+		file->autoeol = teco_ed & TECO_ED_AUTOEOL ? TRUE : FALSE;
+		file->eol_style = -1;
+		ctx->scheduled++;
+
+		/*
+		 * Files exceeding the memory limit are not even read.
+		 * The limit may only be checked on the main thread.
+		 */
+		GStatBuf stat_buf;
+		if (!g_stat(file->filename, &stat_buf) &&
+		    !teco_memory_check(stat_buf.st_size, &file->error)) {
+			g_prefix_error(&file->error, "Error reading file \"%s\": ", file->filename);
+			file->done = TRUE;
+			continue;
+		}
+
+		g_thread_pool_push(ctx->pool, file, NULL);
+	}
+
+	return g_ptr_array_index(ctx->filenames, ctx->next++);
+}
+
+/**
+ * Load the file last returned by teco_view_loader_next()
+ * into a view, replacing its contents.
+ *
+ * This is equivalent to teco_view_load_from_file()
+ * with `clear` set to TRUE, but waits for the file to be
+ * prepared in the background.
+ *
+ * @param ctx The loader object.
+ * @param view The view to load.
+ * @param error A GError.
+ * @return FALSE in case of a GError.
+ *
+ * @memberof teco_view_loader_t
+ */
+gboolean
+teco_view_loader_load(teco_view_loader_t *ctx, teco_view_t *view, GError **error)
+{
+	g_assert(ctx->next > 0);
+	teco_view_loader_file_t *file = ctx->files + ctx->next - 1;
+
+	g_mutex_lock(&ctx->mutex);
+	while (!file->done)
+		g_cond_wait(&ctx->cond, &ctx->mutex);
+	g_mutex_unlock(&ctx->mutex);
+
+	/*
+	 * EOL translation might have been toggled by a hook
+	 * since the file has been scheduled.
+	 */
+	if (file->autoeol != (teco_ed & TECO_ED_AUTOEOL ? TRUE : FALSE))
+		return teco_view_load_from_file(view, file->filename, TRUE, error);
+
+	if (file->error) {
+		g_propagate_error(error, file->error);
+		file->error = NULL;
+		return FALSE;
+	}
+
+	if (!teco_memory_check(file->len, error))
+		return FALSE;
+
+	/* see teco_view_load_from_channel() */
+	guint cp = teco_view_get_codepage(view);
+	if (cp == SC_CP_UTF8)
+		teco_interface_ssm(SCI_RELEASELINECHARACTERINDEX,
+		                   SC_LINECHARACTERINDEX_UTF32, 0);
+
+	teco_view_ssm(view, SCI_BEGINUNDOACTION, 0, 0);
+	teco_view_ssm(view, SCI_CLEARALL, 0, 0);
+	/* keep dot at beginning of document */
+	teco_view_ssm(view, SCI_APPENDTEXT, file->len, (sptr_t)file->data);
+	if (file->eol_style >= 0)
+		teco_view_ssm(view, SCI_SETEOLMODE, file->eol_style, 0);
+	teco_view_ssm(view, SCI_ENDUNDOACTION, 0, 0);
+
+	if (cp == SC_CP_UTF8)
+		teco_interface_ssm(SCI_ALLOCATELINECHARACTERINDEX,
+		                   SC_LINECHARACTERINDEX_UTF32, 0);
+
+	g_free(file->data);
+	file->data = NULL;
+
+	if (file->eol_style_inconsistent)
+		teco_interface_msg(TECO_MSG_WARNING,
+		                   "Inconsistent EOL styles normalized");
+
+	/* Scintilla could allocate more than the file size */
+	return teco_memory_check(0, error);
+}
+
+/**
+ * Free a loader object.
+ *
+ * Files that have not yet been read by the worker threads
+ * are discarded.
+ *
+ * @memberof teco_view_loader_t
+ */
+void
+teco_view_loader_free(teco_view_loader_t *ctx)
+{
+	/* waits for the files currently being read */
+	g_thread_pool_free(ctx->pool, TRUE, TRUE);
+
+	for (guint i = 0; i < ctx->scheduled; i++) {
+		g_free(ctx->files[i].data);
+		g_clear_error(&ctx->files[i].error);
+	}
+	g_free(ctx->files);
+	g_ptr_array_unref(ctx->filenames);
+
+	g_cond_clear(&ctx->cond);
+	g_mutex_clear(&ctx->mutex);
+	g_free(ctx);
+}
+
 #if 0
 
 /*
@@ -504,92 +787,387 @@ teco_undo_remove_file_push(const gchar *filename)
 		strcpy(ctx, filename);
 }
 
-gboolean
-teco_view_save_to_channel(teco_view_t *ctx, GIOChannel *channel, GError **error)
+/*
+ * Snapshot of a document's contents.
+ *
+ * It references Scintilla's buffer directly, so it can be written
+ * by any thread as long as the document is not modified.
+ */
+typedef struct {
+	gint eol_mode;
+	/** whether EOLs are translated, captured since teco_ed may change */
+	gboolean autoeol;
+	/** the parts of the document before and after the gap */
+	const gchar *parts[2];
+	gsize parts_len[2];
+} teco_view_snapshot_t;
+
+static void
+teco_view_snapshot(teco_view_t *ctx, teco_view_snapshot_t *snapshot)
 {
-	g_auto(teco_eol_writer_t) writer;
-	teco_eol_writer_init_gio(&writer, teco_view_ssm(ctx, SCI_GETEOLMODE, 0, 0), channel);
+	snapshot->eol_mode = teco_view_ssm(ctx, SCI_GETEOLMODE, 0, 0);
+	snapshot->autoeol = teco_ed & TECO_ED_AUTOEOL ? TRUE : FALSE;
 
-	/* write part of buffer before gap */
+	/* does not move the gap since neither range spans it */
 	sptr_t gap = teco_view_ssm(ctx, SCI_GETGAPPOSITION, 0, 0);
-	if (gap > 0) {
-		const gchar *buffer = (const gchar *)teco_view_ssm(ctx, SCI_GETRANGEPOINTER, 0, gap);
-		gssize bytes_written = teco_eol_writer_convert(&writer, buffer, gap, error);
-		if (bytes_written < 0)
-			return FALSE;
-		g_assert(bytes_written == (gsize)gap);
-	}
+	snapshot->parts_len[0] = gap;
+	snapshot->parts[0] = gap > 0 ? (const gchar *)teco_view_ssm(ctx, SCI_GETRANGEPOINTER, 0, gap) : NULL;
 
-	/* write part of buffer after gap */
 	gsize size = teco_view_ssm(ctx, SCI_GETLENGTH, 0, 0) - gap;
-	if (size > 0) {
-		const gchar *buffer = (const gchar *)teco_view_ssm(ctx, SCI_GETRANGEPOINTER, gap, (sptr_t)size);
-		gssize bytes_written = teco_eol_writer_convert(&writer, buffer, size, error);
+	snapshot->parts_len[1] = size;
+	snapshot->parts[1] = size > 0 ? (const gchar *)teco_view_ssm(ctx, SCI_GETRANGEPOINTER, gap, (sptr_t)size) : NULL;
+}
+
+static gboolean
+teco_view_snapshot_write(const teco_view_snapshot_t *ctx, GIOChannel *channel, GError **error)
+{
+	g_auto(teco_eol_writer_t) writer;
+	teco_eol_writer_init_gio(&writer, ctx->eol_mode, ctx->autoeol, channel);
+
+	for (guint i = 0; i < G_N_ELEMENTS(ctx->parts); i++) {
+		if (!ctx->parts_len[i])
+			continue;
+
+		gssize bytes_written = teco_eol_writer_convert(&writer, ctx->parts[i],
+		                                               ctx->parts_len[i], error);
 		if (bytes_written < 0)
 			return FALSE;
-		g_assert(bytes_written == size);
+		g_assert(bytes_written == ctx->parts_len[i]);
 	}
 
 	return TRUE;
 }
 
-/** @memberof teco_view_t */
 gboolean
-teco_view_save_to_file(teco_view_t *ctx, const gchar *filename, GError **error)
+teco_view_save_to_channel(teco_view_t *ctx, GIOChannel *channel, GError **error)
 {
+	teco_view_snapshot_t snapshot;
+	teco_view_snapshot(ctx, &snapshot);
+	return teco_view_snapshot_write(&snapshot, channel, error);
+}
+
+/*
+ * Saving a document to a file.
+ *
+ * Savepoints are created and undo tokens are pushed when the job
+ * is initialized on the main thread, while the document is written
+ * by teco_view_save_job_write(), which may run on any thread.
+ * Existing files are written into a temporary file in the same directory,
+ * which replaces `filename` only once it has been completely written.
+ * New files, symlinks, files with several hard links and files in
+ * directories that are not writable are written in place, though.
+ */
+typedef struct {
+	gchar *filename;
+	/** whether the file is written directly instead of being replaced */
+	gboolean in_place;
+	teco_view_snapshot_t snapshot;
+
 #ifdef G_OS_UNIX
 	GStatBuf file_stat;
-	file_stat.st_uid = -1;
-	file_stat.st_gid = -1;
+	/** errno of a failed attempt to preserve the owner */
+	gint chown_errno;
+#endif
+	teco_file_attributes_t attributes;
+
+	gboolean ok;
+	GError *error;
+} teco_view_save_job_t;
+
+static void
+teco_view_save_job_init(teco_view_save_job_t *ctx, teco_view_t *view, const gchar *filename)
+{
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->filename = g_strdup(filename);
+#ifdef G_OS_UNIX
+	ctx->file_stat.st_uid = -1;
+	ctx->file_stat.st_gid = -1;
 #endif
-	teco_file_attributes_t attributes = TECO_FILE_INVALID_ATTRIBUTES;
+	ctx->attributes = TECO_FILE_INVALID_ATTRIBUTES;
+
+	/*
+	 * Replacing symlinks or hard links would break them.
+	 * This must be checked before creating the savepoint.
+	 */
+	GStatBuf link_stat;
+	g_autofree gchar *dirname = g_path_get_dirname(filename);
+	ctx->in_place = g_lstat(filename, &link_stat) ||
+	                !S_ISREG(link_stat.st_mode) || link_stat.st_nlink > 1 ||
+	                g_access(dirname, W_OK);
 
-	if (teco_undo_enabled) {
-		if (g_file_test(filename, G_FILE_TEST_IS_REGULAR)) {
+	/*
+	 * The attributes have to be restored even without undo,
+	 * since the file is replaced by a new one.
+	 */
+	if (g_file_test(filename, G_FILE_TEST_IS_REGULAR)) {
 #ifdef G_OS_UNIX
-			g_stat(filename, &file_stat);
+		g_stat(filename, &ctx->file_stat);
 #endif
-			attributes = teco_file_get_attributes(filename);
+		ctx->attributes = teco_file_get_attributes(filename);
+		if (teco_undo_enabled)
 			teco_make_savepoint(filename);
-		} else {
-			teco_undo_remove_file_push(filename);
-		}
+	} else if (teco_undo_enabled) {
+		teco_undo_remove_file_push(filename);
 	}
 
-	/* leaves access mode intact if file still exists */
-	g_autoptr(GIOChannel) channel = g_io_channel_new_file(filename, "w", error);
-	if (!channel)
-		return FALSE;
+	teco_view_snapshot(view, &ctx->snapshot);
+}
+
+static gboolean
+teco_view_save_job_write(teco_view_save_job_t *ctx, GError **error)
+{
+	g_autofree gchar *tmp_filename = NULL;
+	GIOChannel *channel;
+
+	if (ctx->in_place) {
+		/* leaves access mode intact if file still exists */
+		channel = g_io_channel_new_file(ctx->filename, "w", error);
+		if (!channel)
+			goto error;
+	} else {
+		g_autofree gchar *basename = g_path_get_basename(ctx->filename);
+		g_autofree gchar *tmp_basename = g_strdup_printf(".teco-save-%s-XXXXXX", basename);
+		g_autofree gchar *dirname = g_path_get_dirname(ctx->filename);
+		tmp_filename = g_build_filename(dirname, tmp_basename, NULL);
+
+		gint fd = g_mkstemp(tmp_filename);
+		if (fd < 0) {
+			gint errsv = errno;
+			g_set_error_literal(error, G_FILE_ERROR, g_file_error_from_errno(errsv),
+			                    g_strerror(errsv));
+			/* nothing to unlink */
+			g_clear_pointer(&tmp_filename, g_free);
+			goto error;
+		}
+
+#ifdef G_OS_WIN32
+		channel = g_io_channel_win32_new_fd(fd);
+#else
+		channel = g_io_channel_unix_new(fd);
+#endif
+		g_io_channel_set_close_on_unref(channel, TRUE);
+	}
 
 	/*
-	 * teco_view_save_to_channel() expects a buffered and blocking channel
+	 * teco_view_snapshot_write() expects a buffered and blocking channel
 	 */
 	g_io_channel_set_encoding(channel, NULL, NULL);
 	g_io_channel_set_buffered(channel, TRUE);
 
-	if (!teco_view_save_to_channel(ctx, channel, error)) {
-		g_prefix_error(error, "Error writing file \"%s\": ", filename);
-		return FALSE;
+	gboolean ret = teco_view_snapshot_write(&ctx->snapshot, channel, error) &&
+	               g_io_channel_flush(channel, error) == G_IO_STATUS_NORMAL;
+#ifdef G_OS_UNIX
+	if (ret) {
+		gint fd = g_io_channel_unix_get_fd(channel);
+
+		/*
+		 * only a good try to inherit owner since process user must have
+		 * CHOWN capability traditionally reserved to root only.
+		 * FIXME: We should probably fall back to another save point
+		 * strategy.
+		 */
+		if (fchown(fd, ctx->file_stat.st_uid, ctx->file_stat.st_gid))
+			ctx->chown_errno = errno;
+
+		/*
+		 * The temporary file is created with restrictive permissions,
+		 * so the access mode of the replaced file is restored.
+		 * Without fsync(), the rename might be persisted before the
+		 * contents, leaving an empty file after a crash.
+		 * This costs one synchronous write per saved file, which can
+		 * be noticeable on slow or network file systems.
+		 */
+		if (!ctx->in_place &&
+		    (fchmod(fd, ctx->file_stat.st_mode & 07777) || fsync(fd))) {
+			gint errsv = errno;
+			g_set_error_literal(error, G_FILE_ERROR, g_file_error_from_errno(errsv),
+			                    g_strerror(errsv));
+			ret = FALSE;
+		}
+	}
+#endif
+	g_io_channel_unref(channel);
+	if (!ret)
+		goto error;
+
+	if (!ctx->in_place && g_rename(tmp_filename, ctx->filename)) {
+		gint errsv = errno;
+		g_set_error_literal(error, G_FILE_ERROR, g_file_error_from_errno(errsv),
+		                    g_strerror(errsv));
+		goto error;
 	}
 
-	/* if file existed but has been renamed, restore attributes */
-	if (attributes != TECO_FILE_INVALID_ATTRIBUTES)
-		teco_file_set_attributes(filename, attributes);
+	/* if file existed but has been replaced, restore attributes */
+	if (ctx->attributes != TECO_FILE_INVALID_ATTRIBUTES)
+		teco_file_set_attributes(ctx->filename, ctx->attributes);
+
+	return TRUE;
+
+error:
+	if (tmp_filename)
+		g_unlink(tmp_filename);
+	g_prefix_error(error, "Error writing file \"%s\": ", ctx->filename);
+	return FALSE;
+}
+
+/**
+ * Report the result of a save job on the main thread
+ * and free its resources.
+ */
+static gboolean
+teco_view_save_job_finish(teco_view_save_job_t *ctx, GError **error)
+{
 #ifdef G_OS_UNIX
-	/*
-	 * only a good try to inherit owner since process user must have
-	 * CHOWN capability traditionally reserved to root only.
-	 * FIXME: We should probably fall back to another save point
-	 * strategy.
-	 */
-	if (fchown(g_io_channel_unix_get_fd(channel),
-	           file_stat.st_uid, file_stat.st_gid))
+	if (ctx->chown_errno)
 		teco_interface_msg(TECO_MSG_WARNING,
 		                   "Unable to preserve owner of \"%s\": %s",
-		                   filename, g_strerror(errno));
+		                   ctx->filename, g_strerror(ctx->chown_errno));
 #endif
+	if (ctx->error)
+		g_propagate_error(error, ctx->error);
+	ctx->error = NULL;
 
-	return TRUE;
+	g_free(ctx->filename);
+	ctx->filename = NULL;
+	return ctx->ok;
+}
+
+/** @memberof teco_view_t */
+gboolean
+teco_view_save_to_file(teco_view_t *ctx, const gchar *filename, GError **error)
+{
+	teco_view_save_job_t job;
+	teco_view_save_job_init(&job, ctx, filename);
+	job.ok = teco_view_save_job_write(&job, &job.error);
+	return teco_view_save_job_finish(&job, error);
+}
+
+/*
+ * Saving several documents concurrently.
+ */
+typedef struct {
+	teco_view_save_job_t job;
+	/** protected by teco_view_saver_t::mutex */
+	gboolean done;
+} teco_view_saver_job_t;
+
+struct teco_view_saver_t {
+	GThreadPool *pool;
+	GMutex mutex;
+	GCond cond;
+
+	/** array of teco_view_saver_job_t pointers */
+	GPtrArray *jobs;
+};
+
+static void
+teco_view_saver_worker(gpointer data, gpointer user_data)
+{
+	teco_view_saver_job_t *job = data;
+	teco_view_saver_t *ctx = user_data;
+
+	job->job.ok = teco_view_save_job_write(&job->job, &job->job.error);
+
+	g_mutex_lock(&ctx->mutex);
+	job->done = TRUE;
+	g_cond_broadcast(&ctx->cond);
+	g_mutex_unlock(&ctx->mutex);
+}
+
+/**
+ * Create a new saver object, that writes documents
+ * with the help of worker threads.
+ *
+ * @memberof teco_view_saver_t
+ */
+teco_view_saver_t *
+teco_view_saver_new(void)
+{
+	teco_view_saver_t *ctx = g_new0(teco_view_saver_t, 1);
+
+	/* not exclusive, so this cannot fail */
+	ctx->pool = g_thread_pool_new(teco_view_saver_worker, ctx,
+	                              MAX(g_get_num_processors(), 1), FALSE, NULL);
+	g_mutex_init(&ctx->mutex);
+	g_cond_init(&ctx->cond);
+	ctx->jobs = g_ptr_array_new();
+
+	return ctx;
+}
+
+/**
+ * Start saving a view's document to a file.
+ *
+ * Save points are created immediately, but the document is written
+ * in the background.
+ * The document must not be modified until the saver object
+ * is freed.
+ *
+ * @param ctx The saver object.
+ * @param view The view to save.
+ * @param filename The file to write.
+ *
+ * @memberof teco_view_saver_t
+ */
+void
+teco_view_saver_add(teco_view_saver_t *ctx, teco_view_t *view, const gchar *filename)
+{
+	teco_view_saver_job_t *job = g_new0(teco_view_saver_job_t, 1);
+	teco_view_save_job_init(&job->job, view, filename);
+
+	g_ptr_array_add(ctx->jobs, job);
+	g_thread_pool_push(ctx->pool, job, NULL);
+}
+
+/**
+ * Wait for a document to be saved.
+ *
+ * This may be called only once per document.
+ *
+ * @param ctx The saver object.
+ * @param i The index of the document in the order
+ *   of teco_view_saver_add() calls.
+ * @param error A GError.
+ * @return FALSE in case of a GError.
+ *
+ * @memberof teco_view_saver_t
+ */
+gboolean
+teco_view_saver_wait(teco_view_saver_t *ctx, guint i, GError **error)
+{
+	teco_view_saver_job_t *job = g_ptr_array_index(ctx->jobs, i);
+
+	g_mutex_lock(&ctx->mutex);
+	while (!job->done)
+		g_cond_wait(&ctx->cond, &ctx->mutex);
+	g_mutex_unlock(&ctx->mutex);
+
+	return teco_view_save_job_finish(&job->job, error);
+}
+
+/**
+ * Free a saver object.
+ *
+ * This waits for all pending documents to be written.
+ *
+ * @memberof teco_view_saver_t
+ */
+void
+teco_view_saver_free(teco_view_saver_t *ctx)
+{
+	g_thread_pool_free(ctx->pool, FALSE, TRUE);
+
+	for (guint i = 0; i < ctx->jobs->len; i++) {
+		teco_view_saver_job_t *job = g_ptr_array_index(ctx->jobs, i);
+		g_free(job->job.filename);
+		g_clear_error(&job->job.error);
+		g_free(job);
+	}
+	g_ptr_array_unref(ctx->jobs);
+
+	g_cond_clear(&ctx->cond);
+	g_mutex_clear(&ctx->mutex);
+	g_free(ctx);
 }
 
 /** @memberof teco_view_t */
@@ -617,6 +1195,183 @@ teco_view_save_to_stdout(teco_view_t *ctx, GError **error)
 	return TRUE;
 }
 
+/*
+ * Streaming filter mode (see --stream).
+ *
+ * stdin is split into records, each terminated by a separator.
+ * Records are loaded into a view one after another and written back
+ * to stdout, so memory is bounded by the size of a record rather than
+ * the size of the input.
+ * The separator is matched after EOL normalization.
+ */
+struct teco_view_stream_t {
+	GIOChannel *in, *out;
+	teco_eol_reader_t reader;
+	gboolean eof;
+
+	teco_string_t separator;
+	/** input that has been read but not yet loaded */
+	GString *pending;
+	/** length of the prefix of pending that cannot contain the separator */
+	gsize scanned;
+};
+
+/** @memberof teco_view_stream_t */
+teco_view_stream_t *
+teco_view_stream_new(const gchar *separator, gsize separator_len)
+{
+	g_assert(separator_len > 0);
+
+	teco_view_stream_t *ctx = g_new0(teco_view_stream_t, 1);
+
+#ifdef G_OS_WIN32
+	ctx->in = g_io_channel_win32_new_fd(0);
+	ctx->out = g_io_channel_win32_new_fd(1);
+#else
+	ctx->in = g_io_channel_unix_new(0);
+	ctx->out = g_io_channel_unix_new(1);
+#endif
+	g_assert(ctx->in != NULL && ctx->out != NULL);
+
+	/* see teco_view_load_from_stdin() */
+	g_io_channel_set_encoding(ctx->in, NULL, NULL);
+	g_io_channel_set_buffered(ctx->in, FALSE);
+	/* see teco_view_save_to_stdout() */
+	g_io_channel_set_encoding(ctx->out, NULL, NULL);
+	g_io_channel_set_buffered(ctx->out, TRUE);
+
+	teco_eol_reader_init_gio(&ctx->reader, teco_ed & TECO_ED_AUTOEOL ? TRUE : FALSE, ctx->in);
+
+	teco_string_init(&ctx->separator, separator, separator_len);
+	ctx->pending = g_string_new(NULL);
+
+	return ctx;
+}
+
+/**
+ * Find the end of the first record in the pending input.
+ *
+ * @return Length of the record including its separator or -1.
+ */
+static gssize
+teco_view_stream_find(teco_view_stream_t *ctx)
+{
+	const gchar *sep = ctx->separator.data;
+	gsize sep_len = ctx->separator.len;
+
+	while (ctx->scanned + sep_len <= ctx->pending->len) {
+		const gchar *p = memchr(ctx->pending->str + ctx->scanned, *sep,
+		                        ctx->pending->len - sep_len + 1 - ctx->scanned);
+		if (!p) {
+			ctx->scanned = ctx->pending->len - sep_len + 1;
+			break;
+		}
+		ctx->scanned = p - ctx->pending->str;
+		if (!memcmp(p, sep, sep_len))
+			return ctx->scanned + sep_len;
+		ctx->scanned++;
+	}
+
+	return -1;
+}
+
+/**
+ * Replace the document of a view with the next record from stdin.
+ *
+ * Dot is left at the beginning of the document.
+ * The last record does not have to be terminated by the separator.
+ *
+ * @param ctx The stream.
+ * @param view The view to load the record into.
+ * @param error A GError.
+ * @return FALSE in case of a GError or if there are no more records.
+ *   error is set only in case of errors.
+ *
+ * @memberof teco_view_stream_t
+ */
+gboolean
+teco_view_stream_read(teco_view_stream_t *ctx, teco_view_t *view, GError **error)
+{
+	gssize len;
+
+	while ((len = teco_view_stream_find(ctx)) < 0 && !ctx->eof) {
+		teco_string_t str;
+
+		GIOStatus rc = teco_eol_reader_convert(&ctx->reader, &str.data, &str.len, error);
+		if (rc == G_IO_STATUS_ERROR) {
+			g_prefix_error(error, "Error reading stdin: ");
+			return FALSE;
+		}
+		if (rc == G_IO_STATUS_EOF)
+			ctx->eof = TRUE;
+		else
+			g_string_append_len(ctx->pending, str.data, str.len);
+
+		if (!teco_memory_check(0, error))
+			return FALSE;
+
+		if (G_UNLIKELY(teco_interface_is_interrupted())) {
+			teco_error_interrupted_set(error);
+			return FALSE;
+		}
+	}
+
+	if (len < 0) {
+		/* unterminated last record */
+		if (!ctx->pending->len)
+			return FALSE;
+		len = ctx->pending->len;
+	}
+
+	teco_view_ssm(view, SCI_CLEARALL, 0, 0);
+	teco_view_ssm(view, SCI_APPENDTEXT, len, (sptr_t)ctx->pending->str);
+	/* see teco_view_load_from_channel() */
+	if (ctx->reader.eol_style >= 0)
+		teco_view_ssm(view, SCI_SETEOLMODE, ctx->reader.eol_style, 0);
+
+	g_string_erase(ctx->pending, 0, len);
+	ctx->scanned = 0;
+
+	return TRUE;
+}
+
+/**
+ * Write the document of a view to stdout.
+ *
+ * @memberof teco_view_stream_t
+ */
+gboolean
+teco_view_stream_write(teco_view_stream_t *ctx, teco_view_t *view, GError **error)
+{
+	/*
+	 * Records are flushed one by one, so pipelines
+	 * see them as soon as they have been processed.
+	 */
+	if (!teco_view_save_to_channel(view, ctx->out, error) ||
+	    g_io_channel_flush(ctx->out, error) != G_IO_STATUS_NORMAL) {
+		g_prefix_error(error, "Error writing to stdout: ");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/** @memberof teco_view_stream_t */
+void
+teco_view_stream_free(teco_view_stream_t *ctx)
+{
+	if (ctx->reader.eol_style_inconsistent)
+		teco_interface_msg(TECO_MSG_WARNING,
+		                   "Inconsistent EOL styles normalized");
+
+	teco_eol_reader_clear(&ctx->reader);
+	g_io_channel_unref(ctx->in);
+	g_io_channel_unref(ctx->out);
+	teco_string_clear(&ctx->separator);
+	g_string_free(ctx->pending, TRUE);
+	g_free(ctx);
+}
+
 /**
  * Convert a glyph index to a byte offset as used by Scintilla.
  *
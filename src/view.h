@@ -65,6 +65,19 @@ gboolean teco_view_load_from_stdin(teco_view_t *ctx, gboolean clear, GError **er
 	                  const gchar * : teco_view_load_from_file)((CTX), (FROM), \
 	                                                            (CLEAR), (ERROR)))
 
+/**
+ * @class teco_view_loader_t
+ * Loads a sequence of files with the help of worker threads.
+ */
+typedef struct teco_view_loader_t teco_view_loader_t;
+
+teco_view_loader_t *teco_view_loader_new(GPtrArray *filenames);
+const gchar *teco_view_loader_next(teco_view_loader_t *ctx);
+gboolean teco_view_loader_load(teco_view_loader_t *ctx, teco_view_t *view, GError **error);
+void teco_view_loader_free(teco_view_loader_t *ctx);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(teco_view_loader_t, teco_view_loader_free);
+
 gboolean teco_view_save_to_channel(teco_view_t *ctx, GIOChannel *channel, GError **error);
 gboolean teco_view_save_to_file(teco_view_t *ctx, const gchar *filename, GError **error);
 gboolean teco_view_save_to_stdout(teco_view_t *ctx, GError **error);
@@ -75,6 +88,32 @@ gboolean teco_view_save_to_stdout(teco_view_t *ctx, GError **error);
 	                gchar *       : teco_view_save_to_file, \
 	                const gchar * : teco_view_save_to_file)((CTX), (TO), (ERROR)))
 
+/**
+ * @class teco_view_saver_t
+ * Saves several documents with the help of worker threads.
+ */
+typedef struct teco_view_saver_t teco_view_saver_t;
+
+teco_view_saver_t *teco_view_saver_new(void);
+void teco_view_saver_add(teco_view_saver_t *ctx, teco_view_t *view, const gchar *filename);
+gboolean teco_view_saver_wait(teco_view_saver_t *ctx, guint i, GError **error);
+void teco_view_saver_free(teco_view_saver_t *ctx);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(teco_view_saver_t, teco_view_saver_free);
+
+/**
+ * @class teco_view_stream_t
+ * Filters stdin into stdout record by record.
+ */
+typedef struct teco_view_stream_t teco_view_stream_t;
+
+teco_view_stream_t *teco_view_stream_new(const gchar *separator, gsize separator_len);
+gboolean teco_view_stream_read(teco_view_stream_t *ctx, teco_view_t *view, GError **error);
+gboolean teco_view_stream_write(teco_view_stream_t *ctx, teco_view_t *view, GError **error);
+void teco_view_stream_free(teco_view_stream_t *ctx);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(teco_view_stream_t, teco_view_stream_free);
+
 /** @pure @memberof teco_view_t */
 void teco_view_free(teco_view_t *ctx);
 
@@ -0,0 +1,42 @@
+#!/bin/sh
+# Compares benchmark results written by bench.sh against a baseline.
+# Benchmarks that got slower by more than THRESHOLD percent (default 10)
+# are reported as regressions, in which case the exit status is 1.
+#
+# Usage: bench-compare.sh BASELINE.json RESULTS.json [THRESHOLD]
+
+if [ $# -lt 2 ]; then
+	echo "Usage: $0 BASELINE.json RESULTS.json [THRESHOLD]" >&2
+	exit 2
+fi
+
+awk -v threshold=${3:-10} '
+# Only the "results" object contains numeric members.
+match($0, /^[ \t]*"[^"]+":[ \t]*[0-9.]+,?[ \t]*$/) {
+	split($0, fields, "\"")
+	value = $NF
+	sub(/,$/, "", value)
+	if (FNR == NR) {
+		baseline[fields[2]] = value
+	} else {
+		names[++n] = fields[2]
+		results[fields[2]] = value
+	}
+}
+
+END {
+	printf "%-20s %12s %12s %9s\n", "benchmark", "baseline", "current", "change"
+	for (i = 1; i <= n; i++) {
+		name = names[i]
+		if (!(name in baseline)) {
+			printf "%-20s %12s %12.3f %9s\n", name, "-", results[name], "new"
+			continue
+		}
+		change = baseline[name] > 0 ? (results[name] - baseline[name])*100/baseline[name] : 0
+		flag = change > threshold ? "  REGRESSION" : ""
+		if (flag)
+			regressions++
+		printf "%-20s %12.3f %12.3f %+8.1f%%%s\n", name, baseline[name], results[name], change, flag
+	}
+	exit regressions > 0
+}' "$1" "$2"
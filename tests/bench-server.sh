@@ -0,0 +1,43 @@
+#!/bin/sh
+# Compares cold invocations of SciTECO against
+# invocations executed by a warm --server.
+#
+# Usage: bench-server.sh SCITECO [COUNT]
+
+if [ "$1" = "--loop" ]; then
+	count=$2
+	shift 2
+	i=0
+	while [ $i -lt $count ]; do
+		"$@" >/dev/null || exit 1
+		i=$((i+1))
+	done
+	exit 0
+fi
+
+SCITECO=$1
+COUNT=${2:-1000}
+SOCKET=${TMPDIR:-/tmp}/sciteco-bench-$$.sock
+MACRO='@I/Hello world/ J<.-Z;C> 0'
+
+"$SCITECO" --server="$SOCKET" &
+SERVER=$!
+trap 'kill $SERVER' EXIT
+
+i=0
+while [ ! -S "$SOCKET" ]; do
+	if [ $i -ge 50 ]; then
+		echo "Server did not start up" >&2
+		exit 1
+	fi
+	sleep 0.1
+	i=$((i+1))
+done
+
+echo "$COUNT cold invocations:"
+time ${SHELL:-/bin/sh} "$0" --loop "$COUNT" \
+	"$SCITECO" -e "$MACRO"
+
+echo "$COUNT warm invocations:"
+time ${SHELL:-/bin/sh} "$0" --loop "$COUNT" \
+	"$SCITECO" --client="$SOCKET" -e "$MACRO"
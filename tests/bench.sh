@@ -0,0 +1,156 @@
+#!/bin/sh
+# Performance regression benchmarks.
+# Synthetic input files are generated into a temporary directory
+# and representative operations are timed by SciTECO itself.
+# Every benchmark is run several times and the fastest run is reported.
+# The results (in milliseconds) are written as JSON, which can
+# be compared against a baseline with bench-compare.sh.
+#
+# Usage: bench.sh SCITECO [OUTPUT.json] [REPEAT]
+#
+# $SCITECOPATH defaults to the lib/ directory of the source tree.
+
+SCITECO=$1
+OUTPUT=${2:-bench.json}
+REPEAT=${3:-3}
+
+if [ ! -x "$SCITECO" ]; then
+	echo "Usage: $0 SCITECO [OUTPUT.json] [REPEAT]" >&2
+	exit 1
+fi
+case $OUTPUT in
+/*)	;;
+*)	OUTPUT=`pwd`/$OUTPUT;;
+esac
+case $SCITECO in
+/*)	;;
+*)	SCITECO=`pwd`/$SCITECO;;
+esac
+SCITECOPATH=${SCITECOPATH:-`dirname "$0"`/../lib}
+case $SCITECOPATH in
+/*)	;;
+*)	SCITECOPATH=`pwd`/$SCITECOPATH;;
+esac
+export SCITECOPATH
+
+WORKDIR=`mktemp -d "${TMPDIR:-/tmp}/sciteco-bench.XXXXXX"` || exit 1
+trap 'rm -rf "$WORKDIR"' EXIT
+cd "$WORKDIR" || exit 1
+
+#
+# Input generation
+#
+LINES=200000
+
+echo "Generating inputs in $WORKDIR..." >&2
+awk -v n=$LINES 'BEGIN {
+	for (i = 0; i < n; i++)
+		printf "line %d of the benchmark text with some words\n", i
+}' >lf.txt
+awk -v n=$LINES 'BEGIN {
+	for (i = 0; i < n; i++)
+		printf "line %d of the benchmark text with some words\r\n", i
+}' >crlf.txt
+awk -v n=$LINES 'BEGIN {
+	for (i = 0; i < n; i++)
+		printf "Zeile %d: \303\244\303\266\303\274 \316\261\316\262\316\263 \342\202\254\n", i
+}' >utf8.txt
+awk 'BEGIN {
+	for (i = 0; i < 100000; i++)
+		printf "long line %d, ", i
+	printf "\n"
+}' >long.txt
+i=0
+while [ $i -lt 5 ]; do
+	cat "$SCITECOPATH"/*.tes "$SCITECOPATH"/lexers/*.tes
+	i=$((i+1))
+done >lib.tes
+mkdir small
+i=0
+while [ $i -lt 1000 ]; do
+	echo "small file $i" >small/$i.txt
+	i=$((i+1))
+done
+# Command line with many insertions, rubouts and rubins (^G toggles rubin).
+KEYS=`awk 'BEGIN {
+	for (i = 0; i < 2000; i++) printf "x"
+	for (i = 0; i < 2000; i++) printf "%c", 8
+	printf "%c", 7
+	for (i = 0; i < 2000; i++) printf "%c", 8
+	printf "%c", 7
+}'`
+
+#
+# Benchmarks
+#
+# Every macro prints the number of microseconds spent
+# in the timed section.
+#
+RESULTS=
+
+# bench NAME ARGUMENT...
+bench()
+{
+	name=$1
+	shift
+	best=
+	n=0
+	while [ $n -lt $REPEAT ]; do
+		usecs=`"$SCITECO" --no-profile --quiet "$@" | tail -n 1`
+		case $usecs in
+		''|*[!0-9]*)
+			echo "Benchmark $name failed" >&2
+			exit 1;;
+		esac
+		if [ -z "$best" ] || [ $usecs -lt $best ]; then
+			best=$usecs
+		fi
+		n=$((n+1))
+	done
+
+	ms=`awk -v us=$best 'BEGIN {printf "%.3f", us/1000}'`
+	printf "%-20s %10s ms\n" "$name" "$ms" >&2
+	RESULTS="$RESULTS$name $ms
+"
+}
+
+bench load-lf -e '::^HU.s @EB/lf.txt/ ::^H-Q.s='
+bench load-crlf -e '::^HU.s @EB/crlf.txt/ ::^H-Q.s='
+bench load-utf8 -e '::^HU.s @EB/utf8.txt/ ::^H-Q.s='
+bench load-long-line -e '::^HU.s @EB/long.txt/ ::^H-Q.s='
+bench load-many -e '::^HU.s @EB/small/*.txt/ ::^H-Q.s='
+bench save-lf -e '@EB/lf.txt/ ::^HU.s @EW/saved.txt/ ::^H-Q.s='
+bench save-crlf -e '@EB/crlf.txt/ ::^HU.s @EW/saved.txt/ ::^H-Q.s='
+bench search-loop -e '@EB/lf.txt/ J ::^HU.s <:@S/words/;> ::^H-Q.s='
+bench search-utf8-loop -e '@EB/utf8.txt/ J ::^HU.s <:@S/€/;> ::^H-Q.s='
+bench replace-loop -e '@EB/lf.txt/ J ::^HU.s <:@FR/words/WORDS/;> ::^H-Q.s='
+bench ec-output -e '::^HU.s @EC/cat lf.txt/ ::^H-Q.s='
+bench ec-spawn -e '::^HU.s 100<@EC/true/> ::^H-Q.s='
+# A non-zero identifier enables the SciTECO lexer (see lib/lexers/sciteco.tes).
+# Fails unless the entire document has been styled.
+bench lex-tes -e '@EB/lib.tes/ 1@ES/SETIDENTIFIER//
+                  ::^HU.s @ES/CLEARDOCUMENTSTYLE// -1,0@ES/COLOURISE// ::^H-Q.sU.s
+                  @ES/GETENDSTYLED//-@ES/GETLENGTH//"<(0/0)'"'"' Q.s='
+bench cmdline-rubout --fake-cmdline "::^HU.s @I/$KEYS/ ::^H-Q.s="
+bench qreg-append -e '::^HU.s 100000<:@^U.a/x/> ::^H-Q.s='
+bench macro-calls -e '@^U.m{%.i} ::^HU.s 100000<M.m> ::^H-Q.s='
+bench startup -e "::^HU.s 20<@EC'$SCITECO --no-profile -e 0'> ::^H-Q.s/20="
+
+#
+# JSON output
+#
+{
+	echo "{"
+	printf '\t"sciteco": "%s",\n' "`"$SCITECO" --version | head -n 1`"
+	echo '	"unit": "ms",'
+	echo '	"results": {'
+	echo "$RESULTS" | awk 'NF == 2 {
+		if (line) print line ","
+		line = sprintf("\t\t\"%s\": %s", $1, $2)
+	}
+	END {if (line) print line}'
+	echo "	}"
+	echo "}"
+} >"$OUTPUT"
+
+echo "Results written to $OUTPUT" >&2